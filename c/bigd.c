@@ -0,0 +1,794 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bigd.c
+ * @brief provides an implementation of fixed-point decimal numbers on
+ * top of BigZ.
+ *
+ * Several conventions are used in the commentary:
+ * - A "BigD" is the name for an arbitrary-precision decimal number.
+ * - A BigD D is the value C * 10^-S where C, the coefficient, is a BigZ
+ *   and S, the scale, is the number of digits after the decimal point.
+ *
+ * Addition, subtraction and multiplication are exact: the result scale
+ * is the largest scale of the operands for the former two and the sum
+ * of the scales for the latter. Division and quantization take the
+ * scale of their result and a rounding mode. Powers of ten used to
+ * rescale coefficients come from a table built on first use.
+ *
+ * @note If any BigD parameter is passed as BDNULL, the behavior is
+ * undefined. Functions return BDNULL on error (out of memory, invalid
+ * operation).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(__BIGD_H)
+#include "./bigd.h"
+#endif
+
+/** @cond */
+#define BzFreeIf(cond, ptr)     if (cond) BzFree(ptr)
+
+/*
+ * Number of trailing zeros BdNormalize tries to remove at once.
+ */
+#define BD_STRIP_DIGITS         16
+/** @endcond */
+
+static BigZ             BdPow10(BigNumLength k);
+static BigZ             BdScaleUp(const BigZ c, BigNumLength k);
+static BigZ             BdRoundQuotient(const BigZ n, const BigZ d, BdRoundMode mode);
+static BigD             BdCreateInternal(BigZ c, BigNumLength scale);
+static BigD             BdAddSubtract(BigD a, BigD b, BigNumBool subtract);
+
+/*
+ * Powers of ten 10^0 .. 10^(BD_POW10_CACHE_SIZE - 1), filled on demand
+ * and kept until the program exits. Threads computing the same entry at
+ * the same time race to store it with a compare and swap, the losers
+ * free their copy. Compilers without atomic builtins fill the table
+ * without synchronization, which is only safe in a single thread.
+ */
+
+static BigZ BdPow10Table[BD_POW10_CACHE_SIZE];
+
+/** @cond */
+#if defined(__GNUC__) || defined(__clang__)
+#define BdPow10Load(k)                                                  \
+        __atomic_load_n(&BdPow10Table[k], __ATOMIC_ACQUIRE)
+#define BdPow10Store(k, p)                                              \
+        BdPow10CompareAndSwap(&BdPow10Table[k], p)
+
+/*
+ * Stores p in the empty slot, returns BN_FALSE if it is not empty.
+ */
+static BigNumBool
+BdPow10CompareAndSwap(BigZ *slot, BigZ p) {
+        BigZ expected = BZNULL;
+
+        return __atomic_compare_exchange_n(slot,
+                                           &expected,
+                                           p,
+                                           0,
+                                           __ATOMIC_ACQ_REL,
+                                           __ATOMIC_ACQUIRE)
+                ? BN_TRUE
+                : BN_FALSE;
+}
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define BdPow10Load(k)                                                  \
+        ((BigZ)_InterlockedCompareExchangePointer(                      \
+                (void * volatile *)&BdPow10Table[k], NULL, NULL))
+#define BdPow10Store(k, p)                                              \
+        ((_InterlockedCompareExchangePointer(                           \
+                (void * volatile *)&BdPow10Table[k], (p), NULL) == NULL) \
+                ? BN_TRUE : BN_FALSE)
+#else
+#define BdPow10Load(k)          BdPow10Table[k]
+#define BdPow10Store(k, p)      ((BdPow10Table[k] = (p)), BN_TRUE)
+#endif
+/** @endcond */
+
+/**
+ * BdPow10.
+ * Returns 10^k from the power table.
+ * @param [in] k BigNumLength
+ * @return BigZ owned by the table, BZNULL if out of memory.
+ * @pre k < BD_POW10_CACHE_SIZE
+ */
+static BigZ
+BdPow10(BigNumLength k) {
+        BigZ p = BdPow10Load(k);
+
+        if (p == BZNULL) {
+                const BigZ ten = BzFromInteger((BzInt)10);
+
+                if (ten == BZNULL) {
+                        return BZNULL;
+                }
+
+                p = BzPow(ten, (BzUInt)k);
+                BzFree(ten);
+
+                if (p == BZNULL) {
+                        return BZNULL;
+                }
+
+                if (BdPow10Store(k, p) == BN_FALSE) {
+                        /*
+                         * Another thread stored it first.
+                         */
+                        BzFree(p);
+                        p = BdPow10Load(k);
+                }
+        }
+
+        return p;
+}
+
+/**
+ * BdScaleUp.
+ * Returns C * 10^k.
+ * @param [in] c BigZ
+ * @param [in] k BigNumLength
+ * @return BigZ
+ */
+static BigZ
+BdScaleUp(const BigZ c, BigNumLength k) {
+        BigZ p;
+        BigZ res;
+
+        if ((k == 0) || (BzGetSign(c) == BZ_ZERO)) {
+                return BzCopy(c);
+        }
+
+        if (k < (BigNumLength)BD_POW10_CACHE_SIZE) {
+                if ((p = BdPow10(k)) == BZNULL) {
+                        return BZNULL;
+                }
+
+                return BzMultiply(c, p);
+        }
+
+        {
+                const BigZ ten = BzFromInteger((BzInt)10);
+
+                if (ten == BZNULL) {
+                        return BZNULL;
+                }
+
+                p = BzPow(ten, (BzUInt)k);
+                BzFree(ten);
+        }
+
+        if (p == BZNULL) {
+                return BZNULL;
+        }
+
+        res = BzMultiply(c, p);
+        BzFree(p);
+
+        return res;
+}
+
+/**
+ * BdRoundQuotient.
+ * Returns N / D rounded to an integer according to mode.
+ * @param [in] n BigZ
+ * @param [in] d BigZ
+ * @param [in] mode BdRoundMode
+ * @return BigZ
+ * @pre D > 0
+ */
+static BigZ
+BdRoundQuotient(const BigZ n, const BigZ d, BdRoundMode mode) {
+        BigNumBool inc = BN_FALSE;
+        BigZ       q;
+        BigZ       r;
+        BigZ       r2;
+        BzCmp      cmp;
+
+        /*
+         * BzDivide rounds toward negative infinity, R is >= 0.
+         */
+
+        if ((q = BzDivide(n, d, &r)) == BZNULL) {
+                return q;
+        }
+
+        if (BzGetSign(r) == BZ_ZERO) {
+                BzFree(r);
+                return q;
+        }
+
+        switch (mode) {
+        case BD_ROUND_FLOOR:
+                break;
+        case BD_ROUND_CEILING:
+                inc = BN_TRUE;
+                break;
+        case BD_ROUND_DOWN:
+                inc = (BzGetSign(n) == BZ_MINUS) ? BN_TRUE : BN_FALSE;
+                break;
+        case BD_ROUND_HALF_UP:
+        case BD_ROUND_HALF_EVEN:
+        default:
+                if ((r2 = BzAdd(r, r)) == BZNULL) {
+                        BzFree(q);
+                        BzFree(r);
+                        return BZNULL;
+                }
+
+                cmp = BzCompare(r2, d);
+                BzFree(r2);
+
+                if (cmp == BZ_GT) {
+                        inc = BN_TRUE;
+                } else if (cmp == BZ_EQ) {
+                        if (mode == BD_ROUND_HALF_UP) {
+                                inc = (BzGetSign(n) == BZ_PLUS)
+                                      ? BN_TRUE
+                                      : BN_FALSE;
+                        } else {
+                                inc = BzIsOdd(q);
+                        }
+                }
+                break;
+        }
+
+        BzFree(r);
+
+        if (inc == BN_TRUE) {
+                const BigZ one = BzFromInteger((BzInt)1);
+                BigZ       q1  = (one != BZNULL) ? BzAdd(q, one) : BZNULL;
+
+                BzFreeIf(one != BZNULL, one);
+                BzFree(q);
+                q = q1;
+        }
+
+        return q;
+}
+
+/**
+ * BdCreateInternal.
+ * Creates a BigD that takes ownership of its coefficient.
+ * @param [in] c BigZ, consumed by this function.
+ * @param [in] scale BigNumLength
+ * @return BigD
+ */
+static BigD
+BdCreateInternal(BigZ c, BigNumLength scale) {
+        BigDStruct *d;
+
+        if (c == BZNULL) {
+                return BDNULL;
+        }
+
+        if ((d = (BigDStruct *)BdAlloc()) == NULL) {
+                BzFree(c);
+                return BDNULL;
+        }
+
+        d->C     = c;
+        d->Scale = scale;
+
+        return d;
+}
+
+/**
+ * BdCreate.
+ * Creates the BigD C * 10^-scale.
+ * @param [in] c BigZ
+ * @param [in] scale BigNumLength
+ * @return BigD
+ */
+BigD
+BdCreate(const BigZ c, BigNumLength scale) {
+        return BdCreateInternal(BzCopy(c), scale);
+}
+
+/**
+ * BdFromString.
+ * Creates a BigD from a string of the form [+-]digits[.digits]. The
+ * scale is the number of digits after the point, trailing zeros
+ * included.
+ * @param [in] s BzChar string.
+ * @return BigD or BDNULL if s is not a valid number.
+ */
+BigD
+BdFromString(const BzChar *s) {
+        const BzChar *p = s;
+        BzChar       *digits;
+        size_t        nd = 0;
+        BigNumLength  scale = 0;
+        BigNumBool    negative = BN_FALSE;
+        BigZ          c;
+
+        if ((*p == (BzChar)'-') || (*p == (BzChar)'+')) {
+                negative = (*p == (BzChar)'-') ? BN_TRUE : BN_FALSE;
+                ++p;
+        }
+
+        if ((digits = BzStringAlloc(BzStrLen(p) + 1)) == NULL) {
+                return BDNULL;
+        }
+
+        while ((*p >= (BzChar)'0') && (*p <= (BzChar)'9')) {
+                digits[nd++] = *p++;
+        }
+
+        if (*p == (BzChar)'.') {
+                ++p;
+                while ((*p >= (BzChar)'0') && (*p <= (BzChar)'9')) {
+                        digits[nd++] = *p++;
+                        ++scale;
+                }
+        }
+
+        if ((nd == 0) || (*p != (BzChar)'\000')) {
+                BzFreeString(digits);
+                return BDNULL;
+        }
+
+        c = BzFromStringLen(digits, nd, (BigNumDigit)10, BZ_UNTIL_END);
+        BzFreeString(digits);
+
+        if ((c != BZNULL)
+            && (negative == BN_TRUE)
+            && (BzGetSign(c) != BZ_ZERO)) {
+                BzSetSign(c, BZ_MINUS);
+        }
+
+        return BdCreateInternal(c, scale);
+}
+
+/**
+ * BdToString.
+ * Returns D as a decimal string with exactly Scale digits after the
+ * point. Only the coefficient needs to be converted, the point is
+ * inserted in the result.
+ * @param [in] d BigD
+ * @return BzChar string allocated with BzStringAlloc.
+ */
+BzChar *
+BdToString(BigD d) {
+        const BigNumLength scale = BdGetScale(d);
+        BzChar            *cs;
+        BzChar            *res;
+        const BzChar      *ds;
+        size_t             nd;
+        size_t             len;
+        size_t             i;
+        size_t             j;
+        BigNumBool         negative;
+
+        if ((cs = BzToString(BdGetCoefficient(d), (BigNumDigit)10, 0)) == NULL) {
+                return NULL;
+        }
+
+        if (scale == 0) {
+                return cs;
+        }
+
+        negative = (cs[0] == (BzChar)'-') ? BN_TRUE : BN_FALSE;
+        ds       = (negative == BN_TRUE) ? cs + 1 : cs;
+        nd       = BzStrLen(ds);
+
+        /*
+         * sign + integer part (at least "0") + point + scale digits.
+         */
+
+        len = ((nd > (size_t)scale) ? nd : (size_t)scale + 1) + 3;
+
+        if ((res = BzStringAlloc(len)) == NULL) {
+                BzFreeString(cs);
+                return NULL;
+        }
+
+        i = 0;
+
+        if (negative == BN_TRUE) {
+                res[i++] = (BzChar)'-';
+        }
+
+        if (nd > (size_t)scale) {
+                for (j = 0; j < nd - (size_t)scale; ++j) {
+                        res[i++] = ds[j];
+                }
+                res[i++] = (BzChar)'.';
+                for (; j < nd; ++j) {
+                        res[i++] = ds[j];
+                }
+        } else {
+                res[i++] = (BzChar)'0';
+                res[i++] = (BzChar)'.';
+                for (j = nd; j < (size_t)scale; ++j) {
+                        res[i++] = (BzChar)'0';
+                }
+                for (j = 0; j < nd; ++j) {
+                        res[i++] = ds[j];
+                }
+        }
+
+        res[i] = (BzChar)'\000';
+        BzFreeString(cs);
+
+        return res;
+}
+
+/**
+ * BdToBigQ.
+ * Returns the exact value of a BigD as a BigQ.
+ * @param [in] d BigD
+ * @return BigQ
+ */
+BigQ
+BdToBigQ(BigD d) {
+        const BigZ one = BzFromInteger((BzInt)1);
+        BigZ       den;
+        BigQ       q;
+
+        if (one == BZNULL) {
+                return BQNULL;
+        }
+
+        den = BdScaleUp(one, BdGetScale(d));
+        BzFree(one);
+
+        if (den == BZNULL) {
+                return BQNULL;
+        }
+
+        q = BqCreate(BdGetCoefficient(d), den);
+        BzFree(den);
+
+        return q;
+}
+
+/**
+ * BdToDouble.
+ * Returns the double nearest to a BigD.
+ * @param [in] d BigD
+ * @return double
+ */
+double
+BdToDouble(BigD d) {
+        BigQ   q;
+        double x;
+
+        if (BdGetScale(d) == 0) {
+                return BzToDouble(BdGetCoefficient(d));
+        }
+
+        if ((q = BdToBigQ(d)) == BQNULL) {
+                return 0.0;
+        }
+
+        x = BqToDouble(q);
+        BqDelete(q);
+
+        return x;
+}
+
+/**
+ * BdDelete.
+ * Frees a BigD.
+ * @param [in] d BigD
+ */
+void
+BdDelete(BigD d) {
+        if (d != BDNULL) {
+                BzFree(BdGetCoefficient(d));
+                BdFree(d);
+        }
+}
+
+/**
+ * BdCompare.
+ * Compares two BigDs by value, whatever their scales.
+ * @param [in] a BigD
+ * @param [in] b BigD
+ * @return BD_LT, BD_EQ or BD_GT, BD_ERR if out of memory.
+ */
+BdCmp
+BdCompare(BigD a, BigD b) {
+        const BzSign sa = BdGetSign(a);
+        const BzSign sb = BdGetSign(b);
+        BigZ         x;
+        BzCmp        cmp;
+
+        if ((sa != sb) || (sa == BZ_ZERO)) {
+                return (sa < sb) ? BD_LT : ((sa > sb) ? BD_GT : BD_EQ);
+        }
+
+        if (BdGetScale(a) == BdGetScale(b)) {
+                return (BdCmp)BzCompare(BdGetCoefficient(a),
+                                        BdGetCoefficient(b));
+        }
+
+        if (BdGetScale(a) < BdGetScale(b)) {
+                x = BdScaleUp(BdGetCoefficient(a),
+                              BdGetScale(b) - BdGetScale(a));
+                if (x == BZNULL) {
+                        return BD_ERR;
+                }
+                cmp = BzCompare(x, BdGetCoefficient(b));
+        } else {
+                x = BdScaleUp(BdGetCoefficient(b),
+                              BdGetScale(a) - BdGetScale(b));
+                if (x == BZNULL) {
+                        return BD_ERR;
+                }
+                cmp = BzCompare(BdGetCoefficient(a), x);
+        }
+
+        BzFree(x);
+
+        return (BdCmp)cmp;
+}
+
+/**
+ * BdAbs.
+ * Returns |D|.
+ * @param [in] a BigD
+ * @return BigD
+ */
+BigD
+BdAbs(BigD a) {
+        return BdCreateInternal(BzAbs(BdGetCoefficient(a)), BdGetScale(a));
+}
+
+/**
+ * BdNegate.
+ * Returns -D.
+ * @param [in] a BigD
+ * @return BigD
+ */
+BigD
+BdNegate(BigD a) {
+        return BdCreateInternal(BzNegate(BdGetCoefficient(a)), BdGetScale(a));
+}
+
+/**
+ * BdAddSubtract.
+ * Returns A + B or A - B at the largest scale of A and B.
+ * @param [in] a BigD
+ * @param [in] b BigD
+ * @param [in] subtract BigNumBool
+ * @return BigD
+ */
+static BigD
+BdAddSubtract(BigD a, BigD b, BigNumBool subtract) {
+        BigNumLength scale;
+        BigZ         x;
+        BigZ         y;
+        BigZ         c;
+
+        if (BdGetScale(a) >= BdGetScale(b)) {
+                scale = BdGetScale(a);
+                x = BdGetCoefficient(a);
+                y = BdScaleUp(BdGetCoefficient(b), scale - BdGetScale(b));
+        } else {
+                scale = BdGetScale(b);
+                x = BdScaleUp(BdGetCoefficient(a), scale - BdGetScale(a));
+                y = BdGetCoefficient(b);
+        }
+
+        if ((x == BZNULL) || (y == BZNULL)) {
+                BzFreeIf((x != BZNULL) && (x != BdGetCoefficient(a)), x);
+                BzFreeIf((y != BZNULL) && (y != BdGetCoefficient(b)), y);
+                return BDNULL;
+        }
+
+        c = (subtract == BN_TRUE) ? BzSubtract(x, y) : BzAdd(x, y);
+
+        BzFreeIf(x != BdGetCoefficient(a), x);
+        BzFreeIf(y != BdGetCoefficient(b), y);
+
+        return BdCreateInternal(c, scale);
+}
+
+/**
+ * BdAdd.
+ * Returns A + B. The result scale is the largest scale of A and B.
+ * @param [in] a BigD
+ * @param [in] b BigD
+ * @return BigD
+ */
+BigD
+BdAdd(BigD a, BigD b) {
+        return BdAddSubtract(a, b, BN_FALSE);
+}
+
+/**
+ * BdSubtract.
+ * Returns A - B. The result scale is the largest scale of A and B.
+ * @param [in] a BigD
+ * @param [in] b BigD
+ * @return BigD
+ */
+BigD
+BdSubtract(BigD a, BigD b) {
+        return BdAddSubtract(a, b, BN_TRUE);
+}
+
+/**
+ * BdMultiply.
+ * Returns A * B. The result scale is the sum of the scales of A and B.
+ * @param [in] a BigD
+ * @param [in] b BigD
+ * @return BigD
+ */
+BigD
+BdMultiply(BigD a, BigD b) {
+        return BdCreateInternal(BzMultiply(BdGetCoefficient(a),
+                                           BdGetCoefficient(b)),
+                                BdGetScale(a) + BdGetScale(b));
+}
+
+/**
+ * BdDiv.
+ * Returns A / B rounded to scale digits after the point.
+ * @param [in] a BigD
+ * @param [in] b BigD
+ * @param [in] scale BigNumLength
+ * @param [in] mode BdRoundMode
+ * @return BigD or BDNULL if B is zero.
+ */
+BigD
+BdDiv(BigD a, BigD b, BigNumLength scale, BdRoundMode mode) {
+        BigZ n;
+        BigZ d;
+        BigZ c;
+
+        if (BdGetSign(b) == BZ_ZERO) {
+                return BDNULL;
+        }
+
+        /*
+         * C = round(Ca * 10^(scale + Sb - Sa) / Cb).
+         */
+
+        if ((scale + BdGetScale(b)) >= BdGetScale(a)) {
+                n = BdScaleUp(BdGetCoefficient(a),
+                              scale + BdGetScale(b) - BdGetScale(a));
+                d = BzAbs(BdGetCoefficient(b));
+        } else {
+                n = BzCopy(BdGetCoefficient(a));
+                d = BdScaleUp(BdGetCoefficient(b),
+                              BdGetScale(a) - scale - BdGetScale(b));
+                if (d != BZNULL) {
+                        BzSetSign(d, BZ_PLUS);
+                }
+        }
+
+        if ((n == BZNULL) || (d == BZNULL)) {
+                BzFreeIf(n != BZNULL, n);
+                BzFreeIf(d != BZNULL, d);
+                return BDNULL;
+        }
+
+        if ((BdGetSign(b) == BZ_MINUS) && (BzGetSign(n) != BZ_ZERO)) {
+                BzSetSign(n, (BzSign)-BzGetSign(n));
+        }
+
+        c = BdRoundQuotient(n, d, mode);
+
+        BzFree(n);
+        BzFree(d);
+
+        return BdCreateInternal(c, scale);
+}
+
+/**
+ * BdQuantize.
+ * Returns D rounded to scale digits after the point. Raising the scale
+ * is exact.
+ * @param [in] a BigD
+ * @param [in] scale BigNumLength
+ * @param [in] mode BdRoundMode
+ * @return BigD
+ */
+BigD
+BdQuantize(BigD a, BigNumLength scale, BdRoundMode mode) {
+        const BigZ one = BzFromInteger((BzInt)1);
+        BigZ       d;
+        BigZ       c;
+
+        if (scale >= BdGetScale(a)) {
+                BzFreeIf(one != BZNULL, one);
+                return BdCreateInternal(BdScaleUp(BdGetCoefficient(a),
+                                                  scale - BdGetScale(a)),
+                                        scale);
+        }
+
+        if (one == BZNULL) {
+                return BDNULL;
+        }
+
+        d = BdScaleUp(one, BdGetScale(a) - scale);
+        BzFree(one);
+
+        if (d == BZNULL) {
+                return BDNULL;
+        }
+
+        c = BdRoundQuotient(BdGetCoefficient(a), d, mode);
+        BzFree(d);
+
+        return BdCreateInternal(c, scale);
+}
+
+/**
+ * BdNormalize.
+ * Returns D with the trailing zeros of its fractional part removed,
+ * i.e. with the smallest scale that represents it exactly. Numbers
+ * that are equal have the same normalized form.
+ * @param [in] a BigD
+ * @return BigD
+ */
+BigD
+BdNormalize(BigD a) {
+        BigNumLength scale = BdGetScale(a);
+        BigNumLength k     = BD_STRIP_DIGITS;
+        BigZ         c;
+
+        if (BdGetSign(a) == BZ_ZERO) {
+                return BdCreate(BdGetCoefficient(a), 0);
+        }
+
+        if ((c = BzCopy(BdGetCoefficient(a))) == BZNULL) {
+                return BDNULL;
+        }
+
+        /*
+         * Remove BD_STRIP_DIGITS zeros at a time, then one at a time.
+         */
+
+        while (scale > 0) {
+                BigZ p;
+                BigZ q;
+                BigZ r;
+
+                if (k > scale) {
+                        k = scale;
+                }
+
+                if ((p = BdPow10(k)) == BZNULL) {
+                        BzFree(c);
+                        return BDNULL;
+                }
+
+                if ((q = BzDivide(c, p, &r)) == BZNULL) {
+                        BzFree(c);
+                        return BDNULL;
+                }
+
+                if (BzGetSign(r) != BZ_ZERO) {
+                        BzFree(q);
+                        BzFree(r);
+                        if (k == 1) {
+                                break;
+                        }
+                        k = 1;
+                        continue;
+                }
+
+                BzFree(r);
+                BzFree(c);
+                c = q;
+                scale -= k;
+        }
+
+        return BdCreateInternal(c, scale);
+}
@@ -0,0 +1,147 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bigd.h
+ * @brief Types and structures for clients of BigD.
+ */
+
+#if !defined(__BIGD_H)
+#define __BIGD_H
+
+#if !defined(__BIGZ_H)
+#include "./bigz.h"
+#endif
+
+#if !defined(__BIGQ_H)
+#include "./bigq.h"
+#endif
+
+#if defined(__cplusplus)
+extern  "C"     {
+#endif
+
+/** @cond */
+#define BD_PURE_FUNCTION                BN_PURE_FUNCTION
+/** @endcond */
+
+/**
+ * Number of powers of ten, starting at 10^0, kept by the power table.
+ */
+#define BD_POW10_CACHE_SIZE             128
+
+/**
+ * BigD compare result
+ */
+typedef enum {
+        /** Less than value (-1). */
+        BD_LT    = BN_LT,
+        /** Equal than == value (0). */
+        BD_EQ    = BN_EQ,
+        /** Greater than comparison value (1). */
+        BD_GT    = BN_GT,
+        /** Error */
+        BD_ERR   = 100
+} BdCmp;
+
+/**
+ * BigD rounding modes
+ */
+typedef enum {
+        /** To nearest, ties to even (banker's rounding). */
+        BD_ROUND_HALF_EVEN = 0,
+        /** To nearest, ties away from zero. */
+        BD_ROUND_HALF_UP   = 1,
+        /** Toward zero. */
+        BD_ROUND_DOWN      = 2,
+        /** Toward negative infinity. */
+        BD_ROUND_FLOOR     = 3,
+        /** Toward positive infinity. */
+        BD_ROUND_CEILING   = 4
+} BdRoundMode;
+
+/** @cond */
+/**
+ * BigD number is C * 10^-Scale where C, the coefficient, is a BigZ.
+ * The scale is the number of digits after the decimal point and is
+ * kept as is by BdFromString, so 1.50 and 1.5 are equal numbers with
+ * different scales.
+ */
+typedef struct {
+        /** coefficient, a signed BigZ. */
+        BigZ C;
+        /** number of decimal digits after the point. */
+        BigNumLength Scale;
+} BigDStruct;
+
+typedef BigDStruct *                    __BigD;
+
+#if !defined(BD_DECIMAL_TYPE)
+#define BD_DECIMAL_TYPE
+typedef const BigDStruct *              BigD;
+#endif
+/** @endcond */
+
+#if !defined(__EXTERNAL_BIGD_MEMORY)
+/**
+ * User overloadable macro that gets native BigD implementation from
+ * a high level object.
+ */
+#define __toBdObj(d)                    ((__BigD)d)
+/**
+ * NULL BigD.
+ */
+#define BDNULL                          ((BigD)0)
+/**
+ * User overloadable macro called to allocate a BigD.
+ */
+#define BdAlloc()                       malloc(sizeof(BigDStruct))
+/**
+ * User overloadable macro called to free a BigD allocated by BdAlloc.
+ */
+#define BdFree(d)                       free((void *)d)
+/**
+ * Get BigD coefficient.
+ */
+#define BdGetCoefficient(d)             (__toBdObj(d)->C)
+/**
+ * Get BigD scale.
+ */
+#define BdGetScale(d)                   (__toBdObj(d)->Scale)
+/**
+ * Get BigD sign.
+ */
+#define BdGetSign(d)                    BzGetSign(BdGetCoefficient(d))
+#endif
+
+/*
+ * functions of bigd.c
+ */
+
+extern BigD      BdCreate(const BigZ c, BigNumLength scale);
+extern BigD      BdFromString(const BzChar *s);
+extern BzChar *  BdToString(BigD d);
+extern BigQ      BdToBigQ(BigD d);
+extern double    BdToDouble(BigD d);
+extern void      BdDelete(BigD d);
+
+extern BdCmp     BdCompare(BigD a, BigD b);
+extern BigD      BdAbs(BigD a);
+extern BigD      BdAdd(BigD a, BigD b);
+extern BigD      BdDiv(BigD a, BigD b, BigNumLength scale, BdRoundMode mode);
+extern BigD      BdMultiply(BigD a, BigD b);
+extern BigD      BdNegate(BigD a);
+extern BigD      BdNormalize(BigD a);
+extern BigD      BdQuantize(BigD a, BigNumLength scale, BdRoundMode mode);
+extern BigD      BdSubtract(BigD a, BigD b);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  /* __BIGD_H */
@@ -0,0 +1,1360 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bigf.c
+ * @brief provides an implementation of arbitrary-precision binary
+ * floating-point numbers on top of BigZ.
+ *
+ * Several conventions are used in the commentary:
+ * - A "BigF" is the name for an arbitrary-precision binary float.
+ * - A BigF F is the value M * 2^E where M, the mantissa, is a BigZ
+ *   of at most P bits, P being the precision of F.
+ *
+ * Every operation computes its result as if with unbounded precision
+ * and then rounds it to P bits, ties to even. P is the precision of
+ * the operand or the largest precision of the two operands. Unlike
+ * BigQ, the size of a result never exceeds its precision, whatever
+ * the number of operations it went through.
+ *
+ * @note If any BigF parameter is passed as BFNULL, the behavior is
+ * undefined. Functions return BFNULL on error (out of memory, invalid
+ * operation).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#if !defined(__BIGF_H)
+#include "./bigf.h"
+#endif
+
+/** @cond */
+#define BzFreeIf(cond, ptr)     if (cond) BzFree(ptr)
+
+/*
+ * Extra bits kept below the precision by division and square root:
+ * one round bit and one guard bit, the rest goes to the sticky bit.
+ */
+#define BF_GUARD_BITS           2
+
+/*
+ * Largest decimal exponent accepted by BfFromString.
+ */
+#define BF_MAX_DECIMAL_EXPONENT 100000000L
+
+/*
+ * log10(2), used to size decimal conversions.
+ */
+#define BF_LOG10_2              0.30102999566398119521
+/** @endcond */
+
+static BigNumLength     BfBits(const BigZ z) BF_PURE_FUNCTION;
+static BigNumLength     BfTrailingZeros(const BigZ z) BF_PURE_FUNCTION;
+static BigNumBool       BfHasBitsBelow(const BigZ z, BigNumLength pos) BF_PURE_FUNCTION;
+static BigNumBool       BfTestBit(const BigZ z, BigNumLength pos) BF_PURE_FUNCTION;
+static BigZ             BfShift(const BigZ z, long n);
+static BigNumBool       BfAddExponents(long a, long b, long *e);
+static BigNumBool       BfSubtractExponents(long a, long b, long *e);
+static BigF             BfCreate(BigZ m, long e, BigNumLength prec, BigNumBool sticky);
+static BigF             BfAddSigned(BigF a, BigF b, BzSign bsign);
+static BigF             BfFromQuotient(const BigZ n, const BigZ d, long e, BigNumLength prec);
+static BigZ             BfRoundQuotient(const BigZ n, const BigZ d);
+static BigZ             BfDecimalDigits(BigF f, long t);
+
+/**
+ * BfBits.
+ * Returns the number of bits of |Z|.
+ * @param [in] z BigZ
+ * @return BigNumLength
+ */
+static BigNumLength
+BfBits(const BigZ z) {
+        return BnnNumLength(BzToBn(z), BzNumDigits(z));
+}
+
+/**
+ * BfTrailingZeros.
+ * Returns the number of trailing zero bits of |Z|.
+ * @param [in] z BigZ
+ * @return BigNumLength
+ * @pre Z != 0
+ */
+static BigNumLength
+BfTrailingZeros(const BigZ z) {
+        BigNumLength i = 0;
+        BigNumLength n = 0;
+        BigNumDigit  d;
+
+        while ((d = BzGetDigit(z, i)) == BN_ZERO) {
+                n += (BigNumLength)BN_DIGIT_SIZE;
+                ++i;
+        }
+
+        while ((d & BN_ONE) == BN_ZERO) {
+                d >>= 1;
+                ++n;
+        }
+
+        return n;
+}
+
+/**
+ * BfHasBitsBelow.
+ * Tests if any of the bits [0, pos) of |Z| is set.
+ * @param [in] z BigZ
+ * @param [in] pos BigNumLength bit position.
+ * @return BN_TRUE if one of those bits is set.
+ */
+static BigNumBool
+BfHasBitsBelow(const BigZ z, BigNumLength pos) {
+        BigNumLength zl  = BzNumDigits(z);
+        BigNumLength i   = pos / (BigNumLength)BN_DIGIT_SIZE;
+        BigNumLength off = pos % (BigNumLength)BN_DIGIT_SIZE;
+        BigNumLength d;
+
+        for (d = 0; (d < i) && (d < zl); ++d) {
+                if (BzGetDigit(z, d) != BN_ZERO) {
+                        return BN_TRUE;
+                }
+        }
+
+        if ((i < zl)
+            && (off != 0)
+            && ((BzGetDigit(z, i) & ((BN_ONE << off) - 1)) != BN_ZERO)) {
+                return BN_TRUE;
+        }
+
+        return BN_FALSE;
+}
+
+/**
+ * BfTestBit.
+ * Tests bit pos of |Z|.
+ * @param [in] z BigZ
+ * @param [in] pos BigNumLength bit position.
+ * @return BN_TRUE if the bit is set.
+ */
+static BigNumBool
+BfTestBit(const BigZ z, BigNumLength pos) {
+        BigNumLength i = pos / (BigNumLength)BN_DIGIT_SIZE;
+
+        if (i >= BzNumDigits(z)) {
+                return BN_FALSE;
+        }
+
+        return (((BzGetDigit(z, i) >> (pos % (BigNumLength)BN_DIGIT_SIZE))
+                 & BN_ONE) != BN_ZERO) ? BN_TRUE : BN_FALSE;
+}
+
+/**
+ * BfShift.
+ * Returns sign(Z) * |Z| * 2^n when n >= 0, sign(Z) * trunc(|Z| / 2^-n)
+ * otherwise. Unlike BzAsh, a right shift truncates the magnitude and
+ * both directions move whole digits before a single BnnShift pass.
+ * The result has a spare high digit so that it can be incremented in
+ * place.
+ * @param [in] z BigZ
+ * @param [in] n long shift count.
+ * @return BigZ
+ */
+static BigZ
+BfShift(const BigZ z, long n) {
+        const BigNumLength zl = BzNumDigits(z);
+        BigNumLength dn;
+        BigNumLength bn;
+        BigZ         res;
+
+        if (n >= 0) {
+                dn = (BigNumLength)((unsigned long)n / BN_DIGIT_SIZE);
+                bn = (BigNumLength)((unsigned long)n % BN_DIGIT_SIZE);
+
+                if ((res = BzCreate(zl + dn + 1)) == BZNULL) {
+                        return res;
+                }
+
+                BnnAssign(BzToBn(res) + dn, BzToBn(z), zl);
+                BzSetDigit(res,
+                           zl + dn,
+                           BnnShiftLeft(BzToBn(res) + dn, zl, bn));
+        } else {
+                dn = (BigNumLength)((unsigned long)-n / BN_DIGIT_SIZE);
+                bn = (BigNumLength)((unsigned long)-n % BN_DIGIT_SIZE);
+
+                if (dn >= zl) {
+                        return BzFromInteger((BzInt)0);
+                }
+
+                if ((res = BzCreate(zl - dn + 1)) == BZNULL) {
+                        return res;
+                }
+
+                BnnAssign(BzToBn(res), BzToBn(z) + dn, zl - dn);
+                (void)BnnShiftRight(BzToBn(res), zl - dn, bn);
+        }
+
+        if (BnnIsZero(BzToBn(res), BzGetSize(res)) == BN_TRUE) {
+                BzSetSign(res, BZ_ZERO);
+        } else {
+                BzSetSign(res, BzGetSign(z));
+        }
+
+        return res;
+}
+
+/**
+ * BfAddExponents.
+ * Computes a + b into e unless the sum overflows a long.
+ * @param [in] a long
+ * @param [in] b long
+ * @param [out] e long
+ * @return BN_TRUE if the sum fits, BN_FALSE otherwise.
+ */
+static BigNumBool
+BfAddExponents(long a, long b, long *e) {
+        if (((b > 0) && (a > LONG_MAX - b))
+            || ((b < 0) && (a < LONG_MIN - b))) {
+                return BN_FALSE;
+        }
+
+        *e = a + b;
+
+        return BN_TRUE;
+}
+
+/**
+ * BfSubtractExponents.
+ * Computes a - b into e unless the difference overflows a long.
+ * @param [in] a long
+ * @param [in] b long
+ * @param [out] e long
+ * @return BN_TRUE if the difference fits, BN_FALSE otherwise.
+ */
+static BigNumBool
+BfSubtractExponents(long a, long b, long *e) {
+        if (((b < 0) && (a > LONG_MAX + b))
+            || ((b > 0) && (a < LONG_MIN + b))) {
+                return BN_FALSE;
+        }
+
+        *e = a - b;
+
+        return BN_TRUE;
+}
+
+/**
+ * BfCreate.
+ * Creates the BigF nearest to M * 2^e with prec bits, ties to even.
+ * sticky tells that the exact value is a bit larger in magnitude than
+ * M * 2^e, which can only matter if M has more than prec bits.
+ * @param [in] m BigZ, consumed by this function.
+ * @param [in] e long exponent.
+ * @param [in] prec BigNumLength precision.
+ * @param [in] sticky BigNumBool
+ * @return BigF or BFNULL if the exponent overflows.
+ */
+static BigF
+BfCreate(BigZ m, long e, BigNumLength prec, BigNumBool sticky) {
+        BigFStruct  *f;
+        BigNumLength ml;
+
+        if (m == BZNULL) {
+                return BFNULL;
+        }
+
+        if (prec < BF_MIN_PRECISION) {
+                prec = BF_MIN_PRECISION;
+        }
+
+        if (BzGetSign(m) == BZ_ZERO) {
+                e = 0;
+        } else if ((ml = BfBits(m)) > prec) {
+                const BigNumLength k = ml - prec;
+                BigNumBool round = BfTestBit(m, k - 1);
+                BigZ       q;
+
+                if (BfHasBitsBelow(m, k - 1) == BN_TRUE) {
+                        sticky = BN_TRUE;
+                }
+
+                q = BfShift(m, -(long)k);
+                BzFree(m);
+
+                if (q == BZNULL) {
+                        return BFNULL;
+                }
+
+                if ((round == BN_TRUE)
+                    && ((sticky == BN_TRUE) || (BzIsOdd(q) == BN_TRUE))) {
+                        /*
+                         * BfShift left room for the carry.
+                         */
+                        (void)BnnAddCarry(BzToBn(q), BzGetSize(q), 1);
+                }
+
+                m = q;
+
+                if (BfAddExponents(e, (long)k, &e) == BN_FALSE) {
+                        BzFree(m);
+                        return BFNULL;
+                }
+        }
+
+        if (BzGetSign(m) != BZ_ZERO) {
+                const BigNumLength tz = BfTrailingZeros(m);
+
+                if (tz != 0) {
+                        BigZ q = BfShift(m, -(long)tz);
+
+                        BzFree(m);
+
+                        if ((m = q) == BZNULL) {
+                                return BFNULL;
+                        }
+
+                        if (BfAddExponents(e, (long)tz, &e) == BN_FALSE) {
+                                BzFree(m);
+                                return BFNULL;
+                        }
+                }
+        }
+
+        if ((f = (BigFStruct *)BfAlloc()) == NULL) {
+                BzFree(m);
+                return BFNULL;
+        }
+
+        f->M    = m;
+        f->E    = e;
+        f->Prec = prec;
+
+        return f;
+}
+
+/**
+ * BfFromMantissa.
+ * Creates the BigF nearest to M * 2^e, with prec bits.
+ * @param [in] m BigZ
+ * @param [in] e long
+ * @param [in] prec BigNumLength
+ * @return BigF
+ */
+BigF
+BfFromMantissa(const BigZ m, long e, BigNumLength prec) {
+        return BfCreate(BzCopy(m), e, prec, BN_FALSE);
+}
+
+/**
+ * BfFromBigZ.
+ * Creates a BigF from a BigZ, rounded to prec bits.
+ * @param [in] z BigZ
+ * @param [in] prec BigNumLength
+ * @return BigF
+ */
+BigF
+BfFromBigZ(const BigZ z, BigNumLength prec) {
+        return BfCreate(BzCopy(z), 0, prec, BN_FALSE);
+}
+
+/**
+ * BfFromQuotient.
+ * Creates the BigF nearest to (N / D) * 2^e with prec bits.
+ * @param [in] n BigZ
+ * @param [in] d BigZ
+ * @param [in] e long
+ * @param [in] prec BigNumLength
+ * @return BigF
+ * @pre D > 0
+ */
+static BigF
+BfFromQuotient(const BigZ n, const BigZ d, long e, BigNumLength prec) {
+        BigZ       num;
+        BigZ       q;
+        BigZ       r;
+        BigNumBool sticky;
+        long       s;
+
+        if (BzGetSign(n) == BZ_ZERO) {
+                return BfCreate(BzFromInteger((BzInt)0), 0, prec, BN_FALSE);
+        }
+
+        if (prec < BF_MIN_PRECISION) {
+                prec = BF_MIN_PRECISION;
+        }
+
+        /*
+         * Scale |N| so that the quotient has at least prec + 2 bits.
+         */
+
+        s = (long)prec + BF_GUARD_BITS + (long)BfBits(d) - (long)BfBits(n);
+
+        if (s < 0) {
+                s = 0;
+        }
+
+        if (BfSubtractExponents(e, s, &e) == BN_FALSE) {
+                return BFNULL;
+        }
+
+        if ((num = BfShift(n, s)) == BZNULL) {
+                return BFNULL;
+        }
+
+        BzSetSign(num, BZ_PLUS);
+
+        q = BzDivide(num, d, &r);
+        BzFree(num);
+
+        if (q == BZNULL) {
+                return BFNULL;
+        }
+
+        sticky = (BzGetSign(r) != BZ_ZERO) ? BN_TRUE : BN_FALSE;
+        BzFree(r);
+
+        if (BzGetSign(n) == BZ_MINUS) {
+                BzSetSign(q, BZ_MINUS);
+        }
+
+        return BfCreate(q, e, prec, sticky);
+}
+
+/**
+ * BfFromBigQ.
+ * Creates the BigF nearest to a BigQ, with prec bits.
+ * @param [in] q BigQ
+ * @param [in] prec BigNumLength
+ * @return BigF
+ */
+BigF
+BfFromBigQ(BigQ q, BigNumLength prec) {
+        return BfFromQuotient(BqGetNumerator(q), BqGetDenominator(q), 0, prec);
+}
+
+/**
+ * BfFromDouble.
+ * Creates a BigF from a double, rounded to prec bits.
+ * @param [in] x double
+ * @param [in] prec BigNumLength
+ * @return BigF or BFNULL if x is NaN or infinite.
+ */
+BigF
+BfFromDouble(double x, BigNumLength prec) {
+        BigZ   hi;
+        BigZ   lo;
+        BigZ   m;
+        double f;
+        double h;
+        int    e;
+
+        if ((x != x) || ((x != 0.0) && (x + x == x))) {
+                return BFNULL;
+        }
+
+        if (x == 0.0) {
+                return BfCreate(BzFromInteger((BzInt)0), 0, prec, BN_FALSE);
+        }
+
+        /*
+         * |x| = f * 2^e with 0.5 <= f < 1, so f * 2^64 is an integer
+         * split in two exact 32 bits halves.
+         */
+
+        f = frexp(fabs(x), &e);
+        h = floor(ldexp(f, 32));
+
+        hi = BzFromUnsignedInteger((BzUInt)h);
+        lo = BzFromUnsignedInteger((BzUInt)ldexp(ldexp(f, 32) - h, 32));
+
+        if ((hi == BZNULL) || (lo == BZNULL)) {
+                BzFreeIf(hi != BZNULL, hi);
+                BzFreeIf(lo != BZNULL, lo);
+                return BFNULL;
+        }
+
+        m = BfShift(hi, 32);
+        BzFree(hi);
+
+        if (m == BZNULL) {
+                BzFree(lo);
+                return BFNULL;
+        }
+
+        hi = BzAdd(m, lo);
+        BzFree(m);
+        BzFree(lo);
+
+        if ((hi != BZNULL) && (x < 0.0)) {
+                BzSetSign(hi, BZ_MINUS);
+        }
+
+        return BfCreate(hi, (long)e - 64, prec, BN_FALSE);
+}
+
+/**
+ * BfFromString.
+ * Creates the BigF nearest to a decimal string of the form
+ * [+-]digits[.digits][(e|E)[+-]digits], with prec bits.
+ * @param [in] s BzChar string.
+ * @param [in] prec BigNumLength
+ * @return BigF or BFNULL if s is not a valid number.
+ */
+BigF
+BfFromString(const BzChar *s, BigNumLength prec) {
+        const BzChar *p = s;
+        BzChar       *digits;
+        size_t        nd = 0;
+        long          exp10 = 0;
+        BigNumBool    negative = BN_FALSE;
+        BigZ          m;
+        BigZ          ten;
+        BigZ          pow10;
+        BigF          f;
+
+        if ((*p == (BzChar)'-') || (*p == (BzChar)'+')) {
+                negative = (*p == (BzChar)'-') ? BN_TRUE : BN_FALSE;
+                ++p;
+        }
+
+        if ((digits = BzStringAlloc(BzStrLen(p) + 1)) == NULL) {
+                return BFNULL;
+        }
+
+        while ((*p >= (BzChar)'0') && (*p <= (BzChar)'9')) {
+                digits[nd++] = *p++;
+        }
+
+        if (*p == (BzChar)'.') {
+                ++p;
+                while ((*p >= (BzChar)'0') && (*p <= (BzChar)'9')) {
+                        digits[nd++] = *p++;
+                        --exp10;
+                }
+        }
+
+        if (nd == 0) {
+                BzFreeString(digits);
+                return BFNULL;
+        }
+
+        if ((*p == (BzChar)'e') || (*p == (BzChar)'E')) {
+                BigNumBool eneg = BN_FALSE;
+                long       ev   = 0;
+
+                ++p;
+
+                if ((*p == (BzChar)'-') || (*p == (BzChar)'+')) {
+                        eneg = (*p == (BzChar)'-') ? BN_TRUE : BN_FALSE;
+                        ++p;
+                }
+
+                if ((*p < (BzChar)'0') || (*p > (BzChar)'9')) {
+                        BzFreeString(digits);
+                        return BFNULL;
+                }
+
+                while ((*p >= (BzChar)'0') && (*p <= (BzChar)'9')) {
+                        if (ev <= BF_MAX_DECIMAL_EXPONENT) {
+                                ev = ev * 10 + (long)(*p - (BzChar)'0');
+                        }
+                        ++p;
+                }
+
+                exp10 += (eneg == BN_TRUE) ? -ev : ev;
+        }
+
+        if ((*p != (BzChar)'\000')
+            || (exp10 > BF_MAX_DECIMAL_EXPONENT)
+            || (exp10 < -BF_MAX_DECIMAL_EXPONENT)) {
+                BzFreeString(digits);
+                return BFNULL;
+        }
+
+        m = BzFromStringLen(digits, nd, (BigNumDigit)10, BZ_UNTIL_END);
+        BzFreeString(digits);
+
+        if (m == BZNULL) {
+                return BFNULL;
+        }
+
+        if ((negative == BN_TRUE) && (BzGetSign(m) != BZ_ZERO)) {
+                BzSetSign(m, BZ_MINUS);
+        }
+
+        if ((exp10 == 0) || (BzGetSign(m) == BZ_ZERO)) {
+                return BfCreate(m, 0, prec, BN_FALSE);
+        }
+
+        ten   = BzFromInteger((BzInt)10);
+        pow10 = (ten != BZNULL)
+                ? BzPow(ten, (BzUInt)((exp10 > 0) ? exp10 : -exp10))
+                : BZNULL;
+        BzFreeIf(ten != BZNULL, ten);
+
+        if (pow10 == BZNULL) {
+                BzFree(m);
+                return BFNULL;
+        }
+
+        if (exp10 > 0) {
+                f = BfCreate(BzMultiply(m, pow10), 0, prec, BN_FALSE);
+        } else {
+                f = BfFromQuotient(m, pow10, 0, prec);
+        }
+
+        BzFree(pow10);
+        BzFree(m);
+
+        return f;
+}
+
+/**
+ * BfToBigQ.
+ * Returns the exact value of a BigF as a BigQ.
+ * @param [in] f BigF
+ * @return BigQ
+ */
+BigQ
+BfToBigQ(BigF f) {
+        const BigZ one = BzFromInteger((BzInt)1);
+        BigZ       n;
+        BigZ       d;
+        BigQ       q;
+
+        if (one == BZNULL) {
+                return BQNULL;
+        }
+
+        if (BfGetExponent(f) >= 0) {
+                n = BfShift(BfGetMantissa(f), BfGetExponent(f));
+                d = BzCopy(one);
+        } else {
+                n = BzCopy(BfGetMantissa(f));
+                d = BfShift(one, -BfGetExponent(f));
+        }
+
+        BzFree(one);
+
+        if ((n == BZNULL) || (d == BZNULL)) {
+                BzFreeIf(n != BZNULL, n);
+                BzFreeIf(d != BZNULL, d);
+                return BQNULL;
+        }
+
+        q = BqCreate(n, d);
+
+        BzFree(n);
+        BzFree(d);
+
+        return q;
+}
+
+/**
+ * BfToDouble.
+ * Returns the double nearest to a BigF.
+ * @param [in] f BigF
+ * @return double
+ */
+double
+BfToDouble(BigF f) {
+        return BzToDoubleScaled(BfGetMantissa(f), BfGetExponent(f), BN_FALSE);
+}
+
+/**
+ * BfRoundQuotient.
+ * Returns N / D rounded to the nearest integer, ties to even.
+ * @param [in] n BigZ
+ * @param [in] d BigZ
+ * @return BigZ
+ * @pre N >= 0 and D > 0
+ */
+static BigZ
+BfRoundQuotient(const BigZ n, const BigZ d) {
+        BigZ  q;
+        BigZ  r;
+        BigZ  r2;
+        BzCmp cmp;
+
+        if ((q = BzDivide(n, d, &r)) == BZNULL) {
+                return q;
+        }
+
+        if ((r2 = BfShift(r, 1)) == BZNULL) {
+                BzFree(q);
+                BzFree(r);
+                return BZNULL;
+        }
+
+        cmp = BzCompare(r2, d);
+
+        BzFree(r2);
+        BzFree(r);
+
+        if ((cmp == BZ_GT) || ((cmp == BZ_EQ) && (BzIsOdd(q) == BN_TRUE))) {
+                const BigZ one = BzFromInteger((BzInt)1);
+                BigZ       q1  = (one != BZNULL) ? BzAdd(q, one) : BZNULL;
+
+                BzFreeIf(one != BZNULL, one);
+                BzFree(q);
+                q = q1;
+        }
+
+        return q;
+}
+
+/**
+ * BfDecimalDigits.
+ * Returns |F| * 10^t rounded to the nearest integer, ties to even.
+ * @param [in] f BigF
+ * @param [in] t long
+ * @return BigZ
+ */
+static BigZ
+BfDecimalDigits(BigF f, long t) {
+        const BigZ ten = BzFromInteger((BzInt)10);
+        const BigZ one = BzFromInteger((BzInt)1);
+        BigZ       p;
+        BigZ       n;
+        BigZ       d;
+        BigZ       tmp;
+        BigZ       res = BZNULL;
+
+        if ((ten == BZNULL) || (one == BZNULL)) {
+                BzFreeIf(ten != BZNULL, ten);
+                BzFreeIf(one != BZNULL, one);
+                return BZNULL;
+        }
+
+        p = BzPow(ten, (BzUInt)((t >= 0) ? t : -t));
+        BzFree(ten);
+
+        if (BfGetExponent(f) >= 0) {
+                n = BfShift(BfGetMantissa(f), BfGetExponent(f));
+                d = BzCopy(one);
+        } else {
+                n = BzCopy(BfGetMantissa(f));
+                d = BfShift(one, -BfGetExponent(f));
+        }
+
+        BzFree(one);
+
+        if ((p != BZNULL) && (n != BZNULL) && (d != BZNULL)) {
+                if (t >= 0) {
+                        tmp = BzMultiply(n, p);
+                        BzFree(n);
+                        n = tmp;
+                } else {
+                        tmp = BzMultiply(d, p);
+                        BzFree(d);
+                        d = tmp;
+                }
+
+                if ((n != BZNULL) && (d != BZNULL)) {
+                        BzSetSign(n, BZ_PLUS);
+                        res = BfRoundQuotient(n, d);
+                }
+        }
+
+        BzFreeIf(p != BZNULL, p);
+        BzFreeIf(n != BZNULL, n);
+        BzFreeIf(d != BZNULL, d);
+
+        return res;
+}
+
+/**
+ * BfToString.
+ * Returns F as a decimal string rounded to digits significant digits,
+ * ties to even. Trailing zeros are removed. Numbers whose decimal
+ * exponent lies in [-5, digits) are written in positional notation,
+ * other numbers in scientific notation. When digits is 0, the number
+ * of digits is enough to tell F from its neighbours at its precision.
+ * @param [in] f BigF
+ * @param [in] digits BigNumLength
+ * @return BzChar string allocated with BzStringAlloc.
+ */
+BzChar *
+BfToString(BigF f, BigNumLength digits) {
+        BzChar      *res;
+        BzChar      *ds;
+        BigZ         n;
+        BigZ         lo;
+        BigZ         hi;
+        BigZ         ten;
+        long         k;
+        long         nd;
+        size_t       len;
+        size_t       i;
+        BzCmp        cmp;
+
+        if (BfGetSign(f) == BZ_ZERO) {
+                if ((res = BzStringAlloc(2)) != NULL) {
+                        res[0] = (BzChar)'0';
+                        res[1] = (BzChar)'\000';
+                }
+                return res;
+        }
+
+        if (digits == 0) {
+                digits = (BigNumLength)ceil((double)BfGetPrecision(f)
+                                            * BF_LOG10_2) + 1;
+        }
+
+        /*
+         * Estimate k = floor(log10(|F|)), then fix it once the digits
+         * are known: the estimate is off by at most one.
+         */
+
+        k = (long)floor(((double)BfGetExponent(f)
+                         + (double)BfBits(BfGetMantissa(f)) - 1.0)
+                        * BF_LOG10_2);
+
+        if ((ten = BzFromInteger((BzInt)10)) == BZNULL) {
+                return NULL;
+        }
+
+        lo = BzPow(ten, (BzUInt)(digits - 1));
+        hi = BzPow(ten, (BzUInt)digits);
+        BzFree(ten);
+        n  = BZNULL;
+
+        if ((lo != BZNULL) && (hi != BZNULL)) {
+                int tries;
+
+                for (tries = 0; tries < 3; ++tries) {
+                        n = BfDecimalDigits(f, (long)digits - 1 - k);
+
+                        if (n == BZNULL) {
+                                break;
+                        }
+
+                        if ((cmp = BzCompare(n, hi)) != BZ_LT) {
+                                ++k;
+                        } else if (BzCompare(n, lo) == BZ_LT) {
+                                --k;
+                        } else {
+                                break;
+                        }
+
+                        BzFree(n);
+                        n = BZNULL;
+                }
+        }
+
+        BzFreeIf(lo != BZNULL, lo);
+        BzFreeIf(hi != BZNULL, hi);
+
+        if (n == BZNULL) {
+                return NULL;
+        }
+
+        ds = BzToString(n, (BigNumDigit)10, 0);
+        BzFree(n);
+
+        if (ds == NULL) {
+                return NULL;
+        }
+
+        /*
+         * Remove trailing zeros.
+         */
+
+        nd = (long)BzStrLen(ds);
+
+        while ((nd > 1) && (ds[nd - 1] == (BzChar)'0')) {
+                --nd;
+        }
+
+        /*
+         * sign + digits + "0." + 5 leading zeros + "e-" + exponent.
+         */
+
+        len = (size_t)nd + (size_t)(k < 0 ? -k : k) + 32;
+
+        if ((res = BzStringAlloc(len)) == NULL) {
+                BzFreeString(ds);
+                return NULL;
+        }
+
+        i = 0;
+
+        if (BfGetSign(f) == BZ_MINUS) {
+                res[i++] = (BzChar)'-';
+        }
+
+        if ((k >= -5) && (k < (long)digits)) {
+                long j;
+
+                if (k < 0) {
+                        res[i++] = (BzChar)'0';
+                        res[i++] = (BzChar)'.';
+                        for (j = -1; j > k; --j) {
+                                res[i++] = (BzChar)'0';
+                        }
+                        for (j = 0; j < nd; ++j) {
+                                res[i++] = ds[j];
+                        }
+                } else {
+                        for (j = 0; j <= k; ++j) {
+                                res[i++] = (j < nd) ? ds[j] : (BzChar)'0';
+                        }
+                        if (nd > k + 1) {
+                                res[i++] = (BzChar)'.';
+                                for (j = k + 1; j < nd; ++j) {
+                                        res[i++] = ds[j];
+                                }
+                        }
+                }
+
+                res[i] = (BzChar)'\000';
+        } else {
+                long j;
+
+                res[i++] = ds[0];
+
+                if (nd > 1) {
+                        res[i++] = (BzChar)'.';
+                        for (j = 1; j < nd; ++j) {
+                                res[i++] = ds[j];
+                        }
+                }
+
+                (void)sprintf((char *)&res[i], "e%+ld", k);
+        }
+
+        BzFreeString(ds);
+
+        return res;
+}
+
+/**
+ * BfRound.
+ * Returns F rounded to prec bits. The result has precision prec.
+ * @param [in] f BigF
+ * @param [in] prec BigNumLength
+ * @return BigF
+ */
+BigF
+BfRound(BigF f, BigNumLength prec) {
+        return BfCreate(BzCopy(BfGetMantissa(f)),
+                        BfGetExponent(f),
+                        prec,
+                        BN_FALSE);
+}
+
+/**
+ * BfDelete.
+ * Frees a BigF.
+ * @param [in] f BigF
+ */
+void
+BfDelete(BigF f) {
+        if (f != BFNULL) {
+                BzFree(BfGetMantissa(f));
+                BfFree(f);
+        }
+}
+
+/**
+ * BfCompare.
+ * Compares two BigFs.
+ * @param [in] a BigF
+ * @param [in] b BigF
+ * @return BF_LT, BF_EQ or BF_GT, BF_ERR if out of memory.
+ */
+BfCmp
+BfCompare(BigF a, BigF b) {
+        const BzSign sa = BfGetSign(a);
+        const BzSign sb = BfGetSign(b);
+        long         ta;
+        long         tb;
+        BigZ         x;
+        BzCmp        cmp;
+
+        if (sa != sb) {
+                return (sa < sb) ? BF_LT : BF_GT;
+        }
+
+        if (sa == BZ_ZERO) {
+                return BF_EQ;
+        }
+
+        /*
+         * Same sign: the position of the highest bit decides, unless
+         * it is the same for both.
+         */
+
+        ta = BfGetExponent(a) + (long)BfBits(BfGetMantissa(a));
+        tb = BfGetExponent(b) + (long)BfBits(BfGetMantissa(b));
+
+        if (ta != tb) {
+                if (sa == BZ_PLUS) {
+                        return (ta < tb) ? BF_LT : BF_GT;
+                } else {
+                        return (ta < tb) ? BF_GT : BF_LT;
+                }
+        }
+
+        if (BfGetExponent(a) >= BfGetExponent(b)) {
+                x = BfShift(BfGetMantissa(a),
+                            BfGetExponent(a) - BfGetExponent(b));
+                if (x == BZNULL) {
+                        return BF_ERR;
+                }
+                cmp = BzCompare(x, BfGetMantissa(b));
+        } else {
+                x = BfShift(BfGetMantissa(b),
+                            BfGetExponent(b) - BfGetExponent(a));
+                if (x == BZNULL) {
+                        return BF_ERR;
+                }
+                cmp = BzCompare(BfGetMantissa(a), x);
+        }
+
+        BzFree(x);
+
+        return (BfCmp)cmp;
+}
+
+/**
+ * BfAbs.
+ * Returns |F|.
+ * @param [in] a BigF
+ * @return BigF
+ */
+BigF
+BfAbs(BigF a) {
+        BigZ m = BzAbs(BfGetMantissa(a));
+
+        return BfCreate(m, BfGetExponent(a), BfGetPrecision(a), BN_FALSE);
+}
+
+/**
+ * BfNegate.
+ * Returns -F.
+ * @param [in] a BigF
+ * @return BigF
+ */
+BigF
+BfNegate(BigF a) {
+        BigZ m = BzNegate(BfGetMantissa(a));
+
+        return BfCreate(m, BfGetExponent(a), BfGetPrecision(a), BN_FALSE);
+}
+
+/**
+ * BfAddSigned.
+ * Returns A + bsign * |B| * sign(B), rounded.
+ * @param [in] a BigF
+ * @param [in] b BigF
+ * @param [in] bsign BZ_PLUS to add, BZ_MINUS to subtract.
+ * @return BigF
+ */
+static BigF
+BfAddSigned(BigF a, BigF b, BzSign bsign) {
+        const BigNumLength prec = (BfGetPrecision(a) > BfGetPrecision(b))
+                                  ? BfGetPrecision(a)
+                                  : BfGetPrecision(b);
+        BigNumLength la;
+        BigNumLength lb;
+        long         ta;
+        long         tb;
+        BzSign       sb;
+        BigZ         x;
+        BigZ         y;
+        BigZ         m;
+        BigNumBool   swap = BN_FALSE;
+
+        if (BfGetSign(b) == BZ_ZERO) {
+                return BfCreate(BzCopy(BfGetMantissa(a)),
+                                BfGetExponent(a),
+                                prec,
+                                BN_FALSE);
+        }
+
+        if (BfGetSign(a) == BZ_ZERO) {
+                m = (bsign == BZ_PLUS)
+                    ? BzCopy(BfGetMantissa(b))
+                    : BzNegate(BfGetMantissa(b));
+                return BfCreate(m, BfGetExponent(b), prec, BN_FALSE);
+        }
+
+        la = BfBits(BfGetMantissa(a));
+        lb = BfBits(BfGetMantissa(b));
+        ta = BfGetExponent(a) + (long)la;
+        tb = BfGetExponent(b) + (long)lb;
+
+        if (tb > ta) {
+                /*
+                 * Make A the operand of largest magnitude.
+                 */
+
+                BigF         tf = a;
+                BigNumLength tl = la;
+                long         tt = ta;
+
+                a  = b;
+                b  = tf;
+                la = lb;
+                lb = tl;
+                ta = tb;
+                tb = tt;
+                swap = BN_TRUE;
+        }
+
+        /*
+         * sb is the sign of the term B adds, only a subtracted B that
+         * was not swapped has its sign flipped.
+         */
+
+        sb = BfGetSign(b);
+
+        if ((swap == BN_FALSE) && (bsign == BZ_MINUS)) {
+                sb = (BzSign)-sb;
+        }
+
+        if (tb < ta - (long)prec - 3) {
+                /*
+                 * |B| is smaller than one unit of A' = A * 2^k where A'
+                 * has prec + 3 bits: A + B lies strictly between A' and
+                 * A' + sign(B) units, on the same side of any rounding
+                 * boundary as A' + sign(B) / 2. Round 2A' + sign(B) with
+                 * the sticky bit set instead of aligning B bit by bit.
+                 */
+
+                long k = (long)prec + 3 - (long)la;
+
+                if (k < 0) {
+                        k = 0;
+                }
+
+                if ((x = BfShift(BfGetMantissa(a), k + 1)) == BZNULL) {
+                        return BFNULL;
+                }
+
+                if ((swap == BN_TRUE) && (bsign == BZ_MINUS)) {
+                        BzSetSign(x, (BzSign)-BzGetSign(x));
+                }
+
+                if ((y = BzFromInteger((BzInt)sb)) == BZNULL) {
+                        BzFree(x);
+                        return BFNULL;
+                }
+
+                m = BzAdd(x, y);
+
+                BzFree(x);
+                BzFree(y);
+
+                return BfCreate(m, BfGetExponent(a) - k - 1, prec, BN_TRUE);
+        }
+
+        /*
+         * Operands overlap, or nearly so: align them exactly.
+         */
+
+        if (BfGetExponent(a) >= BfGetExponent(b)) {
+                x = BfShift(BfGetMantissa(a),
+                            BfGetExponent(a) - BfGetExponent(b));
+                y = BzCopy(BfGetMantissa(b));
+                ta = BfGetExponent(b);
+        } else {
+                x = BzCopy(BfGetMantissa(a));
+                y = BfShift(BfGetMantissa(b),
+                            BfGetExponent(b) - BfGetExponent(a));
+                ta = BfGetExponent(a);
+        }
+
+        if ((x == BZNULL) || (y == BZNULL)) {
+                BzFreeIf(x != BZNULL, x);
+                BzFreeIf(y != BZNULL, y);
+                return BFNULL;
+        }
+
+        /*
+         * x holds A, y holds B; the sign of the subtracted operand is
+         * flipped whichever side it ended on.
+         */
+
+        if (bsign == BZ_MINUS) {
+                if (swap == BN_TRUE) {
+                        BzSetSign(x, (BzSign)-BzGetSign(x));
+                } else {
+                        BzSetSign(y, (BzSign)-BzGetSign(y));
+                }
+        }
+
+        m = BzAdd(x, y);
+
+        BzFree(x);
+        BzFree(y);
+
+        return BfCreate(m, ta, prec, BN_FALSE);
+}
+
+/**
+ * BfAdd.
+ * Returns A + B, rounded.
+ * @param [in] a BigF
+ * @param [in] b BigF
+ * @return BigF
+ */
+BigF
+BfAdd(BigF a, BigF b) {
+        return BfAddSigned(a, b, BZ_PLUS);
+}
+
+/**
+ * BfSubtract.
+ * Returns A - B, rounded.
+ * @param [in] a BigF
+ * @param [in] b BigF
+ * @return BigF
+ */
+BigF
+BfSubtract(BigF a, BigF b) {
+        return BfAddSigned(a, b, BZ_MINUS);
+}
+
+/**
+ * BfMultiply.
+ * Returns A * B, rounded.
+ * @param [in] a BigF
+ * @param [in] b BigF
+ * @return BigF or BFNULL if the exponent overflows.
+ */
+BigF
+BfMultiply(BigF a, BigF b) {
+        const BigNumLength prec = (BfGetPrecision(a) > BfGetPrecision(b))
+                                  ? BfGetPrecision(a)
+                                  : BfGetPrecision(b);
+        long e;
+
+        if (BfAddExponents(BfGetExponent(a), BfGetExponent(b), &e)
+            == BN_FALSE) {
+                return BFNULL;
+        }
+
+        return BfCreate(BzMultiply(BfGetMantissa(a), BfGetMantissa(b)),
+                        e,
+                        prec,
+                        BN_FALSE);
+}
+
+/**
+ * BfDiv.
+ * Returns A / B, rounded.
+ * @param [in] a BigF
+ * @param [in] b BigF
+ * @return BigF or BFNULL if B is zero or the exponent overflows.
+ */
+BigF
+BfDiv(BigF a, BigF b) {
+        const BigNumLength prec = (BfGetPrecision(a) > BfGetPrecision(b))
+                                  ? BfGetPrecision(a)
+                                  : BfGetPrecision(b);
+        BigZ d;
+        BigF f;
+        long e;
+
+        if (BfGetSign(b) == BZ_ZERO) {
+                return BFNULL;
+        }
+
+        if (BfSubtractExponents(BfGetExponent(a), BfGetExponent(b), &e)
+            == BN_FALSE) {
+                return BFNULL;
+        }
+
+        if ((d = BzAbs(BfGetMantissa(b))) == BZNULL) {
+                return BFNULL;
+        }
+
+        f = BfFromQuotient(BfGetMantissa(a),
+                           d,
+                           e,
+                           prec);
+
+        BzFree(d);
+
+        if ((f != BFNULL) && (BfGetSign(b) == BZ_MINUS)) {
+                BigZ m = BfGetMantissa(f);
+
+                BzSetSign(m, (BzSign)-BzGetSign(m));
+        }
+
+        return f;
+}
+
+/**
+ * BfSqrt.
+ * Returns sqrt(A), rounded.
+ * @param [in] a BigF
+ * @return BigF or BFNULL if A is negative.
+ */
+BigF
+BfSqrt(BigF a) {
+        const BigNumLength prec = BfGetPrecision(a);
+        BigZ       m;
+        BigZ       r;
+        BigZ       r2;
+        BigNumBool sticky;
+        long       s;
+        long       e;
+
+        switch (BfGetSign(a)) {
+        case BZ_MINUS:
+                return BFNULL;
+        case BZ_ZERO:
+                return BfCreate(BzFromInteger((BzInt)0), 0, prec, BN_FALSE);
+        default:
+                break;
+        }
+
+        /*
+         * Scale M so that its root has at least prec + 2 bits and the
+         * exponent left is even.
+         */
+
+        s = 2 * ((long)prec + BF_GUARD_BITS) - (long)BfBits(BfGetMantissa(a));
+
+        if (s < 0) {
+                s = 0;
+        }
+
+        if (((BfGetExponent(a) - s) & 1) != 0) {
+                ++s;
+        }
+
+        e = (BfGetExponent(a) - s) / 2;
+
+        if ((m = BfShift(BfGetMantissa(a), s)) == BZNULL) {
+                return BFNULL;
+        }
+
+        if ((r = BzSqrt(m)) == BZNULL) {
+                BzFree(m);
+                return BFNULL;
+        }
+
+        if ((r2 = BzMultiply(r, r)) == BZNULL) {
+                BzFree(m);
+                BzFree(r);
+                return BFNULL;
+        }
+
+        sticky = (BzCompare(r2, m) != BZ_EQ) ? BN_TRUE : BN_FALSE;
+
+        BzFree(r2);
+        BzFree(m);
+
+        return BfCreate(r, e, prec, sticky);
+}
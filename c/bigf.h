@@ -0,0 +1,139 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bigf.h
+ * @brief Types and structures for clients of BigF.
+ */
+
+#if !defined(__BIGF_H)
+#define __BIGF_H
+
+#if !defined(__BIGZ_H)
+#include "./bigz.h"
+#endif
+
+#if !defined(__BIGQ_H)
+#include "./bigq.h"
+#endif
+
+#if defined(__cplusplus)
+extern  "C"     {
+#endif
+
+/** @cond */
+#define BF_PURE_FUNCTION                BN_PURE_FUNCTION
+/** @endcond */
+
+/**
+ * Smallest BigF precision, in bits.
+ */
+#define BF_MIN_PRECISION                ((BigNumLength)2)
+
+/**
+ * BigF compare result
+ */
+typedef enum {
+        /** Less than value (-1). */
+        BF_LT    = BN_LT,
+        /** Equal than == value (0). */
+        BF_EQ    = BN_EQ,
+        /** Greater than comparison value (1). */
+        BF_GT    = BN_GT,
+        /** Error */
+        BF_ERR   = 100
+} BfCmp;
+
+/** @cond */
+/**
+ * BigF number is M * 2^E where M is a BigZ of at most Prec bits.
+ * M is odd, or M is 0 and E is 0, so each value has a single
+ * representation for a given precision.
+ */
+typedef struct {
+        /** mantissa, a signed BigZ. */
+        BigZ M;
+        /** binary exponent. */
+        long E;
+        /** precision, in bits. */
+        BigNumLength Prec;
+} BigFStruct;
+
+typedef BigFStruct *                    __BigF;
+
+#if !defined(BF_FLOAT_TYPE)
+#define BF_FLOAT_TYPE
+typedef const BigFStruct *              BigF;
+#endif
+/** @endcond */
+
+#if !defined(__EXTERNAL_BIGF_MEMORY)
+/**
+ * User overloadable macro that gets native BigF implementation from
+ * a high level object.
+ */
+#define __toBfObj(f)                    ((__BigF)f)
+/**
+ * NULL BigF.
+ */
+#define BFNULL                          ((BigF)0)
+/**
+ * User overloadable macro called to allocate a BigF.
+ */
+#define BfAlloc()                       malloc(sizeof(BigFStruct))
+/**
+ * User overloadable macro called to free a BigF allocated by BfAlloc.
+ */
+#define BfFree(f)                       free((void *)f)
+/**
+ * Get BigF mantissa.
+ */
+#define BfGetMantissa(f)                (__toBfObj(f)->M)
+/**
+ * Get BigF exponent.
+ */
+#define BfGetExponent(f)                (__toBfObj(f)->E)
+/**
+ * Get BigF precision.
+ */
+#define BfGetPrecision(f)               (__toBfObj(f)->Prec)
+/**
+ * Get BigF sign.
+ */
+#define BfGetSign(f)                    BzGetSign(BfGetMantissa(f))
+#endif
+
+/*
+ * functions of bigf.c
+ */
+
+extern BigF      BfFromMantissa(const BigZ m, long e, BigNumLength prec);
+extern BigF      BfFromBigZ(const BigZ z, BigNumLength prec);
+extern BigF      BfFromBigQ(BigQ q, BigNumLength prec);
+extern BigF      BfFromDouble(double x, BigNumLength prec);
+extern BigF      BfFromString(const BzChar *s, BigNumLength prec);
+extern BigQ      BfToBigQ(BigF f);
+extern double    BfToDouble(BigF f);
+extern BzChar *  BfToString(BigF f, BigNumLength digits);
+extern BigF      BfRound(BigF f, BigNumLength prec);
+extern void      BfDelete(BigF f);
+
+extern BfCmp     BfCompare(BigF a, BigF b) BF_PURE_FUNCTION;
+extern BigF      BfAbs(BigF a);
+extern BigF      BfAdd(BigF a, BigF b);
+extern BigF      BfDiv(BigF a, BigF b);
+extern BigF      BfMultiply(BigF a, BigF b);
+extern BigF      BfNegate(BigF a);
+extern BigF      BfSqrt(BigF a);
+extern BigF      BfSubtract(BigF a, BigF b);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  /* __BIGF_H */
@@ -0,0 +1,824 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bigm.c
+ * @brief provides an implementation of integers modulo N sharing a
+ * context built once for N.
+ *
+ * Several conventions are used in the commentary:
+ * - A "BigM" is the name for an integer modulo N, an element.
+ * - N is the modulus of the context, k the number of digits of N and
+ *   BB the base of BigNum digits. R is BB^k.
+ *
+ * Elements are kept reduced on exactly k digits. When N is odd they are
+ * kept in Montgomery form A * R mod N, and products are reduced with the
+ * Coarsely Integrated Operand Scanning (CIOS) method, one digit of the
+ * multiplier at a time. When N is even, products are reduced with
+ * Barrett's method. In both cases, intermediate values live in the
+ * scratch space of the context and an operation only allocates its
+ * result.
+ *
+ * @note If any BigM parameter is passed as BMNULL, the behavior is
+ * undefined. Functions return BMNULL on error (out of memory, elements
+ * of different contexts, element that is not invertible).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if !defined(__BIGM_H)
+#include "./bigm.h"
+#endif
+
+/** @cond */
+#define BzFreeIf(cond, ptr)     if (cond) BzFree(ptr)
+
+/*
+ * Width, in bits, of the fixed window used by BmPow and smallest
+ * exponent, in bits, for which it is used.
+ */
+#define BM_POW_WINDOW           4
+#define BM_POW_WINDOW_MIN_BITS  32
+
+/*
+ * Scratch layout, in digits, for a k digits modulus:
+ * - Montgomery: product [0, 2k + 2), constant 1 [2k + 2, 3k + 2),
+ *   BmCompare operands [3k + 2, 5k + 2).
+ * - Barrett: product [0, 2k), q2 [2k, 4k + 2), q3 * N [4k + 2, 6k + 4),
+ *   remainder [6k + 4, 7k + 5).
+ * - BmPow window table from 8k + 8, (1 << BM_POW_WINDOW) * k digits.
+ */
+#define BM_SCRATCH_POW(k)       (8 * (k) + 8)
+#define BM_SCRATCH_SIZE(k)      (BM_SCRATCH_POW(k) + ((BigNumLength)1 << BM_POW_WINDOW) * (k))
+/** @endcond */
+
+static void             BmSetDigits(BigNum dst, BigNumLength k, const BigZ z);
+static void             BmMontMul(BigMCtx ctx, BigNum r, const BigNum a, const BigNum b);
+static void             BmBarrettMul(BigMCtx ctx, BigNum r, const BigNum a, const BigNum b);
+static void             BmMul(BigMCtx ctx, BigNum r, const BigNum a, const BigNum b);
+static void             BmToNormal(BigMCtx ctx, BigNum r, const BigNum a);
+static __BigM           BmAllocElement(BigMCtx ctx);
+static BigZ             BmInverseBigZ(const BigZ a, const BigZ n);
+
+/**
+ * BmSetDigits.
+ * Sets the k digits of dst to Z.
+ * @param [out] dst BigNum
+ * @param [in] k BigNumLength
+ * @param [in] z BigZ
+ * @pre 0 <= Z < BB^k
+ */
+static void
+BmSetDigits(BigNum dst, BigNumLength k, const BigZ z) {
+        BnnSetToZero(dst, k);
+        BnnAssign(dst, BzToBn(z), BzNumDigits(z));
+}
+
+/**
+ * BmMontMul.
+ * Computes A * B / R mod N => R, CIOS method.
+ * @param [in] ctx BigMCtx
+ * @param [out] r BigNum, may be A or B.
+ * @param [in] a BigNum
+ * @param [in] b BigNum
+ */
+static void
+BmMontMul(BigMCtx ctx, BigNum r, const BigNum a, const BigNum b) {
+        const BigNumLength k = ctx->NL;
+        const BigNum       n = BzToBn(ctx->N);
+        BigNum             t = ctx->Scratch;
+        BigNumLength       i;
+
+        BnnSetToZero(t, 2 * k + 2);
+
+        for (i = 0; i < k; ++i) {
+                BigNumDigit m;
+
+                /*
+                 * T += A[i] * B, then T += m * N with m chosen so that
+                 * the low digit of T is 0. Instead of dividing T by BB,
+                 * the window T + i moves up one digit. T stays < 2N.
+                 */
+
+                (void)BnnMultiplyDigit(t + i, k + 2, b, k, a[i]);
+                m = t[i] * ctx->NInv;
+                (void)BnnMultiplyDigit(t + i, k + 2, n, k, m);
+        }
+
+        t += k;
+
+        if ((t[k] != BN_ZERO) || (BnnCompare(t, k, n, k) != BN_LT)) {
+                (void)BnnSubtract(t, k + 1, n, k, BN_CARRY);
+        }
+
+        BnnAssign(r, t, k);
+}
+
+/**
+ * BmBarrettMul.
+ * Computes A * B mod N => R, Barrett method.
+ * @param [in] ctx BigMCtx
+ * @param [out] r BigNum, may be A or B.
+ * @param [in] a BigNum
+ * @param [in] b BigNum
+ */
+static void
+BmBarrettMul(BigMCtx ctx, BigNum r, const BigNum a, const BigNum b) {
+        const BigNumLength k  = ctx->NL;
+        const BigNum       n  = BzToBn(ctx->N);
+        BigNum             x  = ctx->Scratch;
+        BigNum             q2 = x + 2 * k;
+        BigNum             p  = q2 + 2 * k + 2;
+        BigNum             rr = p + 2 * k + 2;
+
+        /*
+         * X = A * B < N^2.
+         */
+
+        BnnSetToZero(x, 2 * k);
+        (void)BnnMultiply(x, 2 * k, a, k, b, k);
+
+        /*
+         * q3 = ((X / BB^(k - 1)) * Mu) / BB^(k + 1) is at most 2 below
+         * X / N.
+         */
+
+        BnnSetToZero(q2, 2 * k + 2);
+        (void)BnnMultiply(q2, 2 * k + 2, x + k - 1, k + 1, ctx->Mu, k + 1);
+
+        BnnSetToZero(p, 2 * k + 2);
+        (void)BnnMultiply(p, 2 * k + 2, q2 + k + 1, k + 1, n, k);
+
+        /*
+         * X - q3 * N computed modulo BB^(k + 1), then at most two
+         * subtractions of N.
+         */
+
+        BnnAssign(rr, x, k + 1);
+        (void)BnnSubtract(rr, k + 1, p, k + 1, BN_CARRY);
+
+        while (BnnCompare(rr, k + 1, n, k) != BN_LT) {
+                (void)BnnSubtract(rr, k + 1, n, k, BN_CARRY);
+        }
+
+        BnnAssign(r, rr, k);
+}
+
+/**
+ * BmMul.
+ * Computes the product of two elements in the form of the context.
+ * @param [in] ctx BigMCtx
+ * @param [out] r BigNum
+ * @param [in] a BigNum
+ * @param [in] b BigNum
+ */
+static void
+BmMul(BigMCtx ctx, BigNum r, const BigNum a, const BigNum b) {
+        if (ctx->Montgomery == BN_TRUE) {
+                BmMontMul(ctx, r, a, b);
+        } else {
+                BmBarrettMul(ctx, r, a, b);
+        }
+}
+
+/**
+ * BmToNormal.
+ * Converts an element value to its residue in [0, N).
+ * @param [in] ctx BigMCtx
+ * @param [out] r BigNum, k digits.
+ * @param [in] a BigNum
+ */
+static void
+BmToNormal(BigMCtx ctx, BigNum r, const BigNum a) {
+        const BigNumLength k = ctx->NL;
+
+        if (ctx->Montgomery == BN_TRUE) {
+                /*
+                 * A / R mod N = MontMul(A, 1), 1 is put after the
+                 * product area of the scratch space.
+                 */
+
+                BigNum one = ctx->Scratch + 2 * k + 2;
+
+                BnnSetToZero(one, k);
+                one[0] = BN_ONE;
+                BmMontMul(ctx, r, a, one);
+        } else {
+                BnnAssign(r, a, k);
+        }
+}
+
+/**
+ * BmCtxCreate.
+ * Creates a context for integers modulo N.
+ * @param [in] n BigZ
+ * @return BigMCtx or BMCTXNULL if N <= 1, if BB^(2k) is too large to be
+ * built with BzAsh or if memory is exhausted.
+ */
+BigMCtx
+BmCtxCreate(const BigZ n) {
+        BigMCtx      ctx;
+        BigNumLength k;
+        BigNum       digits;
+        BigZ         one;
+        BigZ         p;
+        BigZ         t;
+        size_t       size;
+
+        if ((BzGetSign(n) != BZ_PLUS) || (BzLength(n) < (BigNumLength)2)) {
+                return BMCTXNULL;
+        }
+
+        k    = BzNumDigits(n);
+
+        /*
+         * R^2 and BB^(2k) are built with BzAsh, whose count is an int.
+         */
+
+        if (k > (BigNumLength)INT_MAX / (2 * (BigNumLength)BN_DIGIT_SIZE)) {
+                return BMCTXNULL;
+        }
+
+        size = (size_t)(3 * k + 1 + BM_SCRATCH_SIZE(k)) * sizeof(BigNumDigit);
+
+        if ((ctx = (BigMCtx)BmAlloc(sizeof(BigMCtxStruct))) == BMCTXNULL) {
+                return BMCTXNULL;
+        }
+
+        if ((digits = (BigNum)BmAlloc(size)) == NULL) {
+                BmFree(ctx);
+                return BMCTXNULL;
+        }
+
+        BnnSetToZero(digits, (BigNumLength)(size / sizeof(BigNumDigit)));
+
+        ctx->NL         = k;
+        ctx->Montgomery = BzIsOdd(n);
+        ctx->NInv       = BN_ZERO;
+        ctx->R2         = digits;
+        ctx->Mu         = digits + k;
+        ctx->One        = digits + 2 * k + 1;
+        ctx->Scratch    = digits + 3 * k + 1;
+
+        if ((ctx->N = BzCopy(n)) == BZNULL) {
+                BmFree(digits);
+                BmFree(ctx);
+                return BMCTXNULL;
+        }
+
+        if ((one = BzFromInteger((BzInt)1)) == BZNULL) {
+                BmCtxDelete(ctx);
+                return BMCTXNULL;
+        }
+
+        if (ctx->Montgomery == BN_TRUE) {
+                const BigNumDigit n0  = BzGetDigit(n, 0);
+                BigNumDigit       inv = n0;
+                BigNumLength      bits;
+
+                /*
+                 * Newton iteration for 1/n0 mod BB, each step doubles the
+                 * number of correct low bits (n0 * n0 = 1 mod 8).
+                 */
+
+                for (bits = 3; bits < (BigNumLength)BN_DIGIT_SIZE; bits *= 2) {
+                        inv *= (BigNumDigit)2 - n0 * inv;
+                }
+
+                ctx->NInv = (BigNumDigit)0 - inv;
+
+                /*
+                 * One = R mod N, R2 = R^2 mod N.
+                 */
+
+                p = BzAsh(one, (int)(k * BN_DIGIT_SIZE));
+                t = (p != BZNULL) ? BzMod(p, n) : BZNULL;
+                BzFreeIf(p != BZNULL, p);
+
+                if (t == BZNULL) {
+                        BzFree(one);
+                        BmCtxDelete(ctx);
+                        return BMCTXNULL;
+                }
+
+                BmSetDigits(ctx->One, k, t);
+                BzFree(t);
+
+                p = BzAsh(one, (int)(2 * k * BN_DIGIT_SIZE));
+                t = (p != BZNULL) ? BzMod(p, n) : BZNULL;
+                BzFreeIf(p != BZNULL, p);
+
+                if (t == BZNULL) {
+                        BzFree(one);
+                        BmCtxDelete(ctx);
+                        return BMCTXNULL;
+                }
+
+                BmSetDigits(ctx->R2, k, t);
+                BzFree(t);
+        } else {
+                /*
+                 * Mu = floor(BB^(2k) / N) has k + 1 digits, except when
+                 * N = BB^(k - 1) where BB^(k + 1) - 1 is used instead.
+                 * It makes q3 at most 3 below X / N, which still keeps
+                 * X - q3 * N below BB^(k + 1).
+                 */
+
+                p = BzAsh(one, (int)(2 * k * BN_DIGIT_SIZE));
+                t = (p != BZNULL) ? BzFloor(p, n) : BZNULL;
+                BzFreeIf(p != BZNULL, p);
+
+                if (t == BZNULL) {
+                        BzFree(one);
+                        BmCtxDelete(ctx);
+                        return BMCTXNULL;
+                }
+
+                if (BzNumDigits(t) > k + 1) {
+                        BnnSetToZero(ctx->Mu, k + 1);
+                        BnnComplement(ctx->Mu, k + 1);
+                } else {
+                        BmSetDigits(ctx->Mu, k + 1, t);
+                }
+
+                BzFree(t);
+
+                ctx->One[0] = BN_ONE;
+        }
+
+        BzFree(one);
+
+        return ctx;
+}
+
+/**
+ * BmCtxDelete.
+ * Frees a context. Its elements must not be used afterwards.
+ * @param [in] ctx BigMCtx
+ */
+void
+BmCtxDelete(BigMCtx ctx) {
+        if (ctx != BMCTXNULL) {
+                BzFreeIf(ctx->N != BZNULL, ctx->N);
+                BmFree(ctx->R2);
+                BmFree(ctx);
+        }
+}
+
+/**
+ * BmAllocElement.
+ * Allocates an element of a context, digits are not initialized.
+ * @param [in] ctx BigMCtx
+ * @return __BigM
+ */
+static __BigM
+BmAllocElement(BigMCtx ctx) {
+        __BigM m;
+
+        m = (__BigM)BmAlloc(sizeof(BigMStruct)
+                            + (size_t)ctx->NL * sizeof(BigNumDigit));
+
+        if (m != NULL) {
+                m->Ctx = ctx;
+                m->V   = (BigNum)(void *)(m + 1);
+        }
+
+        return m;
+}
+
+/**
+ * BmCreate.
+ * Creates the element Z mod N of a context.
+ * @param [in] ctx BigMCtx
+ * @param [in] z BigZ
+ * @return BigM
+ */
+BigM
+BmCreate(BigMCtx ctx, const BigZ z) {
+        __BigM m;
+        BigZ   r;
+
+        if ((r = BzMod(z, ctx->N)) == BZNULL) {
+                return BMNULL;
+        }
+
+        if ((m = BmAllocElement(ctx)) == NULL) {
+                BzFree(r);
+                return BMNULL;
+        }
+
+        BmSetDigits(m->V, ctx->NL, r);
+        BzFree(r);
+
+        if (ctx->Montgomery == BN_TRUE) {
+                /*
+                 * A * R = MontMul(A, R^2).
+                 */
+
+                BmMontMul(ctx, m->V, m->V, ctx->R2);
+        }
+
+        return m;
+}
+
+/**
+ * BmToBigZ.
+ * Returns the residue of an element in [0, N).
+ * @param [in] m BigM
+ * @return BigZ
+ */
+BigZ
+BmToBigZ(BigM m) {
+        const BigMCtx ctx = BmGetCtx(m);
+        BigZ          z;
+
+        if ((z = BzCreate(ctx->NL)) == BZNULL) {
+                return z;
+        }
+
+        BmToNormal(ctx, BzToBn(z), m->V);
+
+        if (BnnIsZero(BzToBn(z), ctx->NL) == BN_FALSE) {
+                BzSetSign(z, BZ_PLUS);
+        }
+
+        return z;
+}
+
+/**
+ * BmDelete.
+ * Frees an element.
+ * @param [in] m BigM
+ */
+void
+BmDelete(BigM m) {
+        if (m != BMNULL) {
+                BmFree(m);
+        }
+}
+
+/**
+ * BmCompare.
+ * Compares two elements, by modulus first, then by residue.
+ * @param [in] a BigM
+ * @param [in] b BigM
+ * @return BN_LT, BN_EQ or BN_GT
+ */
+BigNumCmp
+BmCompare(BigM a, BigM b) {
+        const BigMCtx ctx = BmGetCtx(a);
+        BigNumLength  k;
+        BigNum        x;
+        BigNum        y;
+
+        if (BmGetCtx(b) != ctx) {
+                BzCmp cmp = BzCompare(ctx->N, BmGetCtx(b)->N);
+
+                if (cmp != BZ_EQ) {
+                        return (BigNumCmp)cmp;
+                }
+
+                /*
+                 * Two contexts for the same modulus, elements have the
+                 * same representation.
+                 */
+        }
+
+        k = ctx->NL;
+
+        if (ctx->Montgomery == BN_FALSE) {
+                return BnnCompare(a->V, k, b->V, k);
+        }
+
+        x = ctx->Scratch + 3 * k + 2;
+        y = x + k;
+
+        BmToNormal(ctx, x, a->V);
+        BmToNormal(ctx, y, b->V);
+
+        return BnnCompare(x, k, y, k);
+}
+
+/**
+ * BmHash.
+ * Returns a hash value of an element, equal elements have equal hash
+ * values.
+ * @param [in] m BigM
+ * @return BzUInt
+ */
+BzUInt
+BmHash(BigM m) {
+        const BigNumLength k = BmGetCtx(m)->NL;
+        BigNumLength       i;
+        BzUInt             h = (BzUInt)2166136261U;
+
+        for (i = 0; i < k; ++i) {
+                BigNumDigit d = m->V[i];
+
+                h = (h ^ (BzUInt)(d & (BigNumDigit)0xffffffffU)) * 16777619U;
+                h = (h ^ (BzUInt)((d >> 16) >> 16)) * 16777619U;
+        }
+
+        return h;
+}
+
+/**
+ * BmAdd.
+ * Returns A + B mod N.
+ * @param [in] a BigM
+ * @param [in] b BigM
+ * @return BigM
+ */
+BigM
+BmAdd(BigM a, BigM b) {
+        const BigMCtx ctx = BmGetCtx(a);
+        BigNumLength  k;
+        BigNumCarry   c;
+        __BigM        r;
+
+        if ((BmGetCtx(b) != ctx) || ((r = BmAllocElement(ctx)) == NULL)) {
+                return BMNULL;
+        }
+
+        k = ctx->NL;
+
+        BnnAssign(r->V, a->V, k);
+        c = BnnAdd(r->V, k, b->V, k, BN_NOCARRY);
+
+        if ((c != BN_NOCARRY)
+            || (BnnCompare(r->V, k, BzToBn(ctx->N), k) != BN_LT)) {
+                (void)BnnSubtract(r->V, k, BzToBn(ctx->N), k, BN_CARRY);
+        }
+
+        return r;
+}
+
+/**
+ * BmSubtract.
+ * Returns A - B mod N.
+ * @param [in] a BigM
+ * @param [in] b BigM
+ * @return BigM
+ */
+BigM
+BmSubtract(BigM a, BigM b) {
+        const BigMCtx ctx = BmGetCtx(a);
+        BigNumLength  k;
+        __BigM        r;
+
+        if ((BmGetCtx(b) != ctx) || ((r = BmAllocElement(ctx)) == NULL)) {
+                return BMNULL;
+        }
+
+        k = ctx->NL;
+
+        BnnAssign(r->V, a->V, k);
+
+        if (BnnSubtract(r->V, k, b->V, k, BN_CARRY) == BN_NOCARRY) {
+                /*
+                 * Borrow, A < B.
+                 */
+
+                (void)BnnAdd(r->V, k, BzToBn(ctx->N), k, BN_NOCARRY);
+        }
+
+        return r;
+}
+
+/**
+ * BmNegate.
+ * Returns -A mod N.
+ * @param [in] a BigM
+ * @return BigM
+ */
+BigM
+BmNegate(BigM a) {
+        const BigMCtx ctx = BmGetCtx(a);
+        BigNumLength  k;
+        __BigM        r;
+
+        if ((r = BmAllocElement(ctx)) == NULL) {
+                return BMNULL;
+        }
+
+        k = ctx->NL;
+
+        if (BnnIsZero(a->V, k) == BN_TRUE) {
+                BnnSetToZero(r->V, k);
+        } else {
+                BnnAssign(r->V, BzToBn(ctx->N), k);
+                (void)BnnSubtract(r->V, k, a->V, k, BN_CARRY);
+        }
+
+        return r;
+}
+
+/**
+ * BmMultiply.
+ * Returns A * B mod N.
+ * @param [in] a BigM
+ * @param [in] b BigM
+ * @return BigM
+ */
+BigM
+BmMultiply(BigM a, BigM b) {
+        const BigMCtx ctx = BmGetCtx(a);
+        __BigM        r;
+
+        if ((BmGetCtx(b) != ctx) || ((r = BmAllocElement(ctx)) == NULL)) {
+                return BMNULL;
+        }
+
+        BmMul(ctx, r->V, a->V, b->V);
+
+        return r;
+}
+
+/**
+ * BmInverseBigZ.
+ * Returns 1/A mod N with the extended Euclidean algorithm.
+ * @param [in] a BigZ
+ * @param [in] n BigZ
+ * @return BigZ or BZNULL if gcd(A, N) != 1.
+ * @pre 0 <= A < N
+ */
+static BigZ
+BmInverseBigZ(const BigZ a, const BigZ n) {
+        BigZ r0 = BzCopy(n);
+        BigZ r1 = BzCopy(a);
+        BigZ s0 = BzFromInteger((BzInt)0);
+        BigZ s1 = BzFromInteger((BzInt)1);
+        BigZ res = BZNULL;
+
+        /*
+         * Invariant: Ri = Si * A mod N.
+         */
+
+        while ((r0 != BZNULL) && (r1 != BZNULL)
+               && (s0 != BZNULL) && (s1 != BZNULL)
+               && (BzGetSign(r1) != BZ_ZERO)) {
+                BigZ r;
+                BigZ q  = BzDivide(r0, r1, &r);
+                BigZ qs = (q != BZNULL) ? BzMultiply(q, s1) : BZNULL;
+                BigZ s  = (qs != BZNULL) ? BzSubtract(s0, qs) : BZNULL;
+
+                BzFreeIf(q != BZNULL, q);
+                BzFreeIf(qs != BZNULL, qs);
+
+                BzFree(r0);
+                BzFree(s0);
+                r0 = r1;
+                s0 = s1;
+                r1 = (q != BZNULL) ? r : BZNULL;
+                s1 = s;
+        }
+
+        if ((r0 != BZNULL) && (r1 != BZNULL) && (s0 != BZNULL)
+            && (s1 != BZNULL) && (BzLength(r0) == (BigNumLength)1)) {
+                /*
+                 * gcd is 1.
+                 */
+
+                res = BzMod(s0, n);
+        }
+
+        BzFreeIf(r0 != BZNULL, r0);
+        BzFreeIf(r1 != BZNULL, r1);
+        BzFreeIf(s0 != BZNULL, s0);
+        BzFreeIf(s1 != BZNULL, s1);
+
+        return res;
+}
+
+/**
+ * BmInverse.
+ * Returns 1/A mod N.
+ * @param [in] a BigM
+ * @return BigM or BMNULL if A is not invertible.
+ */
+BigM
+BmInverse(BigM a) {
+        const BigMCtx ctx = BmGetCtx(a);
+        BigZ          z;
+        BigZ          inv;
+        BigM          r;
+
+        if ((z = BmToBigZ(a)) == BZNULL) {
+                return BMNULL;
+        }
+
+        inv = BmInverseBigZ(z, ctx->N);
+        BzFree(z);
+
+        if (inv == BZNULL) {
+                return BMNULL;
+        }
+
+        r = BmCreate(ctx, inv);
+        BzFree(inv);
+
+        return r;
+}
+
+/**
+ * BmPow.
+ * Returns A^E mod N. A negative E is a power of 1/A.
+ * @param [in] a BigM
+ * @param [in] e BigZ
+ * @return BigM or BMNULL if E < 0 and A is not invertible.
+ */
+BigM
+BmPow(BigM a, const BigZ e) {
+        const BigMCtx      ctx = BmGetCtx(a);
+        const BigNumLength k   = ctx->NL;
+        const BigNum       ee  = BzToBn(e);
+        BigNumLength       nbits;
+        BigNumLength       i;
+        __BigM             r;
+
+        if (BzGetSign(e) == BZ_MINUS) {
+                BigM inv;
+                BigZ f;
+
+                if ((inv = BmInverse(a)) == BMNULL) {
+                        return BMNULL;
+                }
+
+                if ((f = BzNegate(e)) == BZNULL) {
+                        BmDelete(inv);
+                        return BMNULL;
+                }
+
+                r = (__BigM)BmPow(inv, f);
+
+                BzFree(f);
+                BmDelete(inv);
+
+                return r;
+        }
+
+        if ((r = BmAllocElement(ctx)) == NULL) {
+                return BMNULL;
+        }
+
+        BnnAssign(r->V, ctx->One, k);
+
+        if (BzGetSign(e) == BZ_ZERO) {
+                return r;
+        }
+
+        nbits = BnnNumLength(ee, BzNumDigits(e));
+
+        if (nbits < (BigNumLength)BM_POW_WINDOW_MIN_BITS) {
+                /*
+                 * Left to right binary method.
+                 */
+
+                for (i = nbits; i-- > 0;) {
+                        BmMul(ctx, r->V, r->V, r->V);
+                        if (((ee[i / BN_DIGIT_SIZE] >> (i % BN_DIGIT_SIZE))
+                             & BN_ONE) != BN_ZERO) {
+                                BmMul(ctx, r->V, r->V, a->V);
+                        }
+                }
+        } else {
+                /*
+                 * Fixed window method, table[w] = A^w.
+                 */
+
+                const BigNumDigit mask  = ((BigNumDigit)1 << BM_POW_WINDOW) - 1;
+                BigNum            table = ctx->Scratch + BM_SCRATCH_POW(k);
+                BigNumLength      w;
+
+                BnnAssign(table, ctx->One, k);
+                BnnAssign(table + k, a->V, k);
+
+                for (w = 2; w < ((BigNumLength)1 << BM_POW_WINDOW); ++w) {
+                        BmMul(ctx, table + w * k, table + (w - 1) * k, a->V);
+                }
+
+                for (i = (nbits + BM_POW_WINDOW - 1) / BM_POW_WINDOW; i-- > 0;) {
+                        const BigNumLength bit = i * BM_POW_WINDOW;
+                        int                j;
+
+                        for (j = 0; j < BM_POW_WINDOW; ++j) {
+                                BmMul(ctx, r->V, r->V, r->V);
+                        }
+
+                        w = (BigNumLength)((ee[bit / BN_DIGIT_SIZE]
+                                            >> (bit % BN_DIGIT_SIZE)) & mask);
+
+                        if (w != 0) {
+                                BmMul(ctx, r->V, r->V, table + w * k);
+                        }
+                }
+        }
+
+        return r;
+}
@@ -0,0 +1,128 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bigm.h
+ * @brief Types and structures for clients of BigM.
+ */
+
+#if !defined(__BIGM_H)
+#define __BIGM_H
+
+#if !defined(__BIGZ_H)
+#include "./bigz.h"
+#endif
+
+#if defined(__cplusplus)
+extern  "C"     {
+#endif
+
+/** @cond */
+/**
+ * A BigM context holds a modulus N > 1 and what is needed to reduce
+ * products modulo N without allocating: Montgomery constants when N is
+ * odd, Barrett constants when N is even, and scratch space. A context
+ * must not be used by two threads at the same time.
+ */
+typedef struct {
+        /** modulus, a positive BigZ. */
+        BigZ         N;
+        /** number of digits of N. */
+        BigNumLength NL;
+        /** BN_TRUE if elements are kept in Montgomery form (N odd). */
+        BigNumBool   Montgomery;
+        /** -1/N mod BB (Montgomery). */
+        BigNumDigit  NInv;
+        /** R^2 mod N, R = BB^NL (Montgomery), NL digits. */
+        BigNum       R2;
+        /** floor(BB^(2 * NL) / N) (Barrett), NL + 1 digits. */
+        BigNum       Mu;
+        /** one in the form used by elements, NL digits. */
+        BigNum       One;
+        /** scratch space used by multiplications. */
+        BigNum       Scratch;
+} BigMCtxStruct;
+
+typedef BigMCtxStruct *                 BigMCtx;
+
+/**
+ * BigM element is a residue modulo the modulus of its context, kept
+ * on exactly NL digits.
+ */
+typedef struct {
+        /** context the element belongs to. */
+        BigMCtx      Ctx;
+        /** value, in Montgomery form if Ctx->Montgomery. */
+        BigNum       V;
+} BigMStruct;
+
+typedef BigMStruct *                    __BigM;
+
+#if !defined(BM_MODINT_TYPE)
+#define BM_MODINT_TYPE
+typedef const BigMStruct *              BigM;
+#endif
+/** @endcond */
+
+#if !defined(__EXTERNAL_BIGM_MEMORY)
+/**
+ * User overloadable macro that gets native BigM implementation from
+ * a high level object.
+ */
+#define __toBmObj(m)                    ((__BigM)m)
+/**
+ * NULL BigM.
+ */
+#define BMNULL                          ((BigM)0)
+/**
+ * NULL BigM context.
+ */
+#define BMCTXNULL                       ((BigMCtx)0)
+/**
+ * User overloadable macro called to allocate memory for BigM.
+ */
+#define BmAlloc(size)                   malloc(size)
+/**
+ * User overloadable macro called to free memory allocated by BmAlloc.
+ */
+#define BmFree(p)                       free((void *)p)
+/**
+ * Get BigM context.
+ */
+#define BmGetCtx(m)                     (__toBmObj(m)->Ctx)
+/**
+ * Get the modulus of a BigM context.
+ */
+#define BmCtxGetModulus(c)              ((c)->N)
+#endif
+
+/*
+ * functions of bigm.c
+ */
+
+extern BigMCtx   BmCtxCreate(const BigZ n);
+extern void      BmCtxDelete(BigMCtx ctx);
+
+extern BigM      BmCreate(BigMCtx ctx, const BigZ z);
+extern BigZ      BmToBigZ(BigM m);
+extern void      BmDelete(BigM m);
+
+extern BigNumCmp BmCompare(BigM a, BigM b);
+extern BzUInt    BmHash(BigM m);
+extern BigM      BmAdd(BigM a, BigM b);
+extern BigM      BmInverse(BigM a);
+extern BigM      BmMultiply(BigM a, BigM b);
+extern BigM      BmNegate(BigM a);
+extern BigM      BmPow(BigM a, const BigZ e);
+extern BigM      BmSubtract(BigM a, BigM b);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  /* __BIGM_H */
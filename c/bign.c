@@ -62,12 +62,87 @@
  * $Date: 2023-02-04 07:19:15 +0100 (Sat, 04 Feb 2023) $
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #if !defined(__BIGN_H)
 #include "./bign.h"
 #endif
 
+#if !defined(__BNTHREAD_H)
+#include "./bnthread.h"
+#endif
+
+/** @cond */
+#if defined(__GNUC__) || defined(__clang__)
+#define BN_HAVE_BUILTIN_BITS
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+#include <immintrin.h>
+#define BN_HAVE_AVX512_POPCOUNT
+#endif
+
+/*
+ * Shifts by 64, in steps of 16 as BzHash does, so that they stay defined
+ * for 32-bit digits (an unsigned long on Windows and 32-bit targets),
+ * where the result is 0.
+ */
+#define BnnHigh64(d)            (((((d) >> 16) >> 16) >> 16) >> 16)
+
+/*
+ * When the product of two digits fits in a native type, the compiler
+ * emits a single widening multiply (mul, or mulx with BMI2, on x86-64)
+ * instead of four half digit products.
+ */
+#if defined(__SIZEOF_INT128__) && !defined(BN_EXPERIMENTAL_128BIT)
+#define BN_HAVE_DOUBLE_DIGIT
+typedef unsigned __int128       BnnDoubleDigit;
+#endif
+
+/*
+ * BnnMultiply uses the thread pool when the operands have at least
+ * BNN_PARALLEL_DIGITS digits and their product more than
+ * BNN_PARALLEL_PRODUCTS digit products, below that the threads cost
+ * more than they save.
+ */
+#define BNN_PARALLEL_DIGITS     ((BigNumLength)64)
+#define BNN_PARALLEL_PRODUCTS   ((double)(1 << 18))
+
+/*
+ * A product split in MCount x NCount parts, the part of the Ith slice
+ * of M and the Jth slice of N is stored in Parts[(J * MCount + I) *
+ * (MSlice + NSlice)].
+ */
+typedef struct {
+        BigNum       Parts;
+        BigNum       mm;
+        BigNumLength ml;
+        BigNumLength MSlice;
+        BigNumLength MCount;
+        BigNum       nn;
+        BigNumLength nl;
+        BigNumLength NSlice;
+} BnnMultiplyJob;
+/** @endcond */
+
 static void
 BnnDivideHelper(BigNum nn, BigNumLength nl, BigNum dd, BigNumLength dl);
+static BigNumLength BnnDigitCount(BigNumDigit d) BN_CONST_FUNCTION;
+static BigNumCarry  BnnMultiplySerial(BigNum pp,
+                                      BigNumLength pl,
+                                      const BigNum mm,
+                                      BigNumLength ml,
+                                      const BigNum nn,
+                                      BigNumLength nl);
+static void         BnnMultiplyPart(void *job, BigNumLength k);
+static BigNumCarry  BnnMultiplyParallel(BigNum pp,
+                                        BigNumLength pl,
+                                        const BigNum mm,
+                                        BigNumLength ml,
+                                        const BigNum nn,
+                                        BigNumLength nl,
+                                        unsigned int threads);
 
 /**
  * BnnSetToZero.
@@ -86,29 +161,15 @@ BnnSetToZero(BigNum nn, BigNumLength nl) {
 
 /**
  * BnnAssign.
- * Copies N => M
+ * Copies N => M. M and N may overlap, the copy is a memmove.
  * @param [in, out] mm BigNum
  * @param [in] nn const BigNum
  * @param [in] nl BigNumLength
  */
 void
 BnnAssign(BigNum mm, const BigNum nn, BigNumLength nl) {
-        int d;
-
-        if ((mm < nn) || (mm > (nn + nl))) {
-                /*
-                 * no memory overlap using classic loop 
-                 */
-                for (d = 0; d < (int)nl; ++d) {
-                        mm[d] = nn[d];
-                }
-        } else if (mm > nn) {
-                /*
-                 * memory overlap, loop starting from most significant digit
-                 */
-                for (d = (int)(nl - 1); d >= 0; --d) {
-                        mm[d] = nn[d];
-                }
+        if ((mm != nn) && (nl != 0)) {
+                (void)memmove(mm, nn, (size_t)nl * sizeof(BigNumDigit));
         }
 }
 
@@ -143,18 +204,15 @@ BnnGetDigit(const BigNum nn) {
  */
 BigNumLength
 BnnNumDigits(const BigNum nn, BigNumLength nl) {
-        int d;
+        BigNumLength d;
 
         /*
          * loop starting from most significant digit
          */
 
-        for (d = (int)(nl - 1); d >= 0; --d) {
-                if (nn[d] != BN_ZERO) {
-                        /*
-                         * length = d+1
-                         */
-                        return (BigNumLength)(d + 1);
+        for (d = nl; d > 0; --d) {
+                if (nn[d - 1] != BN_ZERO) {
+                        return d;
                 }
         }
 
@@ -171,16 +229,40 @@ BnnNumDigits(const BigNum nn, BigNumLength nl) {
 BigNumLength
 BnnNumLength(const BigNum nn, BigNumLength nl) {
         const BigNumDigit d = nn[nl - 1];
-        int i;
 
-        for (i = (int)(BN_DIGIT_SIZE - 1); i >= 0; --i) {
-                if ((d & (BN_ONE << (BigNumLength)i)) != 0) {
-                        BigNumLength bits = (BigNumLength)i + 1;
-                        return (BigNumLength)(((nl-1) * BN_DIGIT_SIZE) + bits);
-                }
+        if (d == BN_ZERO) {
+                return 0;
+        }
+
+        return (BigNumLength)((nl * BN_DIGIT_SIZE)
+                              - BnnNumLeadingZeroBitsInDigit(d));
+}
+
+/**
+ * BnnDigitCount.
+ * Returns the count of bits set of a digit.
+ * @param [in] d BigNumDigit
+ * @return BigNumLength
+ */
+static BigNumLength
+BnnDigitCount(BigNumDigit d) {
+        BigNumLength count = 0;
+
+#if defined(BN_HAVE_BUILTIN_BITS)
+        BigNumLength i;
+
+        for (i = 0; i < (BigNumLength)BN_DIGIT_SIZE; i += 64) {
+                count += (BigNumLength)__builtin_popcountll((unsigned long long)d);
+                d      = BnnHigh64(d);
+        }
+#else
+        while (d != BN_ZERO) {
+                d &= (d - 1);
+                ++count;
         }
+#endif
 
-        return 0;
+        return count;
 }
 
 /**
@@ -193,17 +275,24 @@ BnnNumLength(const BigNum nn, BigNumLength nl) {
 BigNumLength
 BnnNumCount(const BigNum nn, BigNumLength nl) {
         BigNumLength count = 0;
-        int j;
+        BigNumLength i     = 0;
 
-        for (j = 0; j < (int)nl; ++j) {
-                const BigNumDigit d = nn[j];
-                int     i;
+#if defined(BN_HAVE_AVX512_POPCOUNT)
+        if (sizeof(BigNumDigit) == sizeof(long long)) {
+                __m512i acc = _mm512_setzero_si512();
 
-                for (i = (int)(BN_DIGIT_SIZE - 1); i >= 0; --i) {
-                        if ((d & (BN_ONE << (BigNumLength)i)) != 0) {
-                                ++count;
-                        }
+                for (; i + 8 <= nl; i += 8) {
+                        __m512i v = _mm512_loadu_si512((const void *)(nn + i));
+
+                        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
                 }
+
+                count = (BigNumLength)_mm512_reduce_add_epi64(acc);
+        }
+#endif
+
+        for (; i < nl; ++i) {
+                count += BnnDigitCount(nn[i]);
         }
 
         return count;
@@ -217,18 +306,69 @@ BnnNumCount(const BigNum nn, BigNumLength nl) {
  */
 BigNumLength
 BnnNumLeadingZeroBitsInDigit(BigNumDigit d) {
-        BigNumDigit  mask = (BigNumDigit)(BN_ONE << (BN_DIGIT_SIZE - 1));
         BigNumLength p;
 
         if (d == BN_ZERO) {
                 return (BigNumLength)BN_DIGIT_SIZE;
         }
 
-        for (p = 0; (d & mask) == 0; ++p) {
-                mask >>= 1;
+#if defined(BN_HAVE_BUILTIN_BITS)
+        /*
+         * Digits are 32, 64 or 128 bits wide.
+         */
+
+        if (BN_DIGIT_SIZE > 64) {
+                if (BnnHigh64(d) != BN_ZERO) {
+                        return (BigNumLength)__builtin_clzll((unsigned long long)BnnHigh64(d));
+                }
+                return (BigNumLength)(64 + __builtin_clzll((unsigned long long)d));
+        }
+
+        p = (BigNumLength)__builtin_clzll((unsigned long long)d);
+
+        return (BigNumLength)(p - (64 - BN_DIGIT_SIZE));
+#else
+        {
+                BigNumDigit mask = (BigNumDigit)(BN_ONE << (BN_DIGIT_SIZE - 1));
+
+                for (p = 0; (d & mask) == 0; ++p) {
+                        mask >>= 1;
+                }
+        }
+
+        return p;
+#endif
+}
+
+/**
+ * BnnNumTrailingZeroBitsInDigit.
+ * Returns the number of trailing zero bits in a digit
+ * @param [in] d BigNumDigit
+ * @return BigNumLength
+ */
+BigNumLength
+BnnNumTrailingZeroBitsInDigit(BigNumDigit d) {
+        BigNumLength p = 0;
+
+        if (d == BN_ZERO) {
+                return (BigNumLength)BN_DIGIT_SIZE;
+        }
+
+#if defined(BN_HAVE_BUILTIN_BITS)
+        while ((unsigned long long)d == 0ULL) {
+                d  = BnnHigh64(d);
+                p += 64;
+        }
+
+        return p + (BigNumLength)__builtin_ctzll((unsigned long long)d);
+#else
+        while ((d & BN_ONE) == BN_ZERO) {
+                d >>= 1;
+                ++p;
         }
 
         return p;
+#endif
 }
 
 /**
@@ -241,7 +381,6 @@ BnnNumLeadingZeroBitsInDigit(BigNumDigit d) {
 BigNumBool
 BnnIsPower2(const BigNum nn, BigNumLength nl) {
         BigNumLength i;
-        BigNumLength nbits;
         BigNumDigit  d;
 
         /*
@@ -258,21 +397,9 @@ BnnIsPower2(const BigNum nn, BigNumLength nl) {
          * There must be only 1 bit set on the last Digit.
          */
 
-        d     = nn[i];
-        nbits = 0;
+        d = nn[i];
 
-        for (i = 0; i < (BigNumLength)BN_DIGIT_SIZE; ++i) {
-                if ((d & (BN_ONE << i)) != 0) {
-                        if (nbits++ > 0) {
-                                /*
-                                 * More than two digits.
-                                 */
-                                return BN_FALSE;
-                        }
-                }
-        }
-
-        return BN_TRUE;
+        return (BigNumBool)((d & (d - 1)) == BN_ZERO);
 }
 
 /**
@@ -703,6 +830,20 @@ BnnMultiplyDigit(BigNum pp,
                 return BnnAdd(pp, pl, mm, ml, BN_NOCARRY);
         }
 
+#if defined(BN_HAVE_DOUBLE_DIGIT)
+        for (i = 0; i < ml; ++i) {
+                /*
+                 * (BB - 1)^2 + 2 * (BB - 1) < BB^2, no overflow.
+                 */
+                const BnnDoubleDigit x = (BnnDoubleDigit)mm[i] * d
+                                         + *pp
+                                         + c;
+
+                --pl;
+                *(pp++) = (BigNumDigit)x;
+                c = (BigNumProduct)(x >> BN_DIGIT_SIZE);
+        }
+#else
         for (i = 0; i < ml; ++i) {
                 BigNumDigit Lm;
                 BigNumDigit Hm;
@@ -731,6 +872,7 @@ BnnMultiplyDigit(BigNum pp,
                 *(pp++) = (BigNumDigit)c;
                 c = X3 + HIGH(X1) + HIGH(X2);
         }
+#endif
 
         if (pl == 0) {
                 return BN_NOCARRY;
@@ -963,6 +1105,38 @@ BnnMultiply(BigNum pp,
             BigNumLength ml,
             const BigNum nn,
             BigNumLength nl) {
+        if ((ml >= BNN_PARALLEL_DIGITS)
+            && (nl >= BNN_PARALLEL_DIGITS)
+            && ((double)ml * (double)nl > BNN_PARALLEL_PRODUCTS)
+            && (pl >= ml + nl)) {
+                const unsigned int threads = BnnGetThreads();
+
+                if (threads > 1) {
+                        return BnnMultiplyParallel(pp, pl, mm, ml, nn, nl, threads);
+                }
+        }
+
+        return BnnMultiplySerial(pp, pl, mm, ml, nn, nl);
+}
+
+/**
+ * BnnMultiplySerial.
+ * BnnMultiply on the calling thread, one digit of N at a time.
+ * @param [in, out] pp BigNum
+ * @param [in] pl BigNumLength
+ * @param [in] mm BigNum
+ * @param [in] ml BigNumLength
+ * @param [in] nn BigNum
+ * @param [in] nl BigNumLength
+ * @return BigNumCarry
+ */
+static BigNumCarry
+BnnMultiplySerial(BigNum pp,
+                  BigNumLength pl,
+                  const BigNum mm,
+                  BigNumLength ml,
+                  const BigNum nn,
+                  BigNumLength nl) {
         BigNumLength i;
         BigNumCarry  c = BN_NOCARRY;
 
@@ -979,6 +1153,122 @@ BnnMultiply(BigNum pp,
         return c;
 }
 
+/**
+ * BnnMultiplyPart.
+ * BnnTask computing the kth part of a BnnMultiplyJob.
+ * @param [in, out] job BnnMultiplyJob
+ * @param [in] k BigNumLength
+ */
+static void
+BnnMultiplyPart(void *job, BigNumLength k) {
+        const BnnMultiplyJob *j  = (const BnnMultiplyJob *)job;
+        const BigNumLength    mo = (k % j->MCount) * j->MSlice;
+        const BigNumLength    no = (k / j->MCount) * j->NSlice;
+        const BigNumLength    ml = (j->ml - mo < j->MSlice) ? j->ml - mo : j->MSlice;
+        const BigNumLength    nl = (j->nl - no < j->NSlice) ? j->nl - no : j->NSlice;
+        const BigNum          pp = j->Parts + k * (j->MSlice + j->NSlice);
+
+        BnnSetToZero(pp, ml + nl);
+        (void)BnnMultiplySerial(pp, ml + nl, j->mm + mo, ml, j->nn + no, nl);
+}
+
+/**
+ * BnnMultiplyParallel.
+ * BnnMultiply on the thread pool. M and N are cut in slices and the
+ * products of slices computed on the pool are added to P in the same
+ * order on the calling thread, so that P and the carry are the same as
+ * BnnMultiplySerial's. The parts take about sqrt(2 * threads) times
+ * the size of the product, BnnMultiplySerial is used when they cannot
+ * be allocated.
+ * @param [in, out] pp BigNum
+ * @param [in] pl BigNumLength
+ * @param [in] mm BigNum
+ * @param [in] ml BigNumLength
+ * @param [in] nn BigNum
+ * @param [in] nl BigNumLength
+ * @param [in] threads unsigned int
+ * @return BigNumCarry
+ * @pre pl >= ml + nl.
+ */
+static BigNumCarry
+BnnMultiplyParallel(BigNum pp,
+                    BigNumLength pl,
+                    const BigNum mm,
+                    BigNumLength ml,
+                    const BigNum nn,
+                    BigNumLength nl,
+                    unsigned int threads) {
+        BnnMultiplyJob job;
+        BigNumLength   parts;
+        BigNumLength   ncount;
+        BigNumLength   k;
+        BigNumCarry    c = BN_NOCARRY;
+
+        /*
+         * About two parts per thread, as a grid close to a square as
+         * this keeps the parts small: MCount is the largest divisor of
+         * 2 * threads not above its square root.
+         */
+
+        parts = (BigNumLength)2 * threads;
+
+        for (job.MCount = 1, k = 2; k * k <= parts; ++k) {
+                if ((parts % k) == 0) {
+                        job.MCount = k;
+                }
+        }
+
+        ncount = parts / job.MCount;
+
+        if (ml / BNN_PARALLEL_DIGITS < job.MCount) {
+                job.MCount = ml / BNN_PARALLEL_DIGITS;
+        }
+
+        if (nl / BNN_PARALLEL_DIGITS < ncount) {
+                ncount = nl / BNN_PARALLEL_DIGITS;
+        }
+
+        job.mm     = mm;
+        job.ml     = ml;
+        job.MSlice = (ml + job.MCount - 1) / job.MCount;
+        job.MCount = (ml + job.MSlice - 1) / job.MSlice;
+        job.nn     = nn;
+        job.nl     = nl;
+        job.NSlice = (nl + ncount - 1) / ncount;
+        ncount     = (nl + job.NSlice - 1) / job.NSlice;
+        parts      = job.MCount * ncount;
+
+        if ((parts < 2)
+            || ((double)parts * (double)(job.MSlice + job.NSlice)
+                > (double)((size_t)-1 / sizeof(BigNumDigit)))
+            || (job.Parts = (BigNum)malloc((size_t)parts
+                                           * (job.MSlice + job.NSlice)
+                                           * sizeof(BigNumDigit))) == NULL) {
+                return BnnMultiplySerial(pp, pl, mm, ml, nn, nl);
+        }
+
+        BnnParallelFor(parts, BnnMultiplyPart, &job);
+
+        for (k = 0; k < parts; ++k) {
+                const BigNumLength mo = (k % job.MCount) * job.MSlice;
+                const BigNumLength no = (k / job.MCount) * job.NSlice;
+                const BigNumLength ql = ((ml - mo < job.MSlice) ? ml - mo : job.MSlice)
+                                      + ((nl - no < job.NSlice) ? nl - no : job.NSlice);
+
+                if (BnnAdd(pp + mo + no,
+                           pl - mo - no,
+                           job.Parts + k * (job.MSlice + job.NSlice),
+                           ql,
+                           BN_NOCARRY) == BN_CARRY) {
+                        c = BN_CARRY;
+                }
+        }
+
+        free(job.Parts);
+
+        return c;
+}
+
 /** @cond */
 #define BNN_COMPARE_DIGITS(d1, d2) (d1 == d2)
 /** @endcond */
@@ -1216,15 +1506,15 @@ BnnCompare(const BigNum mm,
         if (ml != nl) {
                 return (ml > nl) ? BN_GT : BN_LT;
         } else {
-                int d;
+                BigNumLength d;
 
                 /*
                  * loop starting from most significant digit
                  */
 
-                for (d = (int)(nl - 1); d >= 0; --d) {
-                        if (mm[d] != nn[d]) {
-                                return (mm[d] > nn[d]) ? BN_GT : BN_LT;
+                for (d = nl; d > 0; --d) {
+                        if (mm[d - 1] != nn[d - 1]) {
+                                return (mm[d - 1] > nn[d - 1]) ? BN_GT : BN_LT;
                         }
                 }
 
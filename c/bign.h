@@ -126,6 +126,10 @@ typedef BigNumDigit *   BigNum;         /* A big number is a digit pointer */
 typedef BigNumDigit     BigNumProduct;  /* The product of two digits       */
 #if defined(BN_EXPERIMENTAL_128BITX)
 typedef __uint128_t     BigNumLength;   /* The length of a bignum          */
+#elif defined(BN_64BIT_LENGTH) && defined(HAVE_STDINT_H)
+typedef uint64_t        BigNumLength;   /* The length of a bignum          */
+#elif defined(BN_64BIT_LENGTH)
+typedef unsigned long long BigNumLength; /* The length of a bignum         */
 #else
 typedef unsigned int    BigNumLength;   /* The length of a bignum          */
 #endif
@@ -183,6 +187,11 @@ typedef enum {
  */
 #define BN_DIGIT_SIZE   (sizeof(BigNumDigit) * BN_BYTE_SIZE)
 
+/**
+ * Largest BigNumLength.
+ */
+#define BN_LENGTH_MAX   (~(BigNumLength)0)
+
 /*
  * some constants
  */
@@ -227,6 +236,7 @@ extern BigNumLength BnnNumDigits(const BigNum nn, BigNumLength nl) BN_PURE_FUNCT
 extern BigNumLength BnnNumLength(const BigNum nn, BigNumLength nl) BN_PURE_FUNCTION;
 extern BigNumLength BnnNumCount(const BigNum nn, BigNumLength nl) BN_PURE_FUNCTION;
 extern BigNumLength BnnNumLeadingZeroBitsInDigit(BigNumDigit d) BN_CONST_FUNCTION;
+extern BigNumLength BnnNumTrailingZeroBitsInDigit(BigNumDigit d) BN_CONST_FUNCTION;
 extern void         BnnOrDigits(BigNum n, BigNumDigit d);
 extern void         BnnSetDigit(BigNum nn, BigNumDigit d);
 extern void         BnnSetToZero(BigNum nn, BigNumLength nl);
@@ -60,12 +60,43 @@
 /** @cond */
 typedef enum {
         BQ_COPY,
-        BQ_SET
+        BQ_SET,
+        BQ_SET_CANONICAL
 } BqCreateMode;
+
+#define BzFreeIf(cond, ptr)     if (cond) BzFree(ptr)
+
+/*
+ * Size, in digits, of the BqCompare stack buffer for cross products.
+ */
+#define BQ_CMP_STACK_DIGITS     64
+
+/*
+ * Number of leading bits used by a Lehmer step. Cofactors stay below
+ * 2^BQ_LEHMER_BITS, so all single precision values fit in a BzInt.
+ */
+#define BQ_LEHMER_BITS          28
 /** @endcond */
 
 static BigQ BqCanonicalize(BigQ q);
 static BigQ BqCreateInternal(const BigZ n, const BigZ d, BqCreateMode mode);
+static BigNumBool BqIsOne(const BigZ z);
+static BigZ BqDivExact(const BigZ z, const BigZ g);
+static BigQ BqAddSubtract(BigQ a, BigQ b, BigNumBool subtract);
+static BigZ BqCrossCancel(const BigZ x, const BigZ gx, const BigZ z, const BigZ gz);
+static BigQ BqMultiplyInternal(const BigZ xn, const BigZ xd, const BigZ yn, const BigZ yd);
+static double BqNotANumber(void);
+static BigZ BqMulAdd(const BigZ x, const BigZ a, const BigZ y, BigNumBool subtract);
+static BigZ BqCombine(BzInt a, const BigZ x, BzInt b, const BigZ y);
+static BzInt BqLeadingBits(const BigZ z, BigNumLength shift);
+static BigNumBool BqCFUpdate(BigQCF cf, BigZ a);
+static int BqCFLehmer(BigQCF cf);
+static BigZ BqFromFraction(BzLDouble frac, int *scale);
+static BzLDouble BqToFloat(BigQ q, int mant_dig, BigNumBool ldouble);
+static void BqMultiplyMagnitudes(BigNum pp, const BigNum mm, BigNumLength ml, const BigNum nn, BigNumLength nl);
+static BigNumBool BqAccReduce(BigQAcc acc);
+static BigNumBool BqAccAddSubtract(BigQAcc acc, BigQ b, BigNumBool subtract);
+static BigNumBool BqAccUpdate(BigQAcc acc, BigZ n, BigZ d);
 
 /**
  * BqCreateInternal. Internally create new BigQ using two BigZ for
@@ -73,7 +104,8 @@ static BigQ BqCreateInternal(const BigZ n, const BigZ d, BqCreateMode mode);
  * @param [in] n numerator.
  * @param [in] d denominator.
  * @param [in] mode creation mode. BQ_SET uses n and d to build the new BigZ.
- * BZ_COPY makes a copy of n and d.
+ * BZ_COPY makes a copy of n and d. BQ_SET_CANONICAL is like BQ_SET but
+ * n and d are known to be coprime, so no gcd is computed.
  * @return a new BigQ.
  * @pre
  * - n in Z
@@ -95,7 +127,7 @@ BqCreateInternal(const BigZ n, const BigZ d, BqCreateMode mode) {
          * bigq module only accepts strictly positive denominator.
          */
         if (BzGetSign(d) != BZ_PLUS) {
-                if (mode == BQ_SET) {
+                if (mode != BQ_COPY) {
                         BzFree(d);
                         BzFree(n);
                 }
@@ -106,7 +138,7 @@ BqCreateInternal(const BigZ n, const BigZ d, BqCreateMode mode) {
          * Allow denominator to be negative.
          */
         if (BzGetSign(d) == BZ_ZERO) {
-                if (mode == BQ_SET) {
+                if (mode != BQ_COPY) {
                         BzFree(d);
                         BzFree(n);
                 }
@@ -125,8 +157,8 @@ BqCreateInternal(const BigZ n, const BigZ d, BqCreateMode mode) {
                 BigZ zero;
                 BigZ one;
 
-                if (mode == BQ_SET) {
-                        if (BzToInteger(d) == (BzInt)1) {
+                if (mode != BQ_COPY) {
+                        if (BqIsOne(d) == BN_TRUE) {
                                 /*
                                  * n=0, d=1. Already normalised as 0/1.
                                  */
@@ -188,7 +220,7 @@ BqCreateInternal(const BigZ n, const BigZ d, BqCreateMode mode) {
         BqSetNumerator(q, cn);
         BqSetDenominator(q, cd);
 
-        if (BzLength(cd) != (BigNumLength)1) {
+        if ((mode != BQ_SET_CANONICAL) && (BqIsOne(cd) == BN_FALSE)) {
                 q = BqCanonicalize(q);
         }
 
@@ -213,7 +245,7 @@ BqCanonicalize(BigQ q) {
                 return BQNULL;
         }
 
-        if (BzToInteger(gcd) != (BzInt)1) {
+        if (BqIsOne(gcd) == BN_FALSE) {
                 BigZ nn;
                 BigZ nd;
 
@@ -242,6 +274,372 @@ BqCanonicalize(BigQ q) {
         return q;
 }
 
+/**
+ * BqIsOne.
+ * Tests if z is 1. Unlike BzToInteger(z) == 1, this can't be fooled by
+ * a digit larger than BzInt.
+ * @param [in] z BigZ
+ * @return BN_TRUE if z is 1.
+ */
+static BigNumBool
+BqIsOne(const BigZ z) {
+        if ((BzGetSign(z) == BZ_PLUS)
+            && (BzNumDigits(z) == (BigNumLength)1)
+            && (BzGetDigit(z, 0) == (BigNumDigit)1)) {
+                return BN_TRUE;
+        } else {
+                return BN_FALSE;
+        }
+}
+
+/**
+ * BqDivExact.
+ * Divides z by one of its divisors g. When g is 1, z itself is returned
+ * and no copy is made, so callers must release the result with
+ * BzFreeIf(res != z, res).
+ * @param [in] z BigZ
+ * @param [in] g BigZ, a strictly positive divisor of z.
+ * @return z / g.
+ */
+static BigZ
+BqDivExact(const BigZ z, const BigZ g) {
+        if (BqIsOne(g) == BN_TRUE) {
+                return z;
+        } else {
+                return BzDiv(z, g);
+        }
+}
+
+/**
+ * BqAddSubtract.
+ * Create a new canonicalized BigQ: a + b or a - b.
+ * It uses Knuth's algorithm (TAOCP 4.5.1): with d1 = gcd(ad, bd),
+ * t = an * (bd / d1) +/- bn * (ad / d1) and d2 = gcd(t, d1), the result
+ * is (t / d2) / ((ad / d1) * (bd / d2)) which is already canonical.
+ * All gcds are taken on operands no larger than the inputs, instead of
+ * on the doubled-size cross products.
+ * @param [in] a left hand side BigQ
+ * @param [in] b right hand side BigQ
+ * @param [in] subtract BN_TRUE to compute a - b.
+ * @return BigQ.
+ * @pre a != BQNULL, b != BQNULL
+ */
+static BigQ
+BqAddSubtract(BigQ a, BigQ b, BigNumBool subtract) {
+        const BigZ an = BqGetNumerator(a);
+        const BigZ ad = BqGetDenominator(a);
+        const BigZ bn = BqGetNumerator(b);
+        const BigZ bd = BqGetDenominator(b);
+        BigZ (*addsub)(const BigZ, const BigZ);
+        BigZ n;
+        BigZ d;
+        BigZ d1;
+        BigZ d2;
+        BigZ ad1;
+        BigZ bd1;
+        BigZ tmp1;
+        BigZ tmp2;
+
+        addsub = (subtract == BN_TRUE) ? BzSubtract : BzAdd;
+
+        if (BzGetSign(bn) == BZ_ZERO) {
+                /*
+                 * a +/- 0 = a
+                 */
+                if ((n = BzCopy(an)) == BZNULL) {
+                        return BQNULL;
+                }
+                if ((d = BzCopy(ad)) == BZNULL) {
+                        BzFree(n);
+                        return BQNULL;
+                }
+                return BqCreateInternal(n, d, BQ_SET_CANONICAL);
+        }
+
+        if (BzGetSign(an) == BZ_ZERO) {
+                /*
+                 * 0 +/- b = +/-b
+                 */
+                n = (subtract == BN_TRUE) ? BzNegate(bn) : BzCopy(bn);
+                if (n == BZNULL) {
+                        return BQNULL;
+                }
+                if ((d = BzCopy(bd)) == BZNULL) {
+                        BzFree(n);
+                        return BQNULL;
+                }
+                return BqCreateInternal(n, d, BQ_SET_CANONICAL);
+        }
+
+        if (BqIsOne(bd) == BN_TRUE) {
+                /*
+                 * an/ad +/- bn = (an +/- ad*bn)/ad, already canonical.
+                 */
+                if ((tmp1 = BzMultiply(ad, bn)) == BZNULL) {
+                        return BQNULL;
+                }
+                n = (*addsub)(an, tmp1);
+                BzFree(tmp1);
+                if (n == BZNULL) {
+                        return BQNULL;
+                }
+                if ((d = BzCopy(ad)) == BZNULL) {
+                        BzFree(n);
+                        return BQNULL;
+                }
+                return BqCreateInternal(n, d, BQ_SET_CANONICAL);
+        }
+
+        if (BqIsOne(ad) == BN_TRUE) {
+                /*
+                 * an +/- bn/bd = (an*bd +/- bn)/bd, already canonical.
+                 */
+                if ((tmp1 = BzMultiply(an, bd)) == BZNULL) {
+                        return BQNULL;
+                }
+                n = (*addsub)(tmp1, bn);
+                BzFree(tmp1);
+                if (n == BZNULL) {
+                        return BQNULL;
+                }
+                if ((d = BzCopy(bd)) == BZNULL) {
+                        BzFree(n);
+                        return BQNULL;
+                }
+                return BqCreateInternal(n, d, BQ_SET_CANONICAL);
+        }
+
+        if (BzCompare(ad, bd) == BZ_EQ) {
+                d1 = BzCopy(ad);
+        } else {
+                d1 = BzGcd(ad, bd);
+        }
+
+        if (d1 == BZNULL) {
+                return BQNULL;
+        }
+
+        if ((ad1 = BqDivExact(ad, d1)) == BZNULL) {
+                BzFree(d1);
+                return BQNULL;
+        }
+
+        if ((bd1 = BqDivExact(bd, d1)) == BZNULL) {
+                BzFreeIf(ad1 != ad, ad1);
+                BzFree(d1);
+                return BQNULL;
+        }
+
+        /*
+         * tmp1 = an * bd1 +/- bn * ad1
+         */
+        if ((tmp1 = BzMultiply(an, bd1)) == BZNULL) {
+                BzFreeIf(bd1 != bd, bd1);
+                BzFreeIf(ad1 != ad, ad1);
+                BzFree(d1);
+                return BQNULL;
+        }
+
+        BzFreeIf(bd1 != bd, bd1);
+
+        if ((tmp2 = BzMultiply(bn, ad1)) == BZNULL) {
+                BzFree(tmp1);
+                BzFreeIf(ad1 != ad, ad1);
+                BzFree(d1);
+                return BQNULL;
+        }
+
+        n = (*addsub)(tmp1, tmp2);
+
+        BzFree(tmp2);
+        BzFree(tmp1);
+
+        if (n == BZNULL) {
+                BzFreeIf(ad1 != ad, ad1);
+                BzFree(d1);
+                return BQNULL;
+        }
+
+        if (BzGetSign(n) == BZ_ZERO) {
+                /*
+                 * BqCreateInternal normalizes to 0/1 and frees d1.
+                 */
+                BzFreeIf(ad1 != ad, ad1);
+                return BqCreateInternal(n, d1, BQ_SET);
+        }
+
+        if (BqIsOne(d1) == BN_TRUE) {
+                /*
+                 * Denominators are coprime, d2 = 1.
+                 */
+                d2 = d1;
+        } else {
+                d2 = BzGcd(n, d1);
+                BzFree(d1);
+
+                if (d2 == BZNULL) {
+                        BzFreeIf(ad1 != ad, ad1);
+                        BzFree(n);
+                        return BQNULL;
+                }
+        }
+
+        if ((tmp1 = BqDivExact(n, d2)) == BZNULL) {
+                BzFree(d2);
+                BzFreeIf(ad1 != ad, ad1);
+                BzFree(n);
+                return BQNULL;
+        }
+
+        if (tmp1 != n) {
+                BzFree(n);
+                n = tmp1;
+        }
+
+        /*
+         * d = ad1 * (bd / d2)
+         */
+        if ((tmp2 = BqDivExact(bd, d2)) == BZNULL) {
+                BzFree(d2);
+                BzFreeIf(ad1 != ad, ad1);
+                BzFree(n);
+                return BQNULL;
+        }
+
+        BzFree(d2);
+
+        d = BzMultiply(ad1, tmp2);
+
+        BzFreeIf(tmp2 != bd, tmp2);
+        BzFreeIf(ad1 != ad, ad1);
+
+        if (d == BZNULL) {
+                BzFree(n);
+                return BQNULL;
+        }
+
+        return BqCreateInternal(n, d, BQ_SET_CANONICAL);
+}
+
+/**
+ * BqCrossCancel.
+ * Computes (x / gx) * (z / gz) where gx and gz are divisors of x and z.
+ * @param [in] x BigZ
+ * @param [in] gx BigZ, a strictly positive divisor of x.
+ * @param [in] z BigZ
+ * @param [in] gz BigZ, a strictly positive divisor of z.
+ * @return BigZ
+ */
+static BigZ
+BqCrossCancel(const BigZ x, const BigZ gx, const BigZ z, const BigZ gz) {
+        BigZ xr;
+        BigZ zr;
+        BigZ res;
+
+        if ((xr = BqDivExact(x, gx)) == BZNULL) {
+                return BZNULL;
+        }
+
+        if ((zr = BqDivExact(z, gz)) == BZNULL) {
+                BzFreeIf(xr != x, xr);
+                return BZNULL;
+        }
+
+        res = BzMultiply(xr, zr);
+
+        BzFreeIf(zr != z, zr);
+        BzFreeIf(xr != x, xr);
+
+        return res;
+}
+
+/**
+ * BqMultiplyInternal.
+ * Create a new canonicalized BigQ: (xn * yn) / (xd * yd) where xn/xd and
+ * yn/yd are canonical. gcd(xn, yd) and gcd(yn, xd) are cancelled before
+ * multiplying, which is enough for the result to be canonical.
+ * @param [in] xn BigZ
+ * @param [in] xd BigZ
+ * @param [in] yn BigZ
+ * @param [in] yd BigZ
+ * @return BigQ.
+ * @pre xd > 0, yd != 0
+ */
+static BigQ
+BqMultiplyInternal(const BigZ xn, const BigZ xd, const BigZ yn, const BigZ yd) {
+        BigZ g1;
+        BigZ g2;
+        BigZ n;
+        BigZ d;
+
+        if ((BzGetSign(xn) == BZ_ZERO) || (BzGetSign(yn) == BZ_ZERO)) {
+                if ((n = BzFromInteger((BzInt)0)) == BZNULL) {
+                        return BQNULL;
+                }
+                if ((d = BzFromInteger((BzInt)1)) == BZNULL) {
+                        BzFree(n);
+                        return BQNULL;
+                }
+                return BqCreateInternal(n, d, BQ_SET_CANONICAL);
+        }
+
+        if ((g1 = BzGcd(xn, yd)) == BZNULL) {
+                return BQNULL;
+        }
+
+        if ((g2 = BzGcd(yn, xd)) == BZNULL) {
+                BzFree(g1);
+                return BQNULL;
+        }
+
+        n = BqCrossCancel(xn, g1, yn, g2);
+        d = BqCrossCancel(xd, g2, yd, g1);
+
+        BzFree(g2);
+        BzFree(g1);
+
+        if ((n == BZNULL) || (d == BZNULL)) {
+                BzFree(d);
+                BzFree(n);
+                return BQNULL;
+        }
+
+        if (BzGetSign(d) == BZ_MINUS) {
+                /*
+                 * Only possible for division, move sign to numerator.
+                 */
+                BzSetSign(d, BZ_PLUS);
+                BzSetSign(n, (BzGetSign(n) == BZ_MINUS) ? BZ_PLUS : BZ_MINUS);
+        }
+
+        return BqCreateInternal(n, d, BQ_SET_CANONICAL);
+}
+
+/**
+ * BqMultiplyMagnitudes.
+ * Adds |M| * |N| to P, which must be ml + nl digits long.
+ * @param [in,out] pp BigNum
+ * @param [in] mm BigNum
+ * @param [in] ml BigNumLength
+ * @param [in] nn BigNum
+ * @param [in] nl BigNumLength
+ */
+static void
+BqMultiplyMagnitudes(BigNum pp,
+                     const BigNum mm,
+                     BigNumLength ml,
+                     const BigNum nn,
+                     BigNumLength nl) {
+        /*
+         * BnnMultiply requires Size(M) >= Size(N).
+         */
+        if (ml >= nl) {
+                (void)BnnMultiply(pp, ml + nl, mm, ml, nn, nl);
+        } else {
+                (void)BnnMultiply(pp, ml + nl, nn, nl, mm, ml);
+        }
+}
+
 /*
  * Public interface
  */
@@ -291,56 +689,7 @@ BqAdd(BigQ a, BigQ b) {
         if (a == BQNULL || b == BQNULL) {
                 return BQNULL;
         } else {
-                const BigZ an = BqGetNumerator(a);
-                const BigZ ad = BqGetDenominator(a);
-                const BigZ bn = BqGetNumerator(b);
-                const BigZ bd = BqGetDenominator(b);
-                BigZ n;
-                BigZ d;
-
-                if (BzCompare(ad, bd) == BZ_EQ) {
-                        /*
-                         * Easy, same denominator. Only add numerators.
-                         */
-                        if ((n = BzAdd(an, bn)) == BZNULL) {
-                                return BQNULL;
-                        }
-
-                        if ((d = BzCopy(ad)) == BZNULL) {
-                                BzFree(n);
-                                return BQNULL;
-                        }
-
-                        return BqCreateInternal(n, d, BQ_SET);
-                } else {
-                        BigZ tmp1;
-                        BigZ tmp2;
-
-                        if ((tmp1 = BzMultiply(an, bd)) == BZNULL) {
-                                return BQNULL;
-                        }
-
-                        if ((tmp2 = BzMultiply(ad, bn)) == BZNULL) {
-                                BzFree(tmp1);
-                                return BQNULL;
-                        }
-
-                        n = BzAdd(tmp1, tmp2);
-
-                        BzFree(tmp1);
-                        BzFree(tmp2);
-
-                        if (n == BZNULL) {
-                                return BQNULL;
-                        }
-
-                        if ((d = BzMultiply(ad, bd)) == BZNULL) {
-                                BzFree(n);
-                                return BQNULL;
-                        }
-
-                        return BqCreateInternal(n, d, BQ_SET);
-                }
+                return BqAddSubtract(a, b, BN_FALSE);
         }
 }
 
@@ -356,92 +705,28 @@ BqSubtract(BigQ a, BigQ b) {
         if (a == BQNULL || b == BQNULL) {
                 return BQNULL;
         } else {
-                const BigZ an = BqGetNumerator(a);
-                const BigZ ad = BqGetDenominator(a);
-                const BigZ bn = BqGetNumerator(b);
-                const BigZ bd = BqGetDenominator(b);
-                BigZ n;
-                BigZ d;
-
-                if (BzCompare(ad, bd) == BZ_EQ) {
-                        /*
-                         * Easy, same denominator. Only subtract numerators.
-                         */
-                        if ((n = BzSubtract(an, bn)) == BZNULL) {
-                                return BQNULL;
-                        }
-
-                        if ((d = BzCopy(ad)) == BZNULL) {
-                                BzFree(n);
-                                return BQNULL;
-                        }
+                return BqAddSubtract(a, b, BN_TRUE);
+        }
+}
 
-                        return BqCreateInternal(n, d, BQ_SET);
-                } else {
-                        BigZ tmp1;
-                        BigZ tmp2;
-
-                        if ((tmp1 = BzMultiply(an, bd)) == BZNULL) {
-                                return BQNULL;
-                        }
-
-                        if ((tmp2 = BzMultiply(ad, bn)) == BZNULL) {
-                                BzFree(tmp1);
-                                return BQNULL;
-                        }
-
-                        if ((n = BzSubtract(tmp1, tmp2)) == BZNULL) {
-                                BzFree(tmp2);
-                                BzFree(tmp1);
-                                return BQNULL;
-                        }
-
-                        d = BzMultiply(ad, bd);
-
-                        BzFree(tmp2);
-                        BzFree(tmp1);
-
-                        if (d == BZNULL) {
-                                BzFree(n);
-                                return BQNULL;
-                        }
-
-                        return BqCreateInternal(n, d, BQ_SET);
-                }
-        }
-}
-
-/**
- * BqMultiply.
- * Create a new canonicalized BigQ: a * b.
- * @param [in] a left hand side BigQ
- * @param [in] b right hand side BigQ
- * @return BigQ. If either a or b is BQNULL, returns BQNULL.
- */
-BigQ
-BqMultiply(BigQ a, BigQ b) {
-        if (a == BQNULL || b == BQNULL) {
-                return BQNULL;
-        } else {
-                const BigZ an = BqGetNumerator(a);
-                const BigZ ad = BqGetDenominator(a);
-                const BigZ bn = BqGetNumerator(b);
-                const BigZ bd = BqGetDenominator(b);
-                BigZ n;
-                BigZ d;
-
-                if ((n = BzMultiply(an, bn)) == BZNULL) {
-                        return BQNULL;
-                }
-
-                if ((d = BzMultiply(ad, bd)) == BZNULL) {
-                        BzFree(n);
-                        return BQNULL;
-                }
-
-                return BqCreateInternal(n, d, BQ_SET);
-        }
-}
+/**
+ * BqMultiply.
+ * Create a new canonicalized BigQ: a * b.
+ * @param [in] a left hand side BigQ
+ * @param [in] b right hand side BigQ
+ * @return BigQ. If either a or b is BQNULL, returns BQNULL.
+ */
+BigQ
+BqMultiply(BigQ a, BigQ b) {
+        if (a == BQNULL || b == BQNULL) {
+                return BQNULL;
+        } else {
+                return BqMultiplyInternal(BqGetNumerator(a),
+                                          BqGetDenominator(a),
+                                          BqGetNumerator(b),
+                                          BqGetDenominator(b));
+        }
+}
 
 /**
  * BqDiv.
@@ -454,40 +739,27 @@ BigQ
 BqDiv(BigQ a, BigQ b) {
         if (a == BQNULL || b == BQNULL) {
                 return BQNULL;
+        } else if (BzGetSign(BqGetNumerator(b)) == BZ_ZERO) {
+                return BQNULL;
         } else {
-                const BigZ an = BqGetNumerator(a);
-                const BigZ ad = BqGetDenominator(a);
-                const BigZ bn = BqGetNumerator(b);
-                const BigZ bd = BqGetDenominator(b);
-                BigZ n;
-                BigZ d;
-
-                if ((n = BzMultiply(an, bd)) == BZNULL) {
-                        return BQNULL;
-                }
-
-                if ((d = BzMultiply(ad, bn)) == BZNULL) {
-                        BzFree(n);
-                        return BQNULL;
-                }
-
-                if (BzGetSign(n) != BzGetSign(d)) {
-                        BzSetSign(n, BZ_MINUS);
-                } else {
-                        BzSetSign(n, BZ_PLUS);
-                }
-
-                BzSetSign(d, BZ_PLUS);
-
-                return BqCreateInternal(n, d, BQ_SET);
+                /*
+                 * a / b = (an / ad) * (bd / bn)
+                 */
+                return BqMultiplyInternal(BqGetNumerator(a),
+                                          BqGetDenominator(a),
+                                          BqGetDenominator(b),
+                                          BqGetNumerator(b));
         }
 }
 
 /**
  * BqCompare.
  * Compare a and b. It returns BQ_EQ (0) if a == b, BQ_LZ (-1) if a < b and
- * BQ_GT (1) if a > b. When a and b have a different denominator, two BigZ
- * are internally created which may fail. In this case BQ_ERR (100) is returned.
+ * BQ_GT (1) if a > b. Most comparisons are decided by the signs or by the
+ * bit lengths of numerators and denominators. Otherwise the cross products
+ * are computed in a scratch buffer, which is only allocated (and may fail)
+ * for operands larger than BQ_CMP_STACK_DIGITS. In this case BQ_ERR (100)
+ * is returned.
  * This may fool functions like qsort waiting for negative, 0 or positive value.
  * @param [in] a left hand side BigQ
  * @param [in] b right hand side BigQ
@@ -502,51 +774,91 @@ BqCompare(BigQ a, BigQ b) {
                 const BigZ ad = BqGetDenominator(a);
                 const BigZ bn = BqGetNumerator(b);
                 const BigZ bd = BqGetDenominator(b);
-                BigZ tmp1;
-                BigZ tmp2;
-                BzCmp cmp;
-
-                if (BzGetSign(an) != BzGetSign(bn)) {
+                const BzSign sign = BzGetSign(an);
+                BigNumDigit  stack[BQ_CMP_STACK_DIGITS];
+                BigNumDigit *scratch;
+                BigNumLength anl;
+                BigNumLength adl;
+                BigNumLength bnl;
+                BigNumLength bdl;
+                BigNumLength an_bits;
+                BigNumLength bn_bits;
+                BigNumLength ad_bits;
+                BigNumLength bd_bits;
+                BigNumCmp    cmp;
+
+                if (sign != BzGetSign(bn)) {
                         /*
                          * Sign differs, easy case!
                          */
-                        if (BzGetSign(an) == BZ_MINUS) {
-                                return BQ_LT;
-                        } else if (BzGetSign(an) == BZ_ZERO
-                                    && BzGetSign(bn) == BZ_PLUS) {
-                                return BQ_LT;
-                        } else {
-                                return BQ_GT;
-                        }
+                        return (sign < BzGetSign(bn)) ? BQ_LT : BQ_GT;
+                } else if (sign == BZ_ZERO) {
+                        return BQ_EQ;
                 } else if (BzCompare(ad, bd) == BZ_EQ) {
                         /*
                          * Easy, same denominator. Only compare numerators.
-                         * This works also if a == b == 0 because a and b
-                         * are canonicalized and their denominator is 1.
                          */
-                        cmp = BzCompare(an, bn);
+                        cmp = (BigNumCmp)BzCompare(an, bn);
+                        return (cmp == BN_LT) ? BQ_LT : ((cmp == BN_GT) ? BQ_GT : BQ_EQ);
+                }
+
+                anl = BzNumDigits(an);
+                adl = BzNumDigits(ad);
+                bnl = BzNumDigits(bn);
+                bdl = BzNumDigits(bd);
+
+                /*
+                 * With L(x) the bit length of x > 0, 2^(L(x)-1) <= x < 2^L(x)
+                 * so 2^(L(n)-L(d)-1) < n/d < 2^(L(n)-L(d)+1). When the
+                 * L(n)-L(d) of |a| and |b| differ by at least 2, the
+                 * magnitudes can't overlap.
+                 */
+                an_bits = BnnNumLength(BzToBn(an), anl);
+                ad_bits = BnnNumLength(BzToBn(ad), adl);
+                bn_bits = BnnNumLength(BzToBn(bn), bnl);
+                bd_bits = BnnNumLength(BzToBn(bd), bdl);
+
+                if ((an_bits + bd_bits) >= (bn_bits + ad_bits + 2)) {
+                        cmp = BN_GT;
+                } else if ((bn_bits + ad_bits) >= (an_bits + bd_bits + 2)) {
+                        cmp = BN_LT;
                 } else {
-                        if ((tmp1 = BzMultiply(an, bd)) == BZNULL) {
-                                return BQ_ERR;
-                        }
+                        /*
+                         * Compare |an| * bd and |bn| * ad.
+                         */
+                        BigNumLength l1 = anl + bdl;
+                        BigNumLength l2 = bnl + adl;
 
-                        if ((tmp2 = BzMultiply(ad, bn)) == BZNULL) {
-                                BzFree(tmp1);
+                        if ((l1 + l2) <= (BigNumLength)BQ_CMP_STACK_DIGITS) {
+                                scratch = stack;
+                        } else if ((scratch = (BigNumDigit *)malloc((size_t)(l1 + l2) * sizeof(BigNumDigit))) == NULL) {
                                 return BQ_ERR;
                         }
 
-                        cmp = BzCompare(tmp1, tmp2);
+                        BnnSetToZero(scratch, l1 + l2);
+                        BqMultiplyMagnitudes(scratch, BzToBn(an), anl, BzToBn(bd), bdl);
+                        BqMultiplyMagnitudes(scratch + l1, BzToBn(bn), bnl, BzToBn(ad), adl);
+
+                        cmp = BnnCompare(scratch, l1, scratch + l1, l2);
 
-                        BzFree(tmp2);
-                        BzFree(tmp1);
+                        if (scratch != stack) {
+                                free(scratch);
+                        }
+                }
+
+                if (sign == BZ_MINUS) {
+                        /*
+                         * Magnitudes compare the other way round.
+                         */
+                        cmp = (BigNumCmp)(-(int)cmp);
                 }
 
                 switch (cmp) {
-                case BZ_LT:
+                case BN_LT:
                         return BQ_LT;
-                case BZ_GT:
+                case BN_GT:
                         return BQ_GT;
-                case BZ_EQ:
+                case BN_EQ:
                 default:
                         return BQ_EQ;
                 }
@@ -631,10 +943,312 @@ BqInverse(BigQ a) {
                 const BigZ an = BqGetNumerator(a);
                 const BigZ ad = BqGetDenominator(a);
 
+                if (BzGetSign(an) == BZ_MINUS) {
+                        /*
+                         * Denominator must stay positive, move the sign
+                         * to the new numerator.
+                         */
+                        BigZ n;
+                        BigZ d;
+
+                        if ((n = BzNegate(ad)) == BZNULL) {
+                                return BQNULL;
+                        }
+
+                        if ((d = BzNegate(an)) == BZNULL) {
+                                BzFree(n);
+                                return BQNULL;
+                        }
+
+                        return BqCreateInternal(n, d, BQ_SET);
+                }
+
                 return BqCreateInternal(ad, an, BQ_COPY);
         }
 }
 
+/*
+ * Rational accumulator.
+ *
+ * A BigQAcc holds a rational that is not kept in canonical form: chains of
+ * BqAccAdd, BqAccSubtract and BqAccMultiply only multiply and add, and the
+ * gcd is computed when the value is read with BqAccValue or when the
+ * denominator grows past Limit digits. After each reduction Limit is set
+ * to max(Threshold, 2 * size of the reduced denominator) so that a value
+ * that stays large after reduction isn't reduced again at every step.
+ */
+
+/**
+ * BqAccReduce.
+ * Reduce acc to canonical form in place and update its limit.
+ * @param [in,out] acc BigQAcc
+ * @return BN_TRUE on success. On failure acc is left unchanged.
+ */
+static BigNumBool
+BqAccReduce(BigQAcc acc) {
+        BigZ gcd;
+        BigNumLength dl;
+
+        if ((gcd = BzGcd(acc->N, acc->D)) == BZNULL) {
+                return BN_FALSE;
+        }
+
+        if ((BqIsOne(gcd) == BN_FALSE) && (BzGetSign(gcd) != BZ_ZERO)) {
+                BigZ nn;
+                BigZ nd;
+
+                if ((nn = BzDiv(acc->N, gcd)) == BZNULL) {
+                        BzFree(gcd);
+                        return BN_FALSE;
+                }
+
+                if ((nd = BzDiv(acc->D, gcd)) == BZNULL) {
+                        BzFree(nn);
+                        BzFree(gcd);
+                        return BN_FALSE;
+                }
+
+                BzFree(acc->N);
+                BzFree(acc->D);
+                acc->N = nn;
+                acc->D = nd;
+        }
+
+        BzFree(gcd);
+
+        dl = BzNumDigits(acc->D);
+        acc->Limit = (2 * dl > acc->Threshold) ? 2 * dl : acc->Threshold;
+
+        return BN_TRUE;
+}
+
+/**
+ * BqAccUpdate.
+ * Replace acc value by n/d, reducing it if it grew past the limit.
+ * @param [in,out] acc BigQAcc
+ * @param [in] n new numerator, owned by acc on success.
+ * @param [in] d new denominator, owned by acc on success.
+ * @return BN_TRUE on success.
+ */
+static BigNumBool
+BqAccUpdate(BigQAcc acc, BigZ n, BigZ d) {
+        if ((n == BZNULL) || (d == BZNULL)) {
+                BzFree(d);
+                BzFree(n);
+                return BN_FALSE;
+        }
+
+        BzFree(acc->N);
+        BzFree(acc->D);
+        acc->N = n;
+        acc->D = d;
+
+        if (BzNumDigits(acc->D) > acc->Limit) {
+                /*
+                 * A failed reduction leaves a correct, if large, value.
+                 */
+                (void)BqAccReduce(acc);
+        }
+
+        return BN_TRUE;
+}
+
+/**
+ * BqAccAddSubtract.
+ * acc = acc + b or acc - b, without reduction.
+ * @param [in,out] acc BigQAcc
+ * @param [in] b BigQ
+ * @param [in] subtract BN_TRUE to subtract b.
+ * @return BN_TRUE on success. On failure acc is left unchanged.
+ */
+static BigNumBool
+BqAccAddSubtract(BigQAcc acc, BigQ b, BigNumBool subtract) {
+        const BigZ bn = BqGetNumerator(b);
+        const BigZ bd = BqGetDenominator(b);
+        BigZ (*addsub)(const BigZ, const BigZ);
+        BigZ n;
+        BigZ d;
+        BigZ tmp1;
+        BigZ tmp2;
+
+        addsub = (subtract == BN_TRUE) ? BzSubtract : BzAdd;
+
+        if (BzGetSign(bn) == BZ_ZERO) {
+                return BN_TRUE;
+        }
+
+        if ((BqIsOne(bd) == BN_TRUE) || (BzCompare(acc->D, bd) == BZ_EQ)) {
+                /*
+                 * n/d +/- bn/bd = (n +/- bn*(d/bd))/d
+                 */
+                tmp1 = (BqIsOne(bd) == BN_TRUE) ? BzMultiply(acc->D, bn) : bn;
+
+                if (tmp1 == BZNULL) {
+                        return BN_FALSE;
+                }
+
+                n = (*addsub)(acc->N, tmp1);
+                BzFreeIf(tmp1 != bn, tmp1);
+                return BqAccUpdate(acc, n, BzCopy(acc->D));
+        }
+
+        if ((tmp1 = BzMultiply(acc->N, bd)) == BZNULL) {
+                return BN_FALSE;
+        }
+
+        if ((tmp2 = BzMultiply(acc->D, bn)) == BZNULL) {
+                BzFree(tmp1);
+                return BN_FALSE;
+        }
+
+        n = (*addsub)(tmp1, tmp2);
+        BzFree(tmp2);
+        BzFree(tmp1);
+
+        if (n == BZNULL) {
+                return BN_FALSE;
+        }
+
+        d = BzMultiply(acc->D, bd);
+        return BqAccUpdate(acc, n, d);
+}
+
+/**
+ * BqAccCreate.
+ * Create a new rational accumulator.
+ * @param [in] init initial value, 0 when BQNULL.
+ * @param [in] threshold minimum denominator size, in digits, that triggers
+ * a reduction. BQ_ACC_DEFAULT_THRESHOLD is used when 0.
+ * @return BigQAcc, or BQACCNULL if allocation fails.
+ */
+BigQAcc
+BqAccCreate(BigQ init, BigNumLength threshold) {
+        BigQAcc acc;
+
+        if ((acc = (BigQAcc)malloc(sizeof(BigQAccStruct))) == BQACCNULL) {
+                return BQACCNULL;
+        }
+
+        if (threshold == (BigNumLength)0) {
+                threshold = BQ_ACC_DEFAULT_THRESHOLD;
+        }
+
+        acc->Threshold = threshold;
+        acc->Limit     = threshold;
+
+        if (init == BQNULL) {
+                acc->N = BzFromInteger((BzInt)0);
+                acc->D = BzFromInteger((BzInt)1);
+        } else {
+                acc->N = BzCopy(BqGetNumerator(init));
+                acc->D = BzCopy(BqGetDenominator(init));
+        }
+
+        if ((acc->N == BZNULL) || (acc->D == BZNULL)) {
+                BqAccDelete(acc);
+                return BQACCNULL;
+        }
+
+        return acc;
+}
+
+/**
+ * BqAccDelete.
+ * Free a rational accumulator.
+ * @param [in] acc BigQAcc
+ */
+void
+BqAccDelete(BigQAcc acc) {
+        if (acc != BQACCNULL) {
+                BzFree(acc->N);
+                BzFree(acc->D);
+                free(acc);
+        }
+}
+
+/**
+ * BqAccAdd.
+ * acc = acc + b.
+ * @param [in,out] acc BigQAcc
+ * @param [in] b BigQ
+ * @return BN_TRUE on success. On failure acc is left unchanged.
+ */
+BigNumBool
+BqAccAdd(BigQAcc acc, BigQ b) {
+        if (acc == BQACCNULL || b == BQNULL) {
+                return BN_FALSE;
+        } else {
+                return BqAccAddSubtract(acc, b, BN_FALSE);
+        }
+}
+
+/**
+ * BqAccSubtract.
+ * acc = acc - b.
+ * @param [in,out] acc BigQAcc
+ * @param [in] b BigQ
+ * @return BN_TRUE on success. On failure acc is left unchanged.
+ */
+BigNumBool
+BqAccSubtract(BigQAcc acc, BigQ b) {
+        if (acc == BQACCNULL || b == BQNULL) {
+                return BN_FALSE;
+        } else {
+                return BqAccAddSubtract(acc, b, BN_TRUE);
+        }
+}
+
+/**
+ * BqAccMultiply.
+ * acc = acc * b.
+ * @param [in,out] acc BigQAcc
+ * @param [in] b BigQ
+ * @return BN_TRUE on success. On failure acc is left unchanged.
+ */
+BigNumBool
+BqAccMultiply(BigQAcc acc, BigQ b) {
+        if (acc == BQACCNULL || b == BQNULL) {
+                return BN_FALSE;
+        } else {
+                BigZ n;
+                BigZ d;
+
+                if ((n = BzMultiply(acc->N, BqGetNumerator(b))) == BZNULL) {
+                        return BN_FALSE;
+                }
+
+                d = BzMultiply(acc->D, BqGetDenominator(b));
+                return BqAccUpdate(acc, n, d);
+        }
+}
+
+/**
+ * BqAccValue.
+ * Reduce acc and return its value.
+ * @param [in,out] acc BigQAcc
+ * @return a new canonicalized BigQ.
+ */
+BigQ
+BqAccValue(BigQAcc acc) {
+        BigZ n;
+        BigZ d;
+
+        if (acc == BQACCNULL || BqAccReduce(acc) == BN_FALSE) {
+                return BQNULL;
+        }
+
+        if ((n = BzCopy(acc->N)) == BZNULL) {
+                return BQNULL;
+        }
+
+        if ((d = BzCopy(acc->D)) == BZNULL) {
+                BzFree(n);
+                return BQNULL;
+        }
+
+        return BqCreateInternal(n, d, BQ_SET_CANONICAL);
+}
+
 /*
  * Define QNaN as an array (not a pointer!!!) to let sizeof returns
  * the null terminating string length (including '\000').
@@ -990,239 +1604,782 @@ BqFromString(const BzChar *s, int base) {
         }
 }
 
+/**
+ * BqFromFraction.
+ * Converts a fraction 0 <= frac < 1 to an integer M such that
+ * frac = M * 2^-scale, extracting 16 bits at a time.
+ * @param [in] frac BzLDouble
+ * @param [out] scale int
+ * @return BigZ M.
+ */
+static BigZ
+BqFromFraction(BzLDouble frac, int *scale) {
+        const int chunk  = 16;
+        const int chunks = (BZ_LDBL_MANT_DIG + chunk - 1) / chunk;
+        BigZ      z;
+        int       k;
+
+        z = BzCreate((BigNumLength)(((chunks * chunk) + BN_DIGIT_SIZE - 1)
+                                    / BN_DIGIT_SIZE));
+
+        if (z == BZNULL) {
+                return BZNULL;
+        }
+
+        for (k = chunks - 1; k >= 0; --k) {
+                const BigNumLength bit = (BigNumLength)(k * chunk);
+                const BigNumLength i   = bit / (BigNumLength)BN_DIGIT_SIZE;
+                BigNumDigit        value;
+
+                /*
+                 * Both operations are exact.
+                 */
+                frac  = frac * (BzLDouble)65536.0;
+                value = (BigNumDigit)frac;
+                frac  = frac - (BzLDouble)value;
+
+                BzSetDigit(z, i, BzGetDigit(z, i)
+                                 | (value << (bit % (BigNumLength)BN_DIGIT_SIZE)));
+        }
+
+        if (BnnIsZero(BzToBn(z), BzGetSize(z)) == BN_TRUE) {
+                BzSetSign(z, BZ_ZERO);
+        } else {
+                BzSetSign(z, BZ_PLUS);
+        }
+
+        *scale = chunks * chunk;
+
+        return z;
+}
+
 /**
  * BqFromLongDouble.
- * Find rational approximation to given real number (Farey's method).
+ * Find the best rational approximation of a real number whose
+ * denominator doesn't exceed maxd. num is first converted exactly, then
+ * approximated by BqBestApproximation.
  * @param [in] num long double.
  * @param [in] maxd maximal denominator value.
- * @return BigQ approximation.
+ * @return BigQ approximation. If num is not finite or maxd < 1, returns
+ * BQNULL.
  */
 BigQ
 BqFromLongDouble(BzLDouble num, BzInt maxd) {
-        BzInt   ln = (BzInt)0;  /* lower value = 0/1 */
-        BzInt   ld = (BzInt)1;
-        BzInt   un = (BzInt)1;  /* upper value = 1/0 = oo */
-        BzInt   ud = (BzInt)0;
-        BzInt   rn = (BzInt)1;
-        BzInt   rd = (BzInt)0;
-        BigZ    n;
-        BigZ    d;
-        BigQ    q;
-        int     sign;
+        BzLDouble frac;
+        BigZ      n;
+        BigZ      d;
+        BigZ      zmax;
+        BigQ      exact;
+        BigQ      q;
+        int       exponent;
+        int       scale;
+
+        if ((num != num) || ((num - num) != (BzLDouble)0) || (maxd < (BzInt)1)) {
+                /*
+                 * NaN or infinity.
+                 */
+                return BQNULL;
+        }
 
         /*
-         * See: http://en.wikipedia.org/wiki/Farey_series
-         *      http://wiki.cs.princeton.edu/index.php/Rational.ck
+         * num = frac * 2^exponent = n * 2^(exponent - scale).
          */
+        frac = BzFrexp((num < (BzLDouble)0) ? -num : num, &exponent);
 
-        if (num < (BzLDouble)0.0) {
-                sign = -1;
-                num *= (BzLDouble)-1.0;
-        } else {
-                sign = 1;
+        if ((n = BqFromFraction(frac, &scale)) == BZNULL) {
+                return BQNULL;
         }
 
-        for (;;) {
-                const BzInt mn = ln + un;
-                const BzInt md = ld + ud;
+        exponent -= scale;
 
-                if ((num * (BzLDouble)md) > (BzLDouble)mn) {
-                        if (maxd < md) {
-                                /*
-                                 * return upper.
-                                 */
-                                rn = un;
-                                rd = ud;
-                                break;
-                        } else {
-                                /*
-                                 * set lower to median and continue
-                                 */
-                                ln = mn;
-                                ld = md;
-                                continue;
-                        }
-                } else if ((num * (BzLDouble)md) == (BzLDouble)mn) {
-                        if (maxd >= md) {
-                                /*
-                                 * return median.
-                                 */
-                                rn = mn;
-                                rd = md;
-                                break;
-                        } else if (ld < ud) {
-                                /*
-                                 * return lower.
-                                 */
-                                rn = ln;
-                                rd = ld;
-                                break;
-                        } else {
-                                /*
-                                 * return upper.
-                                 */
-                                rn = un;
-                                rd = ud;
-                                break;
-                        }
-                } else {
-                        if (maxd < md) {
-                                /*
-                                 * return lower.
-                                 */
-                                rn = ln;
-                                rd = ld;
-                                break;
-                        } else {
-                                /*
-                                 * set lower to median and continue
-                                 */
-                                un = mn;
-                                ud = md;
-                                continue;
-                        }
-                }
+        if (num < (BzLDouble)0) {
+                BzSetSign(n, BZ_MINUS);
         }
 
-        if ((n = BzFromInteger(sign * rn)) == BZNULL) {
-                return BQNULL;
+        if (exponent >= 0) {
+                BigZ tmp = BzAsh(n, exponent);
+
+                BzFree(n);
+                n = tmp;
+                d = BzFromInteger((BzInt)1);
+        } else {
+                BigZ one = BzFromInteger((BzInt)1);
+
+                d = (one == BZNULL) ? BZNULL : BzAsh(one, -exponent);
+                BzFree(one);
         }
 
-        if ((d = BzFromInteger(rd)) == BZNULL) {
+        if ((n == BZNULL) || (d == BZNULL)) {
+                BzFree(d);
                 BzFree(n);
                 return BQNULL;
         }
 
-        q = BqCreateInternal(n, d, BQ_SET);
+        if ((exact = BqCreateInternal(n, d, BQ_SET)) == BQNULL) {
+                return BQNULL;
+        }
+
+        if ((zmax = BzFromInteger(maxd)) == BZNULL) {
+                BqDelete(exact);
+                return BQNULL;
+        }
+
+        q = BqBestApproximation(exact, zmax);
+
+        BzFree(zmax);
+        BqDelete(exact);
 
         return q;
 }
 
 /**
  * BqFromDouble.
- * Find rational approximation to given real number (Farey's method).
+ * Find the best rational approximation of a double whose denominator
+ * doesn't exceed maxd, as BqFromLongDouble does.
  * @param [in] num double.
  * @param [in] maxd maximal denominator value.
- * @return BigQ approximation.
+ * @return BigQ approximation. If num is not finite or maxd < 1, returns
+ * BQNULL.
  */
 BigQ
 BqFromDouble(double num, BzInt maxd) {
         return BqFromLongDouble((BzLDouble)num, maxd);
 }
 
-#if defined(isnan)
 /*
- * isnan exists since C99, otherwise (x != x) should work the same.
- * It is said that "NaN values never compare equal to themselves or to
- * other NaN values."
+ * Continued fractions.
+ *
+ * The expansion of n/d is computed by Euclid's algorithm on the pair
+ * (U, V). When U is larger than BQ_LEHMER_BITS bits, Lehmer's method
+ * (Knuth, TAOCP 4.5.2, Algorithm L) finds a batch of partial quotients
+ * from the leading bits of U and V only, and applies the combined
+ * cofactors to U and V in a single multi-precision step. When U is
+ * smaller, the rest of the expansion is done in single precision.
+ * Batched quotients are kept in Pending and returned one at a time.
  */
-#define BqIsNan(x) (x != x) /* isnan(x) */
-#else
-#define BqIsNan(x) (x != x)
-#endif
 
 /**
- * BqToLongDouble.
- * Convert q to a long double approximation.
+ * BqMulAdd.
+ * Computes x + a * y, or x - a * y.
+ * @param [in] x BigZ
+ * @param [in] a BigZ
+ * @param [in] y BigZ
+ * @param [in] subtract BN_TRUE to subtract a * y.
+ * @return BigZ, BZNULL if any of x, a, y is BZNULL or memory is exhausted.
+ */
+static BigZ
+BqMulAdd(const BigZ x, const BigZ a, const BigZ y, BigNumBool subtract) {
+        BigZ tmp;
+        BigZ res;
+
+        if ((x == BZNULL) || (a == BZNULL) || (y == BZNULL)) {
+                return BZNULL;
+        }
+
+        if ((tmp = BzMultiply(a, y)) == BZNULL) {
+                return BZNULL;
+        }
+
+        res = (subtract == BN_TRUE) ? BzSubtract(x, tmp) : BzAdd(x, tmp);
+        BzFree(tmp);
+
+        return res;
+}
+
+/**
+ * BqCombine.
+ * Computes a * x + b * y for single precision cofactors a and b.
+ * @param [in] a BzInt
+ * @param [in] x BigZ
+ * @param [in] b BzInt
+ * @param [in] y BigZ
+ * @return BigZ, BZNULL if memory is exhausted.
+ */
+static BigZ
+BqCombine(BzInt a, const BigZ x, BzInt b, const BigZ y) {
+        BigZ za = BzFromInteger(a);
+        BigZ zb = BzFromInteger(b);
+        BigZ tmp;
+        BigZ res;
+
+        tmp = (za == BZNULL) ? BZNULL : BzMultiply(za, x);
+        res = BqMulAdd(tmp, zb, y, BN_FALSE);
+
+        BzFree(tmp);
+        BzFree(zb);
+        BzFree(za);
+
+        return res;
+}
+
+/**
+ * BqLeadingBits.
+ * Returns BQ_LEHMER_BITS bits of z starting at bit position shift.
+ * @param [in] z BigZ
+ * @param [in] shift BigNumLength
+ * @return BzInt
+ */
+static BzInt
+BqLeadingBits(const BigZ z, BigNumLength shift) {
+        const BigNum       nn  = BzToBn(z);
+        const BigNumLength nl  = BzNumDigits(z);
+        const BigNumLength i   = shift / (BigNumLength)BN_DIGIT_SIZE;
+        const BigNumLength off = shift % (BigNumLength)BN_DIGIT_SIZE;
+        BigNumDigit        v;
+
+        if (i >= nl) {
+                return (BzInt)0;
+        }
+
+        v = nn[i] >> off;
+
+        if ((off != 0) && ((i + 1) < nl)) {
+                v |= nn[i + 1] << ((BigNumLength)BN_DIGIT_SIZE - off);
+        }
+
+        return (BzInt)(v & ((BN_ONE << BQ_LEHMER_BITS) - 1));
+}
+
+/**
+ * BqCFUpdate.
+ * Record a new partial quotient and update convergents:
+ * P = a * P1 + P0, Q = a * Q1 + Q0.
+ * @param [in,out] cf BigQCF
+ * @param [in] a BigZ partial quotient, owned by cf on success.
+ * @return BN_TRUE on success.
+ */
+static BigNumBool
+BqCFUpdate(BigQCF cf, BigZ a) {
+        BigZ p = BqMulAdd(cf->P0, a, cf->P1, BN_FALSE);
+        BigZ q = BqMulAdd(cf->Q0, a, cf->Q1, BN_FALSE);
+
+        if ((p == BZNULL) || (q == BZNULL)) {
+                BzFree(q);
+                BzFree(p);
+                BzFree(a);
+                return BN_FALSE;
+        }
+
+        BzFree(cf->P0);
+        BzFree(cf->Q0);
+        BzFree(cf->Term);
+        cf->P0   = cf->P1;
+        cf->Q0   = cf->Q1;
+        cf->P1   = p;
+        cf->Q1   = q;
+        cf->Term = a;
+
+        return BN_TRUE;
+}
+
+/**
+ * BqCFLehmer.
+ * Compute a batch of partial quotients of U/V into Pending and advance U
+ * and V accordingly.
+ * @param [in,out] cf BigQCF
+ * @return the number of partial quotients found, 0 if a multi-precision
+ * division is needed, -1 if memory is exhausted.
+ * @pre U > V > 0
+ */
+static int
+BqCFLehmer(BigQCF cf) {
+        const BigNumLength len = BnnNumLength(BzToBn(cf->U), BzNumDigits(cf->U));
+        int   count = 0;
+        BigZ  u;
+        BigZ  v;
+
+        if (len <= (BigNumLength)BQ_LEHMER_BITS) {
+                /*
+                 * U and V fit in a BzInt, finish in single precision.
+                 */
+                BzInt su = BzToInteger(cf->U);
+                BzInt sv = BzToInteger(cf->V);
+
+                while ((sv != 0) && (count < BQ_CF_BATCH)) {
+                        const BzInt q = su / sv;
+                        const BzInt t = su - (q * sv);
+
+                        cf->Pending[count++] = q;
+                        su = sv;
+                        sv = t;
+                }
+
+                u = BzFromInteger(su);
+                v = BzFromInteger(sv);
+        } else {
+                const BigNumLength shift = len - (BigNumLength)BQ_LEHMER_BITS;
+                BzInt uh = BqLeadingBits(cf->U, shift);
+                BzInt vh = BqLeadingBits(cf->V, shift);
+                BzInt a  = 1;
+                BzInt b  = 0;
+                BzInt c  = 0;
+                BzInt d  = 1;
+
+                /*
+                 * (uh + a) / (vh + c) and (uh + b) / (vh + d) bound the
+                 * quotient of U / V. While they agree, it is a partial
+                 * quotient of U / V.
+                 */
+                while (count < BQ_CF_BATCH) {
+                        BzInt q;
+                        BzInt t;
+
+                        if (((vh + c) <= 0) || ((vh + d) <= 0)) {
+                                break;
+                        }
+
+                        q = (uh + a) / (vh + c);
+
+                        if (q != ((uh + b) / (vh + d))) {
+                                break;
+                        }
+
+                        cf->Pending[count++] = q;
+
+                        t  = a - (q * c);
+                        a  = c;
+                        c  = t;
+                        t  = b - (q * d);
+                        b  = d;
+                        d  = t;
+                        t  = uh - (q * vh);
+                        uh = vh;
+                        vh = t;
+                }
+
+                if (count == 0) {
+                        return 0;
+                }
+
+                u = BqCombine(a, cf->U, b, cf->V);
+                v = BqCombine(c, cf->U, d, cf->V);
+        }
+
+        if ((u == BZNULL) || (v == BZNULL)) {
+                BzFree(v);
+                BzFree(u);
+                return -1;
+        }
+
+        BzFree(cf->U);
+        BzFree(cf->V);
+        cf->U = u;
+        cf->V = v;
+
+        return count;
+}
+
+/**
+ * BqCFCreate.
+ * Create the state of the continued fraction expansion of q.
  * @param [in] q BigQ
- * @return BigQ. If q == BQNULL and if the implementation supports quiet NaNs
- * it retruns NAN (as defined in math.h). Otherwise it returns 0.0.
+ * @return BigQCF, or BQCFNULL if q is BQNULL or memory is exhausted.
  */
-BzLDouble
-BqToLongDouble(BigQ q) {
+BigQCF
+BqCFCreate(BigQ q) {
+        BigQCF cf;
+
         if (q == BQNULL) {
+                return BQCFNULL;
+        }
+
+        if ((cf = (BigQCF)malloc(sizeof(BigQCFStruct))) == BQCFNULL) {
+                return BQCFNULL;
+        }
+
+        /*
+         * P(-2)/Q(-2) = 0/1 and P(-1)/Q(-1) = 1/0.
+         */
+        cf->U            = BzCopy(BqGetNumerator(q));
+        cf->V            = BzCopy(BqGetDenominator(q));
+        cf->P0           = BzFromInteger((BzInt)0);
+        cf->P1           = BzFromInteger((BzInt)1);
+        cf->Q0           = BzFromInteger((BzInt)1);
+        cf->Q1           = BzFromInteger((BzInt)0);
+        cf->Term         = BZNULL;
+        cf->PendingCount = 0;
+        cf->PendingIndex = 0;
+
+        if ((cf->U == BZNULL) || (cf->V == BZNULL)
+            || (cf->P0 == BZNULL) || (cf->P1 == BZNULL)
+            || (cf->Q0 == BZNULL) || (cf->Q1 == BZNULL)) {
+                BqCFDelete(cf);
+                return BQCFNULL;
+        }
+
+        return cf;
+}
+
+/**
+ * BqCFNext.
+ * Compute the next partial quotient and convergent, available through
+ * BqCFGetTerm, BqCFGetNumerator and BqCFGetDenominator.
+ * The first partial quotient is floor(q), all others are positive.
+ * @param [in,out] cf BigQCF
+ * @return 1 if a new partial quotient was computed, 0 if the expansion
+ * is complete (the last convergent is q itself), -1 on error.
+ */
+int
+BqCFNext(BigQCF cf) {
+        BigZ a;
+        BigZ r;
+
+        if (cf == BQCFNULL) {
+                return -1;
+        }
+
+        if ((cf->PendingIndex == cf->PendingCount)
+            && (BzGetSign(cf->V) != BZ_ZERO)
+            && (cf->Term != BZNULL)) {
+                /*
+                 * Past the first term, U > V > 0.
+                 */
+                int count = BqCFLehmer(cf);
+
+                if (count < 0) {
+                        return -1;
+                }
+
+                cf->PendingCount = count;
+                cf->PendingIndex = 0;
+        }
+
+        if (cf->PendingIndex < cf->PendingCount) {
+                if ((a = BzFromInteger(cf->Pending[cf->PendingIndex])) == BZNULL) {
+                        return -1;
+                }
+
+                if (BqCFUpdate(cf, a) == BN_FALSE) {
+                        return -1;
+                }
+
+                cf->PendingIndex++;
+                return 1;
+        }
+
+        if (BzGetSign(cf->V) == BZ_ZERO) {
+                return 0;
+        }
+
+        /*
+         * Multi-precision step: U/V = a + r/V with 0 <= r < V.
+         */
+        if ((a = BzDivide(cf->U, cf->V, &r)) == BZNULL) {
+                return -1;
+        }
+
+        if (BqCFUpdate(cf, a) == BN_FALSE) {
+                BzFree(r);
+                return -1;
+        }
+
+        BzFree(cf->U);
+        cf->U = cf->V;
+        cf->V = r;
+
+        return 1;
+}
+
+/**
+ * BqCFDelete.
+ * Free the state of a continued fraction expansion.
+ * @param [in] cf BigQCF
+ */
+void
+BqCFDelete(BigQCF cf) {
+        if (cf != BQCFNULL) {
+                BzFree(cf->U);
+                BzFree(cf->V);
+                BzFree(cf->P0);
+                BzFree(cf->P1);
+                BzFree(cf->Q0);
+                BzFree(cf->Q1);
+                BzFree(cf->Term);
+                free(cf);
+        }
+}
+
+/**
+ * BqBestApproximation.
+ * Find the rational closest to q whose denominator doesn't exceed maxd.
+ * Convergents of q are computed until the next denominator exceeds maxd;
+ * the result is either the last convergent or the largest semiconvergent
+ * within bound, whichever is closer (the convergent on ties).
+ * @param [in] q BigQ
+ * @param [in] maxd BigZ maximal denominator value.
+ * @return BigQ. If q is BQNULL or maxd < 1, returns BQNULL.
+ */
+BigQ
+BqBestApproximation(BigQ q, const BigZ maxd) {
+        BigQCF cf;
+        BigZ   pk;
+        BigZ   qk;
+        BigZ   pk1;
+        BigZ   qk1;
+        BigZ   j;
+        BigZ   tmp;
+        BigQ   c1;
+        BigQ   c2;
+        BigQ   res;
+        int    step;
+
+        if ((q == BQNULL) || (maxd == BZNULL) || (BzGetSign(maxd) != BZ_PLUS)) {
+                return BQNULL;
+        }
+
+        if (BzCompare(BqGetDenominator(q), maxd) != BZ_GT) {
+                return BqCreateInternal(BqGetNumerator(q),
+                                        BqGetDenominator(q),
+                                        BQ_COPY);
+        }
+
+        if ((cf = BqCFCreate(q)) == BQCFNULL) {
+                return BQNULL;
+        }
+
+        /*
+         * Q1 of the first convergent is 1 <= maxd and the expansion ends
+         * with Q1 = denominator of q > maxd, so the loop must exit through
+         * the break.
+         */
+        while ((step = BqCFNext(cf)) == 1) {
+                if (BzCompare(BqCFGetDenominator(cf), maxd) == BZ_GT) {
+                        break;
+                }
+        }
+
+        if (step != 1) {
+                BqCFDelete(cf);
+                return BQNULL;
+        }
+
+        /*
+         * Last convergent within bound pk/qk is now P0/Q0, the one
+         * before is (P1 - a * P0)/(Q1 - a * Q0).
+         * The semiconvergent is (pk1 + j * pk)/(qk1 + j * qk) with
+         * j = floor((maxd - qk1) / qk).
+         */
+        pk  = cf->P0;
+        qk  = cf->Q0;
+        pk1 = BqMulAdd(cf->P1, cf->Term, pk, BN_TRUE);
+        qk1 = BqMulAdd(cf->Q1, cf->Term, qk, BN_TRUE);
+        tmp = (qk1 == BZNULL) ? BZNULL : BzSubtract(maxd, qk1);
+        j   = (tmp == BZNULL) ? BZNULL : BzDiv(tmp, qk);
+
+        BzFree(tmp);
+
+        if ((pk1 == BZNULL) || (qk1 == BZNULL) || (j == BZNULL)) {
+                BzFree(j);
+                BzFree(qk1);
+                BzFree(pk1);
+                BqCFDelete(cf);
+                return BQNULL;
+        }
+
+        /*
+         * Convergents and semiconvergents are in lowest terms.
+         */
+        c1 = BqCreateInternal(BzCopy(pk), BzCopy(qk), BQ_SET_CANONICAL);
+
+        if ((c1 == BQNULL) || (BzGetSign(j) == BZ_ZERO)) {
+                c2 = BQNULL;
+        } else {
+                c2 = BqCreateInternal(BqMulAdd(pk1, j, pk, BN_FALSE),
+                                      BqMulAdd(qk1, j, qk, BN_FALSE),
+                                      BQ_SET_CANONICAL);
+        }
+
+        res = c1;
+
+        if (c2 != BQNULL) {
+                BigQ e1 = BqSubtract(q, c1);
+                BigQ e2 = BqSubtract(q, c2);
+                BigQ a1 = BqAbs(e1);
+                BigQ a2 = BqAbs(e2);
+
+                switch (BqCompare(a2, a1)) {
+                case BQ_LT:
+                        res = c2;
+                        break;
+                case BQ_ERR:
+                        res = BQNULL;
+                        break;
+                default:
+                        break;
+                }
+
+                BqDelete(a2);
+                BqDelete(a1);
+                BqDelete(e2);
+                BqDelete(e1);
+        } else if (BzGetSign(j) != BZ_ZERO) {
+                res = BQNULL;
+        }
+
+        if (res != c1) {
+                BqDelete(c1);
+        }
+
+        if (res != c2) {
+                BqDelete(c2);
+        }
+
+        BzFree(j);
+        BzFree(qk1);
+        BzFree(pk1);
+        BqCFDelete(cf);
+
+        return res;
+}
+
+/**
+ * BqNotANumber.
+ * @return NAN when the implementation supports quiet NaNs.
+ */
+static double
+BqNotANumber(void) {
 #if defined(NAN)
-                return (BzLDouble)NAN;
+        return (double)NAN;
 #else
-                return ((BzLDouble)0/(BzLDouble)0);
+        return ((double)0/(double)0);
 #endif
+}
+
+/**
+ * BqToFloat.
+ * Convert q to the nearest floating point value of mant_dig bits.
+ * With s chosen so that |n| * 2^s / d has mant_dig + 2 or mant_dig + 3
+ * bits, the truncated quotient and the remainder (as a sticky bit) are
+ * enough for BzToFloat to round correctly.
+ * @param [in] q BigQ
+ * @param [in] mant_dig precision of the target format.
+ * @param [in] ldouble BN_TRUE to round for long double, else for double.
+ * @return BzLDouble, or NaN if memory is exhausted.
+ */
+static BzLDouble
+BqToFloat(BigQ q, int mant_dig, BigNumBool ldouble) {
+        const BigZ n = BqGetNumerator(q);
+        const BigZ d = BqGetDenominator(q);
+        BigZ       num;
+        BigZ       den;
+        BigZ       quo;
+        BigZ       rem;
+        const BigNumLength nl = BzLength(n);
+        const BigNumLength dl = BzLength(d);
+        BzLDouble  res;
+        long       scale;
+        BigNumBool inexact;
+
+        if (BzGetSign(n) == BZ_ZERO) {
+                return (BzLDouble)0;
+        }
+
+        if (BqIsOne(d) == BN_TRUE) {
+                return (ldouble == BN_TRUE)
+                        ? BzToLongDouble(n)
+                        : (BzLDouble)BzToDouble(n);
+        }
+
+        /*
+         * The shifts below take an int. Lengths further apart than
+         * INT_MAX / 2 bits are far outside any floating point range, the
+         * result is then an infinity or a zero.
+         */
+
+        if ((nl > dl) && (nl - dl > (BigNumLength)(INT_MAX / 2))) {
+                res = (BzLDouble)HUGE_VAL;
+                return (BzGetSign(n) == BZ_MINUS) ? -res : res;
+        }
+
+        if ((dl > nl) && (dl - nl > (BigNumLength)(INT_MAX / 2))) {
+                res = (BzLDouble)0;
+                return (BzGetSign(n) == BZ_MINUS) ? -res : res;
+        }
+
+        scale = (long)(mant_dig + 2)
+                - ((nl >= dl) ? (long)(nl - dl) : -(long)(dl - nl));
+
+        if (BzGetSign(n) == BZ_MINUS) {
+                num = BzNegate(n);
         } else {
-                BzLDouble res;
+                num = BzCopy(n);
+        }
 
-                res = BzToLongDouble(BqGetNumerator(q))
-                       / BzToLongDouble(BqGetDenominator(q));
+        if (num == BZNULL) {
+                return (BzLDouble)BqNotANumber();
+        }
 
-                if (BqIsNan(res)) {
-                        /*
-                         * Naive code above does not work because numerator
-                         * and/or denominator is too big to be converted
-                         * to (long?) double, try harder as the expected
-                         * result may be well below max (long?) double.
-                         * 
-                         * (defun rational-to-float (x)
-                         *    (let ((zdiv  (ash 1 52))
-                         *          (zval  nil)
-                         *          (qtmp  nil)
-                         *          (ztmp  nil)
-                         *          (dres  nil))
-                         *         (setf zval (floor (numerator x)
-                         *                           (denominator x)))
-                         *         (setf qtmp (* (- x zval) zdiv))
-                         *         (setf ztmp (floor (numerator qtmp)
-                         *                           (denominator qtmp)))
-                         *         (setf qtmp (/ ztmp zdiv))
-                         *         (setf dres (+ (float zval) (float qtmp)))
-                         *         dres))
-                         */
-                        BigZ zone;
-                        BigZ zdiv;
-                        BigQ qdiv;
-                        BigQ qtmp1;
-
-                        zone = BzFromInteger((BzInt)1);
-                        zdiv = BzAsh(zone, 52); /* mantissa is on 53 bits */
-                        qdiv = BqCreate(zdiv, zone);
-
-                        {
-                          BigZ zfloor;
-                          BigQ qfloor;
-
-                          zfloor = BzFloor(BqGetNumerator(q),
-                                           BqGetDenominator(q));
-                          qfloor = BqCreate(zfloor, zone);
-                          res    = BzToLongDouble(zfloor);
-                          qtmp1  = BqSubtract(q, qfloor);
-
-                          BqFree(qfloor);
-                          BzFree(zfloor);
-                        }
+        if (scale > 0) {
+                BigZ tmp = BzAsh(num, (int)scale);
+
+                BzFree(num);
+                num = tmp;
+                den = d;
+        } else {
+                den = BzAsh(d, (int)-scale);
+        }
 
-                        {
-                          BigQ qtmp2;
+        if ((num == BZNULL) || (den == BZNULL)) {
+                BzFree(num);
+                BzFreeIf(den != d, den);
+                return (BzLDouble)BqNotANumber();
+        }
 
-                          qtmp2 = BqMultiply(qtmp1, qdiv);
-                          BqFree(qtmp1);
-                          {
-                            BigZ ztmp;
+        quo = BzDivide(num, den, &rem);
 
-                            ztmp  = BzFloor(BqGetNumerator(qtmp2),
-                                            BqGetDenominator(qtmp2));
-                            qtmp1 = BqCreate(ztmp, zdiv);
-                            res  += BqToLongDouble(qtmp1);
+        BzFreeIf(den != d, den);
+        BzFree(num);
 
-                            BqFree(qtmp1);
-                            BzFree(ztmp);
-                          }
-                          BqFree(qtmp2);
-                        }
+        if (quo == BZNULL) {
+                return (BzLDouble)BqNotANumber();
+        }
 
-                        BqFree(qdiv);
-                        BzFree(zdiv);
-                        BzFree(zone);
-                }
+        inexact = (BzGetSign(rem) != BZ_ZERO) ? BN_TRUE : BN_FALSE;
 
-                return res;
+        if (BzGetSign(n) == BZ_MINUS) {
+                BzSetSign(quo, BZ_MINUS);
+        }
+
+        if (ldouble == BN_TRUE) {
+                res = BzToLongDoubleScaled(quo, -scale, inexact);
+        } else {
+                res = (BzLDouble)BzToDoubleScaled(quo, -scale, inexact);
+        }
+
+        BzFree(rem);
+        BzFree(quo);
+
+        return res;
+}
+
+/**
+ * BqToLongDouble.
+ * Convert q to the nearest long double (ties to even).
+ * @param [in] q BigQ
+ * @return long double. If q == BQNULL and if the implementation supports
+ * quiet NaNs it retruns NAN (as defined in math.h). Otherwise it returns 0.0.
+ */
+BzLDouble
+BqToLongDouble(BigQ q) {
+        if (q == BQNULL) {
+                return (BzLDouble)BqNotANumber();
+        } else {
+                return BqToFloat(q, BZ_LDBL_MANT_DIG, BN_TRUE);
         }
 }
 
 /**
  * BqToDouble.
- * Convert q to a double approximation.
+ * Convert q to the nearest double (ties to even).
  * @param [in] q BigQ
- * @return BigQ. If q == BQNULL and if the implementation supports quiet NaNs
- * it retruns NAN (as defined in math.h). Otherwise it returns 0.0.
+ * @return double. If q == BQNULL and if the implementation supports quiet
+ * NaNs it retruns NAN (as defined in math.h). Otherwise it returns 0.0.
  */
 double
 BqToDouble(BigQ q) {
-        return (double)BqToLongDouble(q);
+        if (q == BQNULL) {
+                return BqNotANumber();
+        } else {
+                return (double)BqToFloat(q, BZ_DBL_MANT_DIG, BN_FALSE);
+        }
 }
@@ -96,6 +96,59 @@ typedef struct {
 
 typedef BigQStruct *                    __BigQ;
 
+/**
+ * BigQAcc is a rational accumulator whose value is only reduced to its
+ * canonical form when it is read or when it grows past a threshold.
+ */
+typedef struct {
+        /** numerator, a signed BigZ. */
+        BigZ N;
+        /** denominator, a strictly positive BigZ, not always coprime with N. */
+        BigZ D;
+        /** minimum denominator size (in digits) that triggers a reduction. */
+        BigNumLength Threshold;
+        /** current denominator size (in digits) that triggers a reduction. */
+        BigNumLength Limit;
+} BigQAccStruct;
+
+typedef BigQAccStruct *                 BigQAcc;
+
+/**
+ * Maximum number of partial quotients computed by one Lehmer step of a
+ * BigQCF.
+ */
+#define BQ_CF_BATCH                     64
+
+/**
+ * BigQCF is the state of the continued fraction expansion of a BigQ.
+ * The remaining expansion is the one of U/V, and P1/Q1 is the last
+ * convergent (P0/Q0 the one before).
+ */
+typedef struct {
+        /** remaining numerator. */
+        BigZ U;
+        /** remaining denominator, 0 when the expansion is complete. */
+        BigZ V;
+        /** numerator of the convergent before the last one. */
+        BigZ P0;
+        /** numerator of the last convergent. */
+        BigZ P1;
+        /** denominator of the convergent before the last one. */
+        BigZ Q0;
+        /** denominator of the last convergent. */
+        BigZ Q1;
+        /** last partial quotient. */
+        BigZ Term;
+        /** partial quotients computed ahead by a Lehmer step. */
+        BzInt Pending[BQ_CF_BATCH];
+        /** number of valid entries in Pending. */
+        int PendingCount;
+        /** next entry to return from Pending. */
+        int PendingIndex;
+} BigQCFStruct;
+
+typedef BigQCFStruct *                  BigQCF;
+
 #if !defined(BQ_RATIONAL_TYPE)
 #define BQ_RATIONAL_TYPE
 typedef const BigQStruct *              BigQ;
@@ -138,6 +191,31 @@ typedef const BigQStruct *              BigQ;
 #define BqSetDenominator(q, d)          (__toBqObj(q)->D = (d))
 #endif
 
+/**
+ * NULL BigQAcc.
+ */
+#define BQACCNULL                       ((BigQAcc)0)
+/**
+ * NULL BigQCF.
+ */
+#define BQCFNULL                        ((BigQCF)0)
+/**
+ * Last partial quotient of a BigQCF.
+ */
+#define BqCFGetTerm(cf)                 ((cf)->Term)
+/**
+ * Numerator of the last convergent of a BigQCF.
+ */
+#define BqCFGetNumerator(cf)            ((cf)->P1)
+/**
+ * Denominator of the last convergent of a BigQCF.
+ */
+#define BqCFGetDenominator(cf)          ((cf)->Q1)
+/**
+ * Default BigQAcc reduction threshold, in digits.
+ */
+#define BQ_ACC_DEFAULT_THRESHOLD        ((BigNumLength)16)
+
 /*
  * functions of bigq.c
  */
@@ -162,6 +240,18 @@ extern BigQ BqMultiply(BigQ a, BigQ b);
 extern BigQ BqNegate(BigQ a);
 extern BigQ BqSubtract(BigQ a, BigQ b);
 
+extern BigQAcc    BqAccCreate(BigQ init, BigNumLength threshold);
+extern void       BqAccDelete(BigQAcc acc);
+extern BigNumBool BqAccAdd(BigQAcc acc, BigQ b);
+extern BigNumBool BqAccSubtract(BigQAcc acc, BigQ b);
+extern BigNumBool BqAccMultiply(BigQAcc acc, BigQ b);
+extern BigQ       BqAccValue(BigQAcc acc);
+
+extern BigQ       BqBestApproximation(BigQ q, const BigZ maxd);
+extern BigQCF     BqCFCreate(BigQ q);
+extern int        BqCFNext(BigQCF cf);
+extern void       BqCFDelete(BigQCF cf);
+
 #if 0
 extern BzChar * BqToStringBuffer(BigQ q, int sign, BzChar *buf, size_t *len);
 #endif
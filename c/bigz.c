@@ -55,6 +55,13 @@
  * to that element is a one-bit.  In this way all finite sets can be
  * represented (by positive integers), as well as all sets whose
  * complements are finite (by negative integers).
+ *
+ * Functions only read their BigZ arguments and keep no state between
+ * calls, so any number of threads can use them at the same time, on
+ * shared arguments too, as long as no thread changes a BigZ (with the
+ * BzXxxInPlace functions or BzAshTo) while others read it. Random
+ * states, the BigQ accumulators and continued fractions and BigM
+ * contexts belong to one thread at a time.
  * @version 2.1.0
  * @copyright Digital Equipment Corporation & INRIA, 1988-1989.
  * @copyright Eligis, 1992-2023
@@ -81,21 +88,40 @@
 #include <string.h>
 #include <ctype.h>
 #include <float.h>
+#include <limits.h>
+#include <math.h>
 
 #if !defined(__BIGZ_H)
 #include "./bigz.h"
 #endif
 
+#if !defined(__BNTHREAD_H)
+#include "./bnthread.h"
+#endif
+
 /** @cond */
 #define BzMaxInt(a, b)          (((a) < (b)) ? (b) : (a))
 #define BzAbsInt(x)             (((x) >= 0) ? (x) : -(x))
+#define BzDigitsForBits(n)      ((BigNumLength)((n) / BN_DIGIT_SIZE         \
+                                 + ((((n) % BN_DIGIT_SIZE) != 0) ? 1 : 0)))
 
 #define BZMAXINT                ((BzInt)((~(BzUInt)0) >> 1))
 #define BZMAXUINT               (~(BzUInt)0)
 
 #define BzFreeIf(cond, ptr)     if (cond) BzFree(ptr)
+
+/*
+ * Size, in digits, of the BzDivide stack buffer for the divisor.
+ */
+#define BZ_DIVIDE_STACK_DIGITS  32
 /** @endcond */
 
+#if defined(HAVE_STDINT_H)
+typedef uint32_t BzUInt32;
+#else
+typedef unsigned int BzUInt32;
+#endif
+
 /*
  *      See ./etc/hextable.c if you need to change BigHexToDigit tables.
  */
@@ -190,6 +216,49 @@ static const int BigHexToDigit[] = {
 /** @endcond */
 
 static BzSign   BzGetOppositeSign(const BigZ z);
+static BigZ     BzAddSign(const BigZ y, const BigZ z, BzSign zs);
+static BzCmp    BzCompareMagnitudes(const BigZ y, const BigZ z);
+static BigNumLength BzLowestDigit(const BigZ z);
+static BigNumDigit BzTwosComplementDigit(const BigZ z,
+                                         BigNumLength zl,
+                                         BigNumLength low,
+                                         BigNumLength k);
+static BigNumLength BzScan(const BigZ z, BigNumLength start, BigNumBool value);
+static BigNumLength BzMultiplyAddChunk(BigZ p,
+                                       const BigZ z,
+                                       BigNumLength zl,
+                                       BigNumLength used,
+                                       BigNumDigit scale,
+                                       BigNumDigit chunk);
+#if defined(BZ_OPTIMIZE_PRINT)
+static BzChar * BzPrintDigits(BigZ y,
+                              BigZ q,
+                              BigNumLength zl,
+                              BigNumDigit base,
+                              BzChar *s);
+static BigZ *   BzSplitPowers(BigNumDigit base,
+                              const BigZ z,
+                              int max,
+                              int *count);
+static void     BzSplitFree(BigZ *pieces, BigNumLength n);
+static void     BzSplitDivideTask(void *job, BigNumLength i);
+static void     BzSplitPrintTask(void *job, BigNumLength i);
+static BzChar * BzToStringSplit(const BigZ z, BigNumDigit base, BzChar *s);
+static BigZ     BzFromDigits(const BzChar *s, size_t n, BigNumDigit base);
+static void     BzSplitReadTask(void *job, BigNumLength i);
+static void     BzSplitJoinTask(void *job, BigNumLength i);
+static BigZ     BzFromStringSplit(const BzChar *s, size_t n, BigNumDigit base);
+#endif
+static void     BzExtractDigits(const BigZ z,
+                                BigNumLength start,
+                                BigNumLength len,
+                                BigNum out);
+static BigZ     BzReplaceBits(BigZ z,
+                              BigNumLength start,
+                              BigNumLength len,
+                              BzBooleOp op,
+                              const BigZ v,
+                              BigNumBool copy);
 
 #if defined(BZ_DEBUG)
 static void     BzShowBits(BigNumDigit n);
@@ -437,13 +506,17 @@ static const double BzLog[] = {
  * BzCreate
  * Allocates a zeroed BigZ of the desired size.
  * @param [in] size BigNumLength
- * @return BigZ
+ * @return BigZ, BZNULL if size is above BZ_MAX_DIGITS.
  */
 BigZ
 BzCreate(BigNumLength size) {
         BigZ   z;
         size_t chunk;
 
+        if (size > BZ_MAX_DIGITS) {
+                return BZNULL;
+        }
+
         /*
          * Compute BigZ allocation size taking care of aligment.
          */
@@ -629,16 +702,69 @@ BzCompare(const BigZ y, const BigZ z) {
 }
 
 /**
- * BzAdd
- * Returns y + z.
+ * BzHash.
+ * Returns a hash value computed from the sign and the significant digits
+ * of z (leading zero digits are ignored). Two BigZ that compare BZ_EQ
+ * always have the same hash value.
+ * @param [in] z BigZ
+ * @return BzUInt
+ * @pre z != BZNULL.
+ */
+BzUInt
+BzHash(const BigZ z) {
+        const BigNumLength zl = BzNumDigits(z);
+        BzUInt32     h;
+        BigNumLength i;
+
+        /*
+         * FNV-1a over 32-bit chunks of the digits, seeded with the sign.
+         */
+
+        h = (BzUInt32)2166136261U ^ (BzUInt32)(BzGetSign(z) + 1);
+
+        for (i = 0; i < zl; ++i) {
+                BigNumDigit d = BzGetDigit(z, i);
+                size_t      j;
+
+                for (j = 0;
+                     j < sizeof(BigNumDigit);
+                     j += sizeof(BzUInt32)) {
+                        h ^= (BzUInt32)(d & (BigNumDigit)0xffffffffU);
+                        h *= (BzUInt32)16777619U;
+                        /*
+                         * Two steps to avoid an undefined full width
+                         * shift when BigNumDigit is 32-bit.
+                         */
+                        d = (d >> 16) >> 16;
+                }
+        }
+
+        /*
+         * Final avalanche (MurmurHash3 fmix32).
+         */
+
+        h ^= h >> 16;
+        h *= (BzUInt32)0x85ebca6bU;
+        h ^= h >> 13;
+        h *= (BzUInt32)0xc2b2ae35U;
+        h ^= h >> 16;
+
+        return (BzUInt)h;
+}
+
+/**
+ * BzAddSign
+ * Returns y + z, z taken with the sign zs instead of its own so that
+ * BzSubtract doesn't have to change the sign of its argument.
  * @param [in] y BigZ
  * @param [in] z BigZ
+ * @param [in] zs BzSign
  * @return BigZ
  * @pre y != BZNULL.
  * @pre z != BZNULL.
  */
-BigZ
-BzAdd(const BigZ y, const BigZ z) {
+static BigZ
+BzAddSign(const BigZ y, const BigZ z, BzSign zs) {
         BigZ         n;
         BigNumLength yl;
         BigNumLength zl;
@@ -646,7 +772,7 @@ BzAdd(const BigZ y, const BigZ z) {
         yl = BzNumDigits(y);
         zl = BzNumDigits(z);
 
-        if (BzGetSign(y) == BzGetSign(z)) {
+        if (BzGetSign(y) == zs) {
                 /*
                  * Add magnitudes if signs are the same
                  */
@@ -672,7 +798,7 @@ BzAdd(const BigZ y, const BigZ z) {
                                              BzToBn(y),
                                              yl,
                                              BN_NOCARRY);
-                                BzSetSign(n, BzGetSign(z));
+                                BzSetSign(n, zs);
                         }
                         break;
                 }
@@ -704,7 +830,7 @@ BzAdd(const BigZ y, const BigZ z) {
                                               BzToBn(y),
                                               yl,
                                               BN_CARRY);
-                            BzSetSign(n, BzGetSign(z));
+                            BzSetSign(n, zs);
                         }
                         break;
                 }
@@ -713,6 +839,20 @@ BzAdd(const BigZ y, const BigZ z) {
         return n;
 }
 
+/**
+ * BzAdd
+ * Returns y + z.
+ * @param [in] y BigZ
+ * @param [in] z BigZ
+ * @return BigZ
+ * @pre y != BZNULL.
+ * @pre z != BZNULL.
+ */
+BigZ
+BzAdd(const BigZ y, const BigZ z) {
+        return BzAddSign(y, z, BzGetSign(z));
+}
+
 /**
  * BzSubtract
  * Returns y - z.
@@ -724,17 +864,7 @@ BzAdd(const BigZ y, const BigZ z) {
  */
 BigZ
 BzSubtract(const BigZ y, const BigZ z) {
-        BigZ diff;
-
-        if (y != z) {
-                BzSetSign(z, BzGetOppositeSign(z));
-                diff = BzAdd(y, z);
-                BzSetSign(z, BzGetOppositeSign(z));
-        } else {
-                diff = BzFromInteger((BzInt)0);
-        }
-
-        return diff;
+        return BzAddSign(y, z, BzGetOppositeSign(z));
 }
 
 /**
@@ -792,6 +922,9 @@ BzMultiply(const BigZ y, const BigZ z) {
  */
 BigZ
 BzDivide(const BigZ y, const BigZ z, BigZ *r) {
+        BigNumDigit  stack[BZ_DIVIDE_STACK_DIGITS];
+        BigNum       heap = (BigNum)NULL;
+        BigNum       d;
         BigZ         q;
         BigNumLength yl;
         BigNumLength zl;
@@ -804,18 +937,47 @@ BzDivide(const BigZ y, const BigZ z, BigZ *r) {
 
         yl = BzNumDigits(y);
         zl = BzNumDigits(z);
-        ql = (BigNumLength)BzMaxInt((int)yl - (int)zl + 1, 1) + 1;
-        rl = (BigNumLength)BzMaxInt(zl, yl) + 1;
+        ql = ((yl > zl) ? yl - zl + 1 : (BigNumLength)1) + 1;
+        rl = BzMaxInt(zl, yl) + 1;
+
+        /*
+         * BnnDivide shifts a divisor of several digits left while it
+         * divides, then back. Divide by a copy so that z is only read,
+         * as other threads may be reading it too.
+         */
+
+        d = BzToBn(z);
+
+        if ((zl > (BigNumLength)1)
+            && (BnnIsDigitNormalized(d[zl - 1]) == BN_FALSE)) {
+                if (zl <= (BigNumLength)BZ_DIVIDE_STACK_DIGITS) {
+                        d = stack;
+                } else {
+                        heap = (BigNum)BzAlloc((size_t)zl * sizeof(BigNumDigit));
+
+                        if ((d = heap) == (BigNum)NULL) {
+                                return BZNULL;
+                        }
+                }
+
+                BnnAssign(d, BzToBn(z), zl);
+        }
 
         /*
          * Set up quotient, remainder
          */
 
         if ((q = BzCreate(ql)) == BZNULL) {
+                if (heap != (BigNum)NULL) {
+                        BzFree(heap);
+                }
                 return BZNULL;
         }
 
         if ((*r = BzCreate(rl)) == BZNULL) {
+                if (heap != (BigNum)NULL) {
+                        BzFree(heap);
+                }
                 BzFree(q);
                 return BZNULL;
         }
@@ -826,7 +988,10 @@ BzDivide(const BigZ y, const BigZ z, BigZ *r) {
          * Do the division
          */
 
-        BnnDivide(BzToBn(*r), rl, BzToBn(z), zl);
+        BnnDivide(BzToBn(*r), rl, d, zl);
+        if (heap != (BigNum)NULL) {
+                BzFree(heap);
+        }
         BnnAssign(BzToBn(q), BzToBn(*r) + zl, rl - zl);
         BnnSetToZero(BzToBn(*r) + zl, rl - zl);
         rl = zl;
@@ -1028,6 +1193,22 @@ BzCeiling(const BigZ y, const BigZ z) {
         return q;
 }
 
+/**
+ * BzCompareMagnitudes
+ * Compares |y| with |z| without changing the sign of either, so that
+ * BzRound only reads its divisor.
+ * @param [in] y BigZ
+ * @param [in] z BigZ
+ * @return BzCmp
+ * @pre y != BZNULL.
+ * @pre z != BZNULL.
+ */
+static BzCmp
+BzCompareMagnitudes(const BigZ y, const BigZ z) {
+        return (BzCmp)BnnCompare(BzToBn(y), BzNumDigits(y),
+                                 BzToBn(z), BzNumDigits(z));
+}
+
 /**
  * BzRound.
  * Returns round(y, z).
@@ -1060,14 +1241,12 @@ BzRound(const BigZ y, const BigZ z) {
         if (BzGetSign(q) == BZ_PLUS && BzGetSign(r) != BZ_ZERO) {
                 BigNumDigit one = BN_ONE;
                 BigZ        roundz;
-                BzSign      sign = BzGetSign(z);
 
                 BzSetSign(r, BZ_PLUS);
-                BzSetSign(z, BZ_PLUS);
 
                 roundz = BzAsh(r, 1);
 
-                switch (BzCompare(roundz, z)) {
+                switch (BzCompareMagnitudes(roundz, z)) {
                 case BZ_LT :
                         break;
                 case BZ_EQ :
@@ -1097,21 +1276,18 @@ BzRound(const BigZ y, const BigZ z) {
                         break;
                 }
 
-                BzSetSign(z, sign);
                 BzFree(roundz);
         } else if (BzGetSign(q) == BZ_MINUS && BzGetSign(r) != BZ_ZERO) {
                 /*
                  *      Q < 0, R <> 0, 2*R>= Z : Q-1 => Q
                  */
                 BigZ    roundz;
-                BzSign  sign = BzGetSign(z);
 
                 BzSetSign(r, BZ_PLUS);
-                BzSetSign(z, BZ_PLUS);
 
                 roundz = BzAsh(r, 1);
 
-                switch (BzCompare(roundz, z)) {
+                switch (BzCompareMagnitudes(roundz, z)) {
                 case BZ_LT :
                         break;
                 case BZ_EQ :
@@ -1130,7 +1306,6 @@ BzRound(const BigZ y, const BigZ z) {
                         break;
                 }
 
-                BzSetSign(z, sign);
                 BzFree(roundz);
 
                 if (BnnIsZero(BzToBn(q), ql) == BN_TRUE) {
@@ -1142,16 +1317,14 @@ BzRound(const BigZ y, const BigZ z) {
                  *      Q == 0, sign(Y) == sign(Z):
                  */
                 BigZ    roundz;
-                BzSign  sign = BzGetSign(z);
 
                 BzFree(q);
 
                 BzSetSign(r, BZ_PLUS);
-                BzSetSign(z, BZ_PLUS);
 
                 roundz = BzAsh(r, 1);
 
-                if (BzCompare(roundz, z) == BZ_LT) {
+                if (BzCompareMagnitudes(roundz, z) == BZ_LT) {
                         /*
                          * 2*R< Z : 0 => Q
                          */
@@ -1163,7 +1336,6 @@ BzRound(const BigZ y, const BigZ z) {
                         q = BzFromInteger((BzInt)1);
                 }
 
-                BzSetSign(z, sign);
                 BzFree(roundz);
         }
 
@@ -1262,6 +1434,18 @@ BzIsOdd(const BigZ y) {
 }
 
 /** @cond */
+static const BzChar BzDigitChar[] = {
+        (BzChar)'0', (BzChar)'1', (BzChar)'2', (BzChar)'3',
+        (BzChar)'4', (BzChar)'5', (BzChar)'6', (BzChar)'7',
+        (BzChar)'8', (BzChar)'9', (BzChar)'a', (BzChar)'b',
+        (BzChar)'c', (BzChar)'d', (BzChar)'e', (BzChar)'f',
+        (BzChar)'g', (BzChar)'h', (BzChar)'i', (BzChar)'j',
+        (BzChar)'k', (BzChar)'l', (BzChar)'m', (BzChar)'n',
+        (BzChar)'o', (BzChar)'p', (BzChar)'q', (BzChar)'r',
+        (BzChar)'s', (BzChar)'t', (BzChar)'u', (BzChar)'v',
+        (BzChar)'w', (BzChar)'x', (BzChar)'y', (BzChar)'z'
+};
+
 #if defined(BZ_OPTIMIZE_PRINT)
 typedef struct {
         int MaxDigits;
@@ -1351,6 +1535,87 @@ static const BzPrintTable BzPrintBase[] = {
   { 12, (BigNumDigit)4738381338321616896UL  }  /* 36 */
 };
 #endif /* BZ_BUCKET_SIZE == 64 */
+
+#if (BZ_BUCKET_SIZE == 128)
+/*
+ * 128 bit values can't be written as literals.
+ */
+#define BzDigit128(hi, lo)      (((BigNumDigit)(hi) << 64) | (BigNumDigit)(lo))
+
+static const BzPrintTable BzPrintBase[] = {
+  {   0, BzDigit128(0ULL, 0ULL) }, /*  0 */
+  {   0, BzDigit128(0ULL, 0ULL) }, /*  1 */
+  { 127, BzDigit128(9223372036854775808ULL, 0ULL) }, /*  2 */
+  {  80, BzDigit128(8012732698178659004ULL, 4389419161382147137ULL) }, /*  3 */
+  {  63, BzDigit128(4611686018427387904ULL, 0ULL) }, /*  4 */
+  {  55, BzDigit128(15046327690525280101ULL, 18443565265187884909ULL) }, /*  5 */
+  {  49, BzDigit128(7302835975055466601ULL, 4793518853382471680ULL) }, /*  6 */
+  {  45, BzDigit128(5800855912350686119ULL, 6418094003492566503ULL) }, /*  7 */
+  {  42, BzDigit128(4611686018427387904ULL, 0ULL) }, /*  8 */
+  {  40, BzDigit128(8012732698178659004ULL, 4389419161382147137ULL) }, /*  9 */
+  {  38, BzDigit128(5421010862427522170ULL, 687399551400673280ULL) }, /* 10 */
+  {  37, BzDigit128(18433577465098809272ULL, 15761393731138603419ULL) }, /* 11 */
+  {  35, BzDigit128(3202018886335981248ULL, 0ULL) }, /* 12 */
+  {  34, BzDigit128(4056525925620335540ULL, 16792870168275479849ULL) }, /* 13 */
+  {  33, BzDigit128(3600024487687016150ULL, 860532835608428544ULL) }, /* 14 */
+  {  32, BzDigit128(2338840293712757663ULL, 6010173554614857217ULL) }, /* 15 */
+  {  31, BzDigit128(1152921504606846976ULL, 0ULL) }, /* 16 */
+  {  31, BzDigit128(7550867339096805841ULL, 18061728531547931377ULL) }, /* 17 */
+  {  30, BzDigit128(2467490166612912639ULL, 11869374721818624000ULL) }, /* 18 */
+  {  30, BzDigit128(12493620390476284487ULL, 127425187506712409ULL) }, /* 19 */
+  {  29, BzDigit128(2910383045673370361ULL, 6052837899185946624ULL) }, /* 20 */
+  {  29, BzDigit128(11979531250491222791ULL, 3892128787355474725ULL) }, /* 21 */
+  {  28, BzDigit128(2098530765309976909ULL, 2940274228164820992ULL) }, /* 22 */
+  {  28, BzDigit128(7285505426352410561ULL, 12902298736644519905ULL) }, /* 23 */
+  {  27, BzDigit128(999502313552216064ULL, 0ULL) }, /* 24 */
+  {  27, BzDigit128(3009265538105056020ULL, 7378061867779487305ULL) }, /* 25 */
+  {  27, BzDigit128(8676821689823496974ULL, 7687483363732488192ULL) }, /* 26 */
+  {  26, BzDigit128(890303633130962111ULL, 10735904392214433913ULL) }, /* 27 */
+  {  26, BzDigit128(2291865316808533766ULL, 508906757892866048ULL) }, /* 28 */
+  {  26, BzDigit128(5707267426951356740ULL, 3956720144496099881ULL) }, /* 29 */
+  {  26, BzDigit128(13779482266204840304ULL, 8647495183274868736ULL) }, /* 30 */
+  {  25, BzDigit128(1042611770027323643ULL, 7990788204722213663ULL) }, /* 31 */
+  {  25, BzDigit128(2305843009213693952ULL, 0ULL) }, /* 32 */
+  {  25, BzDigit128(4976554613548808640ULL, 1488478663054897953ULL) }, /* 33 */
+  {  25, BzDigit128(10496710114872989613ULL, 16676044210507350016ULL) }, /* 34 */
+  {  24, BzDigit128(619032345027500994ULL, 3333441703666084321ULL) }, /* 35 */
+  {  24, BzDigit128(1217139329175911100ULL, 3873377154515337216ULL) }  /* 36 */
+};
+#endif /* BZ_BUCKET_SIZE == 128 */
+
+/*
+ * Numbers of more than BZ_SPLIT_DIGITS digits are printed by halves,
+ * split with the powers base^(d * 2^k), d = MaxDigits, down to pieces
+ * of d * 2^BZ_SPLIT_LEAF characters printed d at a time. Dividing by
+ * the powers takes digit products where dividing the whole number by
+ * base^d takes as many digit divisions, which are slower. Strings of
+ * more than BZ_SPLIT_READ_DIGITS digits are read the other way, joining
+ * pieces in pairs; this costs as many digit products as reading them in
+ * one pass, so it is only done when there are threads to share them.
+ * The pieces of a level are handled on the thread pool (BnnParallelFor).
+ */
+#define BZ_SPLIT_DIGITS         ((BigNumLength)64)
+#define BZ_SPLIT_READ_DIGITS    ((BigNumLength)1024)
+#define BZ_SPLIT_LEAF           4
+#define BZ_SPLIT_POWERS         64
+
+/*
+ * A level of a split conversion. To strings, the pieces In[First..] are
+ * divided by Power into Out, End telling where the characters of each
+ * piece end. From strings, Out are the pieces of Width characters of
+ * Text, and In are joined in pairs with Power.
+ */
+typedef struct {
+        BigZ            Power;
+        BigNumDigit     Base;
+        size_t          Width;
+        BigNumLength    First;
+        BigZ *          In;
+        BigZ *          Out;
+        BzChar **       End;
+        const BzChar *  Text;
+        size_t          Length;
+} BzSplitJob;
 #endif /* BZ_OPTIMIZE_PRINT */
 /** @endcond */
 
@@ -1426,22 +1691,11 @@ BzToStringBufferExt(const BigZ z,
                     BzChar * const buf,
                     size_t *len,
                     size_t *slen) {
-        static const BzChar Digit[] = {
-                (BzChar)'0', (BzChar)'1', (BzChar)'2', (BzChar)'3',
-                (BzChar)'4', (BzChar)'5', (BzChar)'6', (BzChar)'7',
-                (BzChar)'8', (BzChar)'9', (BzChar)'a', (BzChar)'b',
-                (BzChar)'c', (BzChar)'d', (BzChar)'e', (BzChar)'f',
-                (BzChar)'g', (BzChar)'h', (BzChar)'i', (BzChar)'j',
-                (BzChar)'k', (BzChar)'l', (BzChar)'m', (BzChar)'n',
-                (BzChar)'o', (BzChar)'p', (BzChar)'q', (BzChar)'r',
-                (BzChar)'s', (BzChar)'t', (BzChar)'u', (BzChar)'v',
-                (BzChar)'w', (BzChar)'x', (BzChar)'y', (BzChar)'z'
-        };
-
         BigZ         y;
         BigZ         q;
         BigNumLength zl;
-        BigNumLength sl;
+        size_t       sl;
+        double       dl;
         BzChar *     s;
         BzChar *     slast;
         BzChar *     strg;
@@ -1459,16 +1713,28 @@ BzToStringBufferExt(const BigZ z,
          */
 
         zl = BzNumDigits(z) + 1;
-        sl = (BigNumLength)((BzLog[2] * BN_DIGIT_SIZE * zl) / BzLog[base] + 3);
+        dl = (BzLog[2] * BN_DIGIT_SIZE * (double)zl) / BzLog[base] + 3;
+
+        if (dl >= (double)((size_t)-1)) {
+                /*
+                 * More characters than a size_t counts.
+                 */
+                if (len != 0) {
+                        *len = 0;
+                }
+                return (BzChar *)NULL;
+        }
+
+        sl = (size_t)dl;
 
         if (buf != (BzChar *)NULL
             && len != (size_t *)NULL
-            && (sl > (BigNumLength)*len)) {
+            && (sl > *len)) {
                 /*
                  * a buffer is passed but there is not enough room,
                  * return NULL and set required size in len.
                  */
-                *len = (size_t)sl;
+                *len = sl;
                 return (BzChar *)NULL;
         }
 
@@ -1493,7 +1759,7 @@ BzToStringBufferExt(const BigZ z,
         if (buf != (BzChar *)NULL) {
                 strg = buf;
         } else {
-                strg = (BzChar *)BzStringAlloc((size_t)sl);
+                strg = (BzChar *)BzStringAlloc(sl);
                 if (strg == (BzChar *)NULL) {
                         BzFree(y);
                         BzFree(q);
@@ -1504,7 +1770,7 @@ BzToStringBufferExt(const BigZ z,
                          * a buffer is allocated and caller wants to know
                          * allocated size.
                          */
-                        *len = (size_t)sl;
+                        *len = sl;
                 }
         }
 
@@ -1522,71 +1788,17 @@ BzToStringBufferExt(const BigZ z,
                 *--s = (BzChar)'0';
 #if defined(BZ_OPTIMIZE_PRINT)
         } else {
-                /*
-                 * Compute maxval and digits that can be used with
-                 * this base.
-                 */
-
-                BigNumDigit  maxval = (BigNumDigit)BzPrintBase[base].MaxValue;
-                BigNumLength digits = (BigNumLength)BzPrintBase[base].MaxDigits;
-
-                /*
-                 * This optimization makes BigZ output 10 to 20x faster.
-                 */
-                do {
-                        BigZ        v;
-                        BigNumDigit r;
-                        /*
-                         * compute: y div maxval => q,
-                         * returns r = y mod maxval
-                         *
-                         * maxval is the greatest integer in base 'base'
-                         * that fits in a BigNumDigit.
-                         */
+                BzChar *t = (BzChar *)NULL;
 
-                        r = BnnDivideDigit(BzToBn(q),
-                                           BzToBn(y),
-                                           zl,
-                                           maxval);
-
-                        if (BnnIsZero(BzToBn(q), zl) == BN_FALSE) {
-                                /*
-                                 * More digits to come on left, add exactly
-                                 * the number of digits with possible
-                                 * leading 0 (when r becomes 0).
-                                 */
-                                int i;
-                                for (i = 0; i < (int)digits; ++i) {
-                                        if (r == 0) {
-                                                /*
-                                                 * No need to divide, fill
-                                                 * the rest with '0'.
-                                                 */
-                                                *--s = (BzChar)'0';
-                                        } else {
-                                                *--s = Digit[r % base];
-                                                r = r / base;
-                                        }
-                                }
-                        } else {
-                                /*
-                                 * Last serie (top left). Print only available
-                                 * digits (stop when r becomes 0).
-                                 */
-                                while (r != 0) {
-                                        *--s = Digit[r % base];
-                                        r = r / base;
-                                }
-                        }
+                if (zl > BZ_SPLIT_DIGITS) {
+                        t = BzToStringSplit(z, base, s);
+                }
 
-                        /*
-                         * exchange y and q (to avoid BzMove(y, q))
-                         */
+                if (t == (BzChar *)NULL) {
+                        t = BzPrintDigits(y, q, zl, base, s);
+                }
 
-                        v = q;
-                        q = y;
-                        y = v;
-                } while (BnnIsZero(BzToBn(y), zl) == BN_FALSE);
+                s = t;
         }
 #else   /* BZ_OPTIMIZE_PRINT */
         } else {
@@ -1596,7 +1808,7 @@ BzToStringBufferExt(const BigZ z,
                         /* compute: y div base => q, returns r = y mod base */
 
                         r = BnnDivideDigit(BzToBn(q), BzToBn(y), zl, base);
-                        *--s = Digit[r];
+                        *--s = BzDigitChar[r];
 
                         /*
                          * exchange y and q (to avoid BzMove(y, q))
@@ -1679,120 +1891,788 @@ BzToStringBufferExt(const BigZ z,
         return strg;
 }
 
+#if defined(BZ_OPTIMIZE_PRINT)
 /**
- * BzStrLen.
- * @param [in] s const BzChar 
- * @return size_t
- * @pre s != NULL.
- */
-size_t
-BzStrLen(const BzChar *s) {
-        size_t len;
-
-        for (len = (size_t)0; *s++ != (BzChar)'\000'; ++len) {
-                continue;
-        }
-
-        return len;
-}
-
-/**
- * BzFromStringLen.
- * Creates a BigZ whose value is represented by "string" in the
- * specified base.  The "string" may contain leading spaces, followed
- * by an optional sign, followed by a series of digits. Assumes
- * BZ_MIN_BASE<=base<=BZ_MAX_BASE.  When called from C, only the
- * first 2 arguments are passed. The BzStrFlag flag controls the characters
- * that can be ignored.
- * Depending on base valid characters are
- * "0123456789abcdefghijklmnopqrstuvwxy". Alphabetic characters can be either
- * upper or lower case.
- * @param [in] s const BzChar 
- * @param [in] len string length.
+ * BzPrintDigits.
+ * Writes the digits of y in base to the left of s, MaxDigits characters
+ * per division by BzPrintBase[base].MaxValue. Overwrites y and q.
+ * @param [in] y BigZ of zl digits, the highest one zero.
+ * @param [in] q BigZ of zl digits.
+ * @param [in] zl BigNumLength
  * @param [in] base BigNumDigit
- * @param [in] flag BzStrFlag to tell how we stop reading the string. By
- *             default, BZ_UNTIL_END reads until the end of string.
- *             The BZ_UNTIL_SLASH value is used by bigq to read rational numbers
- *             and stop on '/' character.
- * @return BigZ
- * @pre base in range [BZ_MIN_BASE .. BZ_MAX_BASE].
+ * @param [out] s BzChar * end of the digits.
+ * @return the first digit written.
  */
-BigZ
-BzFromStringLen(const BzChar *s, size_t len, BigNumDigit base, BzStrFlag flag) {
-        BigZ         z;
-        BigZ         p;
-        BzSign       sign;
-        BigNumLength zl;
-        size_t       i;
-
-        if (s == (const BzChar*)NULL) {
-                return BZNULL;
-        }
-
-        if ((base < 2) || (base > 36)) {
-                return BZNULL;
-        }
-
+static BzChar *
+BzPrintDigits(BigZ y, BigZ q, BigNumLength zl, BigNumDigit base, BzChar *s) {
         /*
-         * Throwaway any initial space
+         * Compute maxval and digits that can be used with
+         * this base.
          */
 
-        while (BZ_ISSPACE(*s)) {
-                ++s;
-                --len;
-        }
+        BigNumDigit  maxval = (BigNumDigit)BzPrintBase[base].MaxValue;
+        BigNumLength digits = (BigNumLength)BzPrintBase[base].MaxDigits;
 
         /*
-         * Set up sign, base, initialize result
+         * This optimization makes BigZ output 10 to 20x faster.
          */
+        do {
+                BigZ        v;
+                BigNumDigit r;
+                /*
+                 * compute: y div maxval => q,
+                 * returns r = y mod maxval
+                 *
+                 * maxval is the greatest integer in base 'base'
+                 * that fits in a BigNumDigit.
+                 */
 
-        switch (*s) {
-        case ((BzChar)'-'):
-                sign = BZ_MINUS;
-                ++s;
-                --len;
-                break;
-        case ((BzChar)'+'):
-                sign = BZ_PLUS;
-                ++s;
-                --len;
-                break;
-        default:
-                sign = BZ_PLUS;
-        }
+                r = BnnDivideDigit(BzToBn(q),
+                                   BzToBn(y),
+                                   zl,
+                                   maxval);
+
+                if (BnnIsZero(BzToBn(q), zl) == BN_FALSE) {
+                        /*
+                         * More digits to come on left, add exactly
+                         * the number of digits with possible
+                         * leading 0 (when r becomes 0).
+                         */
+                        int i;
+                        for (i = 0; i < (int)digits; ++i) {
+                                if (r == 0) {
+                                        /*
+                                         * No need to divide, fill
+                                         * the rest with '0'.
+                                         */
+                                        *--s = (BzChar)'0';
+                                } else {
+                                        *--s = BzDigitChar[r % base];
+                                        r = r / base;
+                                }
+                        }
+                } else {
+                        /*
+                         * Last serie (top left). Print only available
+                         * digits (stop when r becomes 0).
+                         */
+                        while (r != 0) {
+                                *--s = BzDigitChar[r % base];
+                                r = r / base;
+                        }
+                }
 
-        if (BZ_ISSIGN(*s) || (*s == (BzChar)0)) {
                 /*
-                 * There must be at most one sign.
+                 * exchange y and q (to avoid BzMove(y, q))
                  */
-                return BZNULL;
-        }
 
-        /*
-         * Allocate BigNums
-         */
+                v = q;
+                q = y;
+                y = v;
+        } while (BnnIsZero(BzToBn(y), zl) == BN_FALSE);
 
-        zl = (BigNumLength)(((double)len * BzLog[base])
-                            / (BzLog[2] * BN_DIGIT_SIZE) + 1);
+        return s;
+}
 
-        if ((z = BzCreate(zl)) == BZNULL) {
-                return BZNULL;
+/**
+ * BzSplitPowers.
+ * Computes the powers base^(d * 2^k), k = 0, 1, ... of a split
+ * conversion, where d is BzPrintBase[base].MaxDigits. Stops after max
+ * powers or, when z is not BZNULL, before the first power above z.
+ * @param [in] base BigNumDigit
+ * @param [in] z BigZ or BZNULL
+ * @param [in] max int at most BZ_SPLIT_POWERS.
+ * @param [out] count int * number of powers.
+ * @return the powers, to free with BzSplitFree, or NULL when out of memory.
+ */
+static BigZ *
+BzSplitPowers(BigNumDigit base, const BigZ z, int max, int *count) {
+        BigZ *pw;
+        BigZ  p;
+        int   n = 0;
+
+        if ((pw = (BigZ *)malloc(BZ_SPLIT_POWERS * sizeof(BigZ))) == NULL) {
+                return (BigZ *)NULL;
         }
 
-        if ((p = BzCreate(zl)) == BZNULL) {
-                BzFree(z);
-                return BZNULL;
+        if ((p = BzCreate((BigNumLength)1)) == BZNULL) {
+                free(pw);
+                return (BigZ *)NULL;
         }
 
-        /*
-         * Multiply in the digits of the string, one at a time
-         */
+        BnnSetDigit(BzToBn(p), BzPrintBase[base].MaxValue);
+        BzSetSign(p, BZ_PLUS);
 
-        for (i = 0; i < len; ++i) {
-                BzChar      c    = s[i];
-                int         val  = CTOI(c);
-                BigNumDigit next = (BigNumDigit)val;
-                BigZ        v;
+        for (;;) {
+                if (z != BZNULL && BzCompare(p, z) == BZ_GT) {
+                        BzFree(p);
+                        break;
+                }
+
+                pw[n++] = p;
+
+                if (n == max) {
+                        break;
+                }
+
+                if ((p = BzMultiply(p, p)) == BZNULL) {
+                        BzSplitFree(pw, (BigNumLength)n);
+                        return (BigZ *)NULL;
+                }
+        }
+
+        *count = n;
+        return pw;
+}
+
+/**
+ * BzSplitFree.
+ * Frees the pieces that are not BZNULL and the array holding them.
+ * @param [in] pieces BigZ *
+ * @param [in] n BigNumLength number of pieces.
+ */
+static void
+BzSplitFree(BigZ *pieces, BigNumLength n) {
+        BigNumLength i;
+
+        for (i = 0; i < n; ++i) {
+                if (pieces[i] != BZNULL) {
+                        BzFree(pieces[i]);
+                }
+        }
+
+        free(pieces);
+}
+
+/**
+ * BzSplitDivideTask.
+ * Divides the piece First + i of a level by Power, the quotient being the
+ * higher piece of the next level. Outputs BZNULL when out of memory.
+ * @param [in] job BzSplitJob *
+ * @param [in] i BigNumLength
+ */
+static void
+BzSplitDivideTask(void *job, BigNumLength i) {
+        const BzSplitJob * const j = (const BzSplitJob *)job;
+        const BigNumLength       k = 2 * i + j->First;
+        BigZ                     r = BZNULL;
+        BigZ                     q;
+
+        q = BzDivide(j->In[j->First + i], j->Power, &r);
+
+        if (q == BZNULL && r != BZNULL) {
+                BzFree(r);
+                r = BZNULL;
+        }
+
+        j->Out[k]     = q;
+        j->Out[k + 1] = r;
+}
+
+/**
+ * BzSplitPrintTask.
+ * Prints the piece i of the last level to the left of End[i], with
+ * leading zeros up to Width characters unless it is the top piece, and
+ * replaces End[i] with its first character, NULL when out of memory.
+ * @param [in] job BzSplitJob *
+ * @param [in] i BigNumLength
+ */
+static void
+BzSplitPrintTask(void *job, BigNumLength i) {
+        const BzSplitJob * const j  = (const BzSplitJob *)job;
+        const BigNumLength       yl = BzNumDigits(j->In[i]) + 1;
+        BzChar * const           e  = j->End[i];
+        BzChar *                 s  = e;
+        BigZ                     y;
+        BigZ                     q;
+
+        if ((y = BzCreate(yl)) == BZNULL) {
+                j->End[i] = (BzChar *)NULL;
+                return;
+        }
+
+        if ((q = BzCreate(yl)) == BZNULL) {
+                BzFree(y);
+                j->End[i] = (BzChar *)NULL;
+                return;
+        }
+
+        BnnAssign(BzToBn(y), BzToBn(j->In[i]), yl - 1);
+
+        if (BnnIsZero(BzToBn(y), yl) == BN_FALSE) {
+                s = BzPrintDigits(y, q, yl, j->Base, s);
+        }
+
+        if (i != 0) {
+                while (s > e - j->Width) {
+                        *--s = (BzChar)'0';
+                }
+        }
+
+        BzFree(y);
+        BzFree(q);
+
+        j->End[i] = s;
+}
+
+/**
+ * BzToStringSplit.
+ * Writes the digits of z in base to the left of s, dividing it by the
+ * powers of BzSplitPowers into pieces printed in parallel.
+ * @param [in] z BigZ not zero.
+ * @param [in] base BigNumDigit
+ * @param [out] s BzChar * end of the digits.
+ * @return the first digit written, or NULL when z is too small to be
+ * split or out of memory.
+ */
+static BzChar *
+BzToStringSplit(const BigZ z, BigNumDigit base, BzChar *s) {
+        BzSplitJob   job;
+        BigZ         a;
+        BigZ *       pw;
+        BigZ *       in;
+        BigZ *       out;
+        BzChar **    end;
+        BzChar **    next;
+        BzChar *     first = (BzChar *)NULL;
+        BigNumLength n;
+        BigNumLength size;
+        BigNumLength i;
+        int          levels;
+        int          k;
+
+        if ((a = BzAbs(z)) == BZNULL) {
+                return (BzChar *)NULL;
+        }
+
+        pw = BzSplitPowers(base, a, BZ_SPLIT_POWERS, &levels);
+
+        if (pw == (BigZ *)NULL || levels <= BZ_SPLIT_LEAF) {
+                BzFree(a);
+                if (pw != (BigZ *)NULL) {
+                        BzSplitFree(pw, (BigNumLength)levels);
+                }
+                return (BzChar *)NULL;
+        }
+
+        /*
+         * a < pw[levels - 1]^2, it is split (levels - BZ_SPLIT_LEAF) times.
+         */
+
+        size = (BigNumLength)1 << (levels - BZ_SPLIT_LEAF);
+        in   = (BigZ *)calloc((size_t)size, sizeof(BigZ));
+        out  = (BigZ *)calloc((size_t)size, sizeof(BigZ));
+        end  = (BzChar **)malloc((size_t)size * sizeof(BzChar *));
+        next = (BzChar **)malloc((size_t)size * sizeof(BzChar *));
+
+        if (in == (BigZ *)NULL
+            || out == (BigZ *)NULL
+            || end == (BzChar **)NULL
+            || next == (BzChar **)NULL) {
+                BzFree(a);
+                n = 0;
+        } else {
+                in[0]  = a;
+                end[0] = s;
+                n      = 1;
+        }
+
+        job.Base = base;
+
+        for (k = levels - 1; n != 0 && k >= BZ_SPLIT_LEAF; --k) {
+                BigZ *    v;
+                BzChar ** w;
+
+                job.Power = pw[k];
+                job.Width = (size_t)BzPrintBase[base].MaxDigits << k;
+                job.In    = in;
+                job.Out   = out;
+
+                /*
+                 * The top piece may already be below the power.
+                 */
+
+                if (BzCompare(in[0], pw[k]) == BZ_LT) {
+                        job.First = 1;
+                        out[0]    = in[0];
+                        next[0]   = end[0];
+                        in[0]     = BZNULL;
+                } else {
+                        job.First = 0;
+                }
+
+                BnnParallelFor(n - job.First, BzSplitDivideTask, &job);
+
+                for (i = job.First; i < n; ++i) {
+                        next[2 * i - job.First]     = end[i] - job.Width;
+                        next[2 * i - job.First + 1] = end[i];
+                        BzFree(in[i]);
+                        in[i] = BZNULL;
+                }
+
+                n = 2 * n - job.First;
+
+                v   = in;
+                in  = out;
+                out = v;
+                w    = end;
+                end  = next;
+                next = w;
+
+                for (i = 0; i < n; ++i) {
+                        if (in[i] == BZNULL) {
+                                break;
+                        }
+                }
+
+                if (i < n) {
+                        for (i = 0; i < n; ++i) {
+                                if (in[i] != BZNULL) {
+                                        BzFree(in[i]);
+                                        in[i] = BZNULL;
+                                }
+                        }
+                        n = 0;
+                }
+        }
+
+        if (n != 0) {
+                job.In    = in;
+                job.End   = end;
+                job.Width = (size_t)BzPrintBase[base].MaxDigits
+                            << BZ_SPLIT_LEAF;
+
+                BnnParallelFor(n, BzSplitPrintTask, &job);
+
+                for (i = 0; i < n; ++i) {
+                        if (end[i] == (BzChar *)NULL) {
+                                break;
+                        }
+                }
+
+                if (i == n) {
+                        first = end[0];
+                }
+        }
+
+        BzSplitFree(pw, (BigNumLength)levels);
+
+        if (in != (BigZ *)NULL) {
+                BzSplitFree(in, n);
+        }
+
+        free(out);
+        free(end);
+        free(next);
+
+        return first;
+}
+#endif  /* BZ_OPTIMIZE_PRINT */
+
+/**
+ * BzStrLen.
+ * @param [in] s const BzChar 
+ * @return size_t
+ * @pre s != NULL.
+ */
+size_t
+BzStrLen(const BzChar *s) {
+        size_t len;
+
+        for (len = (size_t)0; *s++ != (BzChar)'\000'; ++len) {
+                continue;
+        }
+
+        return len;
+}
+
+/**
+ * BzMultiplyAddChunk.
+ * Computes z * scale + chunk => p for BzFromStringLen, only over the
+ * digits of z in use. The value read so far is at most the final one,
+ * so it fits in the zl digits of z and p.
+ * @param [out] p BigZ whose digits above used + 1 are zero.
+ * @param [in] z BigZ
+ * @param [in] zl BigNumLength size of z and p.
+ * @param [in] used BigNumLength number of digits of z.
+ * @param [in] scale BigNumDigit
+ * @param [in] chunk BigNumDigit
+ * @return the number of digits of p.
+ */
+static BigNumLength
+BzMultiplyAddChunk(BigZ p,
+                   const BigZ z,
+                   BigNumLength zl,
+                   BigNumLength used,
+                   BigNumDigit scale,
+                   BigNumDigit chunk) {
+        const BigNumLength pl = (used < zl) ? used + 1 : zl;
+
+        BnnSetToZero(BzToBn(p), pl);
+        BnnSetDigit(BzToBn(p), chunk);
+        (void)BnnMultiplyDigit(BzToBn(p), pl, BzToBn(z), used, scale);
+
+        return BnnNumDigits(BzToBn(p), pl);
+}
+
+#if defined(BZ_OPTIMIZE_PRINT)
+/**
+ * BzFromDigits.
+ * Reads n valid digits in base, MaxDigits at a time.
+ * @param [in] s const BzChar *
+ * @param [in] n size_t
+ * @param [in] base BigNumDigit
+ * @return BigZ, BZNULL when out of memory.
+ */
+static BigZ
+BzFromDigits(const BzChar *s, size_t n, BigNumDigit base) {
+        const int    maxdigits = BzPrintBase[base].MaxDigits;
+        BigNumLength zl;
+        BigNumLength used  = (BigNumLength)1;
+        BigNumDigit  chunk = (BigNumDigit)0;
+        BigNumDigit  scale = (BigNumDigit)1;
+        int          count = 0;
+        size_t       i;
+        BigZ         z;
+        BigZ         p;
+
+        zl = (BigNumLength)(((double)n * BzLog[base])
+                            / (BzLog[2] * BN_DIGIT_SIZE) + 1);
+
+        if ((z = BzCreate(zl)) == BZNULL) {
+                return BZNULL;
+        }
+
+        if ((p = BzCreate(zl)) == BZNULL) {
+                BzFree(z);
+                return BZNULL;
+        }
+
+        for (i = 0; i < n; ++i) {
+                chunk = chunk * base + (BigNumDigit)CTOI(s[i]);
+                scale = scale * base;
+
+                if (++count == maxdigits || i + 1 == n) {
+                        BigZ v;
+
+                        used  = BzMultiplyAddChunk(p,
+                                                   z,
+                                                   zl,
+                                                   used,
+                                                   scale,
+                                                   chunk);
+                        chunk = (BigNumDigit)0;
+                        scale = (BigNumDigit)1;
+                        count = 0;
+
+                        v = p;
+                        p = z;
+                        z = v;
+                }
+        }
+
+        BzSetSign(z, (BnnIsZero(BzToBn(z), zl) == BN_TRUE) ? BZ_ZERO : BZ_PLUS);
+        BzFree(p);
+
+        return z;
+}
+
+/**
+ * BzSplitReadTask.
+ * Reads the piece i of Text, its Width characters ending i * Width
+ * characters before the end (fewer for the top piece).
+ * @param [in] job BzSplitJob *
+ * @param [in] i BigNumLength
+ */
+static void
+BzSplitReadTask(void *job, BigNumLength i) {
+        const BzSplitJob * const j = (const BzSplitJob *)job;
+        const size_t             e = j->Length - (size_t)i * j->Width;
+        const size_t             b = (e > j->Width) ? e - j->Width : 0;
+
+        j->Out[i] = BzFromDigits(j->Text + b, e - b, j->Base);
+}
+
+/**
+ * BzSplitJoinTask.
+ * Joins the pieces 2i (lower) and 2i + 1 of a level into the piece i of
+ * the next one, BZNULL when out of memory.
+ * @param [in] job BzSplitJob *
+ * @param [in] i BigNumLength
+ */
+static void
+BzSplitJoinTask(void *job, BigNumLength i) {
+        const BzSplitJob * const j = (const BzSplitJob *)job;
+        BigZ                     h;
+
+        if ((h = BzMultiply(j->In[2 * i + 1], j->Power)) == BZNULL) {
+                j->Out[i] = BZNULL;
+                return;
+        }
+
+        j->Out[i] = BzAdd(h, j->In[2 * i]);
+        BzFree(h);
+}
+
+/**
+ * BzFromStringSplit.
+ * Reads n valid digits in base as pieces read in parallel, then joined
+ * in pairs with the powers of BzSplitPowers.
+ * @param [in] s const BzChar *
+ * @param [in] n size_t
+ * @param [in] base BigNumDigit
+ * @return BigZ, BZNULL when out of memory.
+ */
+static BigZ
+BzFromStringSplit(const BzChar *s, size_t n, BigNumDigit base) {
+        BzSplitJob   job;
+        BigZ *       pw;
+        BigZ *       in;
+        BigZ *       out;
+        BigZ         z = BZNULL;
+        BigNumLength pieces;
+        BigNumLength i;
+        int          levels;
+        int          count;
+        int          k;
+
+        job.Base   = base;
+        job.Text   = s;
+        job.Length = n;
+        job.Width  = (size_t)BzPrintBase[base].MaxDigits << BZ_SPLIT_LEAF;
+        pieces     = (BigNumLength)((n + job.Width - 1) / job.Width);
+
+        /*
+         * Joining the pieces takes ceil(log2(pieces)) levels.
+         */
+
+        levels = BZ_SPLIT_LEAF;
+
+        while (((BigNumLength)1 << (levels - BZ_SPLIT_LEAF)) < pieces) {
+                ++levels;
+        }
+
+        pw = BzSplitPowers(base, BZNULL, levels, &count);
+
+        if (pw == (BigZ *)NULL) {
+                return BZNULL;
+        }
+
+        in  = (BigZ *)calloc((size_t)pieces, sizeof(BigZ));
+        out = (BigZ *)calloc((size_t)pieces, sizeof(BigZ));
+
+        if (in != (BigZ *)NULL && out != (BigZ *)NULL) {
+                job.Out = in;
+                BnnParallelFor(pieces, BzSplitReadTask, &job);
+        } else {
+                pieces = 0;
+        }
+
+        for (k = BZ_SPLIT_LEAF; pieces > 1; ++k) {
+                BigNumLength m = pieces / 2;
+                BigZ *       v;
+
+                for (i = 0; i < pieces; ++i) {
+                        if (in[i] == BZNULL) {
+                                break;
+                        }
+                }
+
+                if (i < pieces) {
+                        break;
+                }
+
+                job.Power = pw[k];
+                job.In    = in;
+                job.Out   = out;
+
+                BnnParallelFor(m, BzSplitJoinTask, &job);
+
+                for (i = 0; i < 2 * m; ++i) {
+                        BzFree(in[i]);
+                        in[i] = BZNULL;
+                }
+
+                if ((pieces & 1) != 0) {
+                        /*
+                         * The top piece has no pair at this level.
+                         */
+                        out[m++]       = in[pieces - 1];
+                        in[pieces - 1] = BZNULL;
+                }
+
+                v      = in;
+                in     = out;
+                out    = v;
+                pieces = m;
+        }
+
+        if (pieces == 1) {
+                z     = in[0];
+                in[0] = BZNULL;
+        }
+
+        BzSplitFree(pw, (BigNumLength)count);
+
+        if (in != (BigZ *)NULL) {
+                BzSplitFree(in, pieces);
+        }
+
+        free(out);
+
+        return z;
+}
+#endif  /* BZ_OPTIMIZE_PRINT */
+
+/**
+ * BzFromStringLen.
+ * Creates a BigZ whose value is represented by "string" in the
+ * specified base.  The "string" may contain leading spaces, followed
+ * by an optional sign, followed by a series of digits. Assumes
+ * BZ_MIN_BASE<=base<=BZ_MAX_BASE.  When called from C, only the
+ * first 2 arguments are passed. The BzStrFlag flag controls the characters
+ * that can be ignored.
+ * Depending on base valid characters are
+ * "0123456789abcdefghijklmnopqrstuvwxy". Alphabetic characters can be either
+ * upper or lower case.
+ * @param [in] s const BzChar 
+ * @param [in] len string length.
+ * @param [in] base BigNumDigit
+ * @param [in] flag BzStrFlag to tell how we stop reading the string. By
+ *             default, BZ_UNTIL_END reads until the end of string.
+ *             The BZ_UNTIL_SLASH value is used by bigq to read rational numbers
+ *             and stop on '/' character.
+ * @return BigZ
+ * @pre base in range [BZ_MIN_BASE .. BZ_MAX_BASE].
+ */
+BigZ
+BzFromStringLen(const BzChar *s, size_t len, BigNumDigit base, BzStrFlag flag) {
+        BigZ         z;
+        BigZ         p;
+        BzSign       sign;
+        BigNumLength zl;
+        double       dl;
+        BigNumLength used;
+        BigNumDigit  chunk;
+        BigNumDigit  scale;
+        int          count;
+        int          maxdigits;
+        size_t       i;
+
+        if (s == (const BzChar*)NULL) {
+                return BZNULL;
+        }
+
+        if ((base < 2) || (base > 36)) {
+                return BZNULL;
+        }
+
+        /*
+         * Throwaway any initial space
+         */
+
+        while (BZ_ISSPACE(*s)) {
+                ++s;
+                --len;
+        }
+
+        /*
+         * Set up sign, base, initialize result
+         */
+
+        switch (*s) {
+        case ((BzChar)'-'):
+                sign = BZ_MINUS;
+                ++s;
+                --len;
+                break;
+        case ((BzChar)'+'):
+                sign = BZ_PLUS;
+                ++s;
+                --len;
+                break;
+        default:
+                sign = BZ_PLUS;
+        }
+
+        if (BZ_ISSIGN(*s) || (*s == (BzChar)0)) {
+                /*
+                 * There must be at most one sign.
+                 */
+                return BZNULL;
+        }
+
+        /*
+         * Allocate BigNums
+         */
+
+        dl = ((double)len * BzLog[base]) / (BzLog[2] * BN_DIGIT_SIZE) + 1;
+
+        if (dl > (double)BZ_MAX_DIGITS) {
+                return BZNULL;
+        }
+
+        zl = (BigNumLength)dl;
+
+        if ((z = BzCreate(zl)) == BZNULL) {
+                return BZNULL;
+        }
+
+        if ((p = BzCreate(zl)) == BZNULL) {
+                BzFree(z);
+                return BZNULL;
+        }
+
+        /*
+         * Multiply in the digits of the string, as many at a time as fit
+         * in a BigNumDigit: chunk holds the value of the count pending
+         * ones and scale is base^count.
+         */
+
+#if defined(BZ_OPTIMIZE_PRINT)
+        maxdigits = BzPrintBase[base].MaxDigits;
+#else
+        maxdigits = 1;
+#endif
+        used  = (BigNumLength)1;
+        chunk = (BigNumDigit)0;
+        scale = (BigNumDigit)1;
+        count = 0;
+        i     = 0;
+
+#if defined(BZ_OPTIMIZE_PRINT)
+        /*
+         * A long run of leading digits is read by BzFromStringSplit, the
+         * rest of the string by the loop below.
+         */
+
+        while (i < len && CTOI(s[i]) != -1 && (BigNumDigit)CTOI(s[i]) < base) {
+                ++i;
+        }
+
+        if (i > (size_t)BZ_SPLIT_READ_DIGITS * (size_t)maxdigits
+            && BnnGetThreads() > 1) {
+                BigZ x;
+
+                if ((x = BzFromStringSplit(s, i, base)) == BZNULL) {
+                        BzFree(p);
+                        BzFree(z);
+                        return BZNULL;
+                }
+
+                used = BzNumDigits(x);
+                BnnAssign(BzToBn(z), BzToBn(x), used);
+                BzFree(x);
+        } else {
+                i = 0;
+        }
+#endif
+
+        for (; i < len; ++i) {
+                BzChar      c    = s[i];
+                int         val  = CTOI(c);
+                BigNumDigit next = (BigNumDigit)val;
+                BigZ        v;
 
                 if ((val == -1) || (next >= base)) {
                         if (i != 0) {
@@ -1840,13 +2720,29 @@ BzFromStringLen(const BzChar *s, size_t len, BigNumDigit base, BzStrFlag flag) {
                         return BZNULL;
                 }
 
-                BnnSetToZero(BzToBn(p), zl);
-                BnnSetDigit(BzToBn(p), next);
-                (void)BnnMultiplyDigit(BzToBn(p), zl, BzToBn(z), zl, base);
+                chunk = chunk * base + next;
+                scale = scale * base;
 
-                /*
-                 * exchange z and p (to avoid BzMove (z, p)
-                 */
+                if (++count == maxdigits) {
+                        used  = BzMultiplyAddChunk(p, z, zl, used, scale, chunk);
+                        chunk = (BigNumDigit)0;
+                        scale = (BigNumDigit)1;
+                        count = 0;
+
+                        /*
+                         * exchange z and p (to avoid BzMove (z, p)
+                         */
+
+                        v = p;
+                        p = z;
+                        z = v;
+                }
+        }
+
+        if (count != 0) {
+                BigZ v;
+
+                (void)BzMultiplyAddChunk(p, z, zl, used, scale, chunk);
 
                 v = p;
                 p = z;
@@ -1948,60 +2844,175 @@ BzToInteger(const BigZ z) {
         }
 }
 
+/** @cond */
+#define BZ_FLOAT_CHUNK_BITS     16
+/** @endcond */
+
 /**
- * BzToLongDouble.
- * It converts BigZ z to long double approximation. Conversion is
- * inaccurate and looses precision if number most significant digits
- * exceed long double mantissa size.
- * It returns +inf/-inf if z exceeds max double values.
+ * BzBnBits.
+ * Returns bits [pos, pos + count) of N.
+ * @param [in] nn BigNum
+ * @param [in] nl BigNumLength
+ * @param [in] pos BigNumLength bit position.
+ * @param [in] count number of bits, at most BZ_FLOAT_CHUNK_BITS.
+ * @return BigNumDigit
+ */
+static BigNumDigit
+BzBnBits(const BigNum nn, BigNumLength nl, BigNumLength pos, int count) {
+        BigNumLength i   = pos / (BigNumLength)BN_DIGIT_SIZE;
+        BigNumLength off = pos % (BigNumLength)BN_DIGIT_SIZE;
+        BigNumDigit  v   = nn[i] >> off;
+
+        if (((off + (BigNumLength)count) > (BigNumLength)BN_DIGIT_SIZE)
+            && ((i + 1) < nl)) {
+                v |= nn[i + 1] << ((BigNumLength)BN_DIGIT_SIZE - off);
+        }
+
+        return v & (((BigNumDigit)1 << count) - 1);
+}
+
+/**
+ * BzBnHasBitsBelow.
+ * Tests if any of the bits [0, pos) of N is set.
+ * @param [in] nn BigNum
+ * @param [in] pos BigNumLength bit position.
+ * @return BN_TRUE if one of those bits is set.
+ */
+static BigNumBool
+BzBnHasBitsBelow(const BigNum nn, BigNumLength pos) {
+        BigNumLength i   = pos / (BigNumLength)BN_DIGIT_SIZE;
+        BigNumLength off = pos % (BigNumLength)BN_DIGIT_SIZE;
+        BigNumLength d;
+
+        for (d = 0; d < i; ++d) {
+                if (nn[d] != BN_ZERO) {
+                        return BN_TRUE;
+                }
+        }
+
+        if ((off != 0) && ((nn[i] & ((BN_ONE << off) - 1)) != 0)) {
+                return BN_TRUE;
+        }
+
+        return BN_FALSE;
+}
+
+/**
+ * BzToFloat.
+ * Converts |z| * 2^scale to the nearest floating point value with mant_dig
+ * bits of precision and minimal exponent min_exp (as in <float.h>), ties
+ * to even. Only the mant_dig + 1 most significant bits are extracted, the
+ * others are only tested for a sticky bit, so the cost doesn't depend on
+ * the size of z. Subnormal results are rounded once, at their actual
+ * precision, and overflow yields an infinity.
  * @param [in] z BigZ
- * @return long double
- * @pre z != BZNULL.
+ * @param [in] scale binary exponent applied to z.
+ * @param [in] inexact BN_TRUE if the value to convert is actually
+ * slightly above |z| * 2^scale (by less than 2^scale), for example
+ * because z is a truncated quotient. In this case z must have more than
+ * mant_dig significant bits.
+ * @param [in] mant_dig precision of the target format.
+ * @param [in] min_exp minimal exponent of the target format.
+ * @return BzLDouble, with the sign of z.
  */
-BzLDouble
-BzToLongDouble(const BigZ z) {
-        const size_t nl  = (size_t)BzNumDigits(z);
-        const BigNum nn  = BzToBn(z);
-        BzLDouble    res = (BzLDouble)nn[nl - 1]; /* highest bucket */
+static BzLDouble
+BzToFloat(const BigZ z,
+          long scale,
+          BigNumBool inexact,
+          int mant_dig,
+          int min_exp) {
+        const BigNum nn = BzToBn(z);
+        BigNumLength nl;
+        BigNumLength pos;
+        long         len;
+        long         exponent;
+        long         shift;
+        int          count;
+        BigNumBool   sticky;
+        BzLDouble    m;
+        BzLDouble    res;
+
+        if (BzGetSign(z) == BZ_ZERO) {
+                return (BzLDouble)0;
+        }
+
+        nl       = BzNumDigits(z);
+        len      = (long)BnnNumLength(nn, nl);
+        exponent = len + scale;
+
+        /*
+         * Subnormal values lose one bit of precision per exponent below
+         * min_exp.
+         */
+        if (exponent < (long)min_exp) {
+                mant_dig -= (int)((long)min_exp - exponent);
+        }
 
-        if (nl > 1) {
+        shift = len - (long)mant_dig;
+
+        if (shift <= 0) {
                 /*
-                 * n spans on more than one bucket.
-                 *
-                 * Caution: ideally, we would like to compute
-                 * (1 << BZ_BUCKET_SIZE) as the factor to apply to combine
-                 * buckets. As it overflows, we use two steps:
-                 * (1 << (BZ_BUCKET_SIZE - 1)) => factor
-                 * factor * 2 => factor.
+                 * z fits in the mantissa.
                  */
-                BzLDouble factor = (BzLDouble)((BzUInt)1
-                                               << (BzUInt)(BZ_BUCKET_SIZE - 1))
-                                   * 2.0;
-                size_t d;
+                shift = 0;
+        } else if (shift > len) {
+                /*
+                 * Less than half of the smallest subnormal.
+                 */
+                return (BzGetSign(z) == BZ_MINUS) ? -(BzLDouble)0 : (BzLDouble)0;
+        }
+
+        /*
+         * Extract bits [shift, len) in chunks, exactly as the result has
+         * at most mant_dig bits.
+         */
+        m = (BzLDouble)0;
+
+        for (pos = (BigNumLength)len; pos > (BigNumLength)shift; pos -= (BigNumLength)count) {
+                count = (int)(pos - (BigNumLength)shift);
+
+                if (count > BZ_FLOAT_CHUNK_BITS) {
+                        count = BZ_FLOAT_CHUNK_BITS;
+                }
+
+                m = (m * (BzLDouble)((BigNumDigit)1 << count))
+                    + (BzLDouble)BzBnBits(nn, nl, pos - (BigNumLength)count, count);
+        }
 
+        if (shift > 0) {
                 /*
-                 * Improve accuracy by adding the second highest bucket.
+                 * Round to nearest, ties to even.
                  */
-                res = (res * factor) + (BzLDouble)nn[nl - 2];
+                BigNumBool round = (BzBnBits(nn, nl, (BigNumLength)(shift - 1), 1) != 0)
+                                   ? BN_TRUE : BN_FALSE;
 
-                for (d = nl - 2; d > 0; --d) {
-                        /*
-                         * Don't waste our time summing buckets after the two
-                         * first ones as they are below mantissa.
-                         * It's sufficient to ajust res exponent by the number
-                         * of remaining buckets.
-                         */
-                        res = (res * factor);
+                sticky = inexact;
 
-                        if (res > BZ_DBL_MAX) {
-                                /*
-                                 * reached inifinty.
-                                 */
-                                break;
-                        }
+                if (sticky == BN_FALSE) {
+                        sticky = BzBnHasBitsBelow(nn, (BigNumLength)(shift - 1));
+                }
+
+                if ((round == BN_TRUE)
+                    && ((sticky == BN_TRUE)
+                        || ((shift < len)
+                            && (BzBnBits(nn, nl, (BigNumLength)shift, 1) != 0)))) {
+                        m += (BzLDouble)1;
                 }
         }
 
+        /*
+         * Keep the exponent in int range, ldexp saturates well before.
+         */
+        exponent = shift + scale;
+
+        if (exponent > (long)INT_MAX) {
+                exponent = (long)INT_MAX;
+        } else if (exponent < (long)INT_MIN) {
+                exponent = (long)INT_MIN;
+        }
+
+        res = BzLdexp(m, (int)exponent);
+
         if (BzGetSign(z) == BZ_MINUS) {
                 return -res;
         } else {
@@ -2009,11 +3020,22 @@ BzToLongDouble(const BigZ z) {
         }
 }
 
+/**
+ * BzToLongDouble.
+ * It converts BigZ z to the nearest long double (ties to even).
+ * It returns +inf/-inf if z exceeds max long double values.
+ * @param [in] z BigZ
+ * @return long double
+ * @pre z != BZNULL.
+ */
+BzLDouble
+BzToLongDouble(const BigZ z) {
+        return BzToFloat(z, 0L, BN_FALSE, BZ_LDBL_MANT_DIG, BZ_LDBL_MIN_EXP);
+}
+
 /**
  * BzToDouble.
- * It converts BigZ z to double approximation. Conversion is
- * inaccurate and looses precision if number most significant digits
- * exceed double mantissa size.
+ * It converts BigZ z to the nearest double (ties to even).
  * It returns +inf/-inf if z exceeds max double values.
  * @param [in] z BigZ
  * @return double
@@ -2021,7 +3043,39 @@ BzToLongDouble(const BigZ z) {
  */
 double
 BzToDouble(const BigZ z) {
-        return (double)BzToLongDouble(z);
+        return (double)BzToFloat(z, 0L, BN_FALSE, BZ_DBL_MANT_DIG, BZ_DBL_MIN_EXP);
+}
+
+/**
+ * BzToLongDoubleScaled.
+ * It converts z * 2^scale to the nearest long double (ties to even).
+ * @param [in] z BigZ
+ * @param [in] scale binary exponent.
+ * @param [in] inexact BN_TRUE if the value to convert is slightly above
+ * |z| * 2^scale (by less than 2^scale). z must then have more than
+ * BZ_LDBL_MANT_DIG significant bits.
+ * @return long double
+ * @pre z != BZNULL.
+ */
+BzLDouble
+BzToLongDoubleScaled(const BigZ z, long scale, BigNumBool inexact) {
+        return BzToFloat(z, scale, inexact, BZ_LDBL_MANT_DIG, BZ_LDBL_MIN_EXP);
+}
+
+/**
+ * BzToDoubleScaled.
+ * It converts z * 2^scale to the nearest double (ties to even).
+ * @param [in] z BigZ
+ * @param [in] scale binary exponent.
+ * @param [in] inexact BN_TRUE if the value to convert is slightly above
+ * |z| * 2^scale (by less than 2^scale). z must then have more than
+ * BZ_DBL_MANT_DIG significant bits.
+ * @return double
+ * @pre z != BZNULL.
+ */
+double
+BzToDoubleScaled(const BigZ z, long scale, BigNumBool inexact) {
+        return (double)BzToFloat(z, scale, inexact, BZ_DBL_MANT_DIG, BZ_DBL_MIN_EXP);
 }
 
 /**
@@ -2162,432 +3216,752 @@ BzToBigNum(const BigZ z, BigNumLength *nl) {
  * Logical oprations.
  */
 
-/** @cond */
-#define BZ_SIGN1        0x1     /* 01 */
-#define BZ_SIGN2        0x2     /* 10 */
-/** @endcond */
+/** @cond */
+/*
+ * Value of a BzBooleOp on digits a and b, selecting op(0, b) or
+ * op(1, b) by a. With mi the mask of truth table entry i, op(0, b) is
+ * m0 ^ (b & d0) with d0 = m1 ^ m0, and op(1, b) is m2 ^ (b & d2) with
+ * d2 = m3 ^ m2.
+ */
+#define BzBooleDigit(a, b)                                              \
+        ((m0 ^ ((b) & d0))                                              \
+         ^ ((a) & ((m2 ^ ((b) & d2)) ^ (m0 ^ ((b) & d0)))))
+
+#define BzBooleMask(op, bit)                                            \
+        ((((unsigned int)(op) >> (bit)) & 1U) ? BN_COMPLEMENT : BN_ZERO)
+/** @endcond */
+
+/**
+ * BzBoole.
+ * Computes one of the 16 bitwise operations on y and z, taken in
+ * infinite two's complement representation, in a single pass. The
+ * operands are not copied: their two's complement digits are formed on
+ * the fly, and the result is built directly in sign-magnitude form.
+ * @param [in] op BzBooleOp
+ * @param [in] y BigZ
+ * @param [in] z BigZ
+ * @return BigZ
+ * @pre y != BZNULL.
+ * @pre z != BZNULL.
+ */
+BigZ
+BzBoole(BzBooleOp op, const BigZ y, const BigZ z) {
+        const BigNumDigit  m0 = BzBooleMask(op, 0);
+        const BigNumDigit  d0 = BzBooleMask(op, 1) ^ m0;
+        const BigNumDigit  m2 = BzBooleMask(op, 2);
+        const BigNumDigit  d2 = BzBooleMask(op, 3) ^ m2;
+        const BigNumLength yl = BzNumDigits(y);
+        const BigNumLength zl = BzNumDigits(z);
+        const BigNumLength ml = (yl < zl) ? yl : zl;
+        const BigNumLength nl = ((yl < zl) ? zl : yl) + 1;
+        const BigNumDigit  ys = (BzGetSign(y) == BZ_MINUS) ? BN_COMPLEMENT : BN_ZERO;
+        const BigNumDigit  zs = (BzGetSign(z) == BZ_MINUS) ? BN_COMPLEMENT : BN_ZERO;
+        const BigNumDigit  rs = BzBooleDigit(ys, zs);
+        const BigNum       yn = BzToBn(y);
+        const BigNum       zn = BzToBn(z);
+        BigNumLength       ylow = 0;
+        BigNumLength       zlow = 0;
+        BigNumLength       head = 0;
+        BigNumLength       k;
+        BigNumLength       i;
+        BigNum             rn;
+        BigZ               r;
+
+        /*
+         * One more digit than the operands, the magnitude of a negative
+         * result may need it.
+         */
+
+        if ((r = BzCreate(nl)) == BZNULL) {
+                return BZNULL;
+        }
+
+        rn = BzToBn(r);
+
+        /*
+         * Up to the lowest non zero digit of a negative operand, its
+         * two's complement digits are formed one by one. Above, they
+         * are the complemented digits, and past its length the sign.
+         * When the result is negative its complement is stored, so that
+         * the magnitude only needs 1 added.
+         */
+
+        if (ys != BN_ZERO) {
+                ylow = BzLowestDigit(y);
+                head = ylow + 1;
+        }
+
+        if ((zs != BN_ZERO) && ((zlow = BzLowestDigit(z)) + 1 > head)) {
+                head = zlow + 1;
+        }
+
+        if (head > nl - 1) {
+                head = nl - 1;
+        }
+
+        for (k = 0; k < head; ++k) {
+                const BigNumDigit a = BzTwosComplementDigit(y, yl, ylow, k);
+                const BigNumDigit b = BzTwosComplementDigit(z, zl, zlow, k);
+
+                rn[k] = BzBooleDigit(a, b) ^ rs;
+        }
+
+        /*
+         * Above the head, digits are streamed with no branch, which
+         * compilers can vectorize.
+         */
+
+        for (i = head; i < ml; ++i) {
+                const BigNumDigit a = yn[i] ^ ys;
+                const BigNumDigit b = zn[i] ^ zs;
+
+                rn[i] = BzBooleDigit(a, b) ^ rs;
+        }
+
+        for (i = (head < ml) ? ml : head; i < yl; ++i) {
+                const BigNumDigit a = yn[i] ^ ys;
+
+                rn[i] = BzBooleDigit(a, zs) ^ rs;
+        }
+
+        for (i = (head < ml) ? ml : head; i < zl; ++i) {
+                const BigNumDigit b = zn[i] ^ zs;
+
+                rn[i] = BzBooleDigit(ys, b) ^ rs;
+        }
+
+        /*
+         * The last digit holds the sign, op(ys, zs) ^ rs = 0.
+         */
+
+        if (rs != BN_ZERO) {
+                (void)BnnAddCarry(rn, nl, BN_CARRY);
+                BzSetSign(r, BZ_MINUS);
+        } else if (BnnIsZero(rn, nl) == BN_FALSE) {
+                BzSetSign(r, BZ_PLUS);
+        }
+
+        return r;
+}
+
+/**
+ * BzNot
+ * @param [in] z BigZ
+ * @return BigZ
+ * @pre z != BZNULL.
+ */
+BigZ
+BzNot(const BigZ z) {
+        return BzBoole(BZ_BOOLE_C1, z, z);
+}
+
+/**
+ * BzAnd.
+ * Returns y & z.
+ * @param [in] y BigZ
+ * @param [in] z BigZ
+ * @return BigZ
+ * @pre y != BZNULL.
+ * @pre z != BZNULL.
+ */
+BigZ
+BzAnd(const BigZ y, const BigZ z) {
+        return BzBoole(BZ_BOOLE_AND, y, z);
+}
+
+/**
+ * BzOr.
+ * Returns y | z.
+ * @param [in] y BigZ
+ * @param [in] z BigZ
+ * @return BigZ
+ * @pre y != BZNULL.
+ * @pre z != BZNULL.
+ */
+BigZ
+BzOr(const BigZ y, const BigZ z) {
+        return BzBoole(BZ_BOOLE_IOR, y, z);
+}
+
+/**
+ * BzXor.
+ * Returns y ^ z.
+ * @param [in] y BigZ
+ * @param [in] z BigZ
+ * @return BigZ
+ * @pre y != BZNULL.
+ * @pre z != BZNULL.
+ */
+BigZ
+BzXor(const BigZ y, const BigZ z) {
+        return BzBoole(BZ_BOOLE_XOR, y, z);
+}
+
+/**
+ * BzLowestDigit.
+ * Returns the index of the lowest non zero digit of z.
+ * @param [in] z BigZ
+ * @return BigNumLength
+ * @pre z != 0.
+ */
+static BigNumLength
+BzLowestDigit(const BigZ z) {
+        BigNumLength i = 0;
+
+        while (BzGetDigit(z, i) == BN_ZERO) {
+                ++i;
+        }
+
+        return i;
+}
+
+/**
+ * BzTwosComplementDigit.
+ * Returns digit k of z in infinite two's complement representation,
+ * without building it. Below the lowest non zero digit, the digits of
+ * -|z| are zero, at that digit it is the negated digit, above it is the
+ * complemented digit.
+ * @param [in] z BigZ
+ * @param [in] zl BigNumLength number of digits of z.
+ * @param [in] low BigNumLength BzLowestDigit(z) when z < 0.
+ * @param [in] k BigNumLength
+ * @return BigNumDigit
+ */
+static BigNumDigit
+BzTwosComplementDigit(const BigZ z,
+                      BigNumLength zl,
+                      BigNumLength low,
+                      BigNumLength k) {
+        if (BzGetSign(z) != BZ_MINUS) {
+                return (k < zl) ? BzGetDigit(z, k) : BN_ZERO;
+        } else if (k >= zl) {
+                return BN_COMPLEMENT;
+        } else if (k < low) {
+                return BN_ZERO;
+        } else if (k == low) {
+                return (BigNumDigit)(~BzGetDigit(z, k) + BN_ONE);
+        } else {
+                return (BigNumDigit)~BzGetDigit(z, k);
+        }
+}
+
+/**
+ * BzTestBit.
+ * Returns BN_TRUE iff bit is on (i.e.  2**bit is one).  It assumes
+ * that bit is a non-negative integer.
+ * @param [in] bit BigNumLength
+ * @param [in] z BigZ
+ * @return BigNumBool
+ * @pre z != BZNULL.
+ */
+BigNumBool
+BzTestBit(BigNumLength bit, const BigZ z) {
+        const BigNumLength zl  = BzNumDigits(z);
+        const BigNumLength low = (BzGetSign(z) == BZ_MINUS)
+                                 ? BzLowestDigit(z)
+                                 : (BigNumLength)0;
+        BigNumDigit        d;
+
+        d = BzTwosComplementDigit(z, zl, low, bit / BN_DIGIT_SIZE);
+
+        return (BigNumBool)(((d >> (bit % BN_DIGIT_SIZE)) & BN_ONE) != 0);
+}
 
 /**
- * BzNot
+ * BzBitCount.
+ * Returns the number of bits set in z. For negative z, it is the
+ * number of bits that are not set in two's complement representation,
+ * as Common Lisp logcount does.
  * @param [in] z BigZ
- * @return BigZ
+ * @return BigNumLength
  * @pre z != BZNULL.
  */
-BigZ
-BzNot(const BigZ z) {
-        /*
-         * Negates the passed BigZ.
-         */
-
-        BigZ y;
+BigNumLength
+BzBitCount(const BigZ z) {
+        const BigNumLength zl = BzNumDigits(z);
+        BigNumLength       low;
+        BigNumDigit        d;
 
         switch (BzGetSign(z)) {
         case BZ_MINUS:
-             if ((y = BzCopy(z)) != BZNULL) {
-               BnnComplement2(BzToBn(y), BzNumDigits(y));
-               BnnComplement(BzToBn(y), BzNumDigits(y));
-               if (BnnIsZero(BzToBn(y), BzNumDigits(y)) == BN_TRUE) {
-                 /*
-                  * ~(-1) -> 0
-                  */
-                 BzSetSign(y, BZ_ZERO);
-               } else {
-                 BzSetSign(y, BZ_PLUS);
-               }
-             }
-             break;
-        case BZ_ZERO:
-             y = BzFromInteger((BzInt)-1);
-             break;
+                /*
+                 * The zero bits of -|z| are the one bits of |z| - 1:
+                 * the digits below the lowest non zero one become all
+                 * ones, that one is decremented, the others are kept.
+                 */
+                low = BzLowestDigit(z);
+                d   = BzGetDigit(z, low) - BN_ONE;
+                return (BigNumLength)(low * BN_DIGIT_SIZE)
+                       + BnnNumCount(&d, 1)
+                       + BnnNumCount(BzToBn(z) + low + 1, zl - low - 1);
         case BZ_PLUS:
-        default: /* case BZ_PLUS: */
-             if ((y = BzCopy(z)) != BZNULL) {
-                     BnnComplement(BzToBn(y), BzNumDigits(y));
-                     BnnComplement2(BzToBn(y), BzNumDigits(y));
-                     BzSetSign(y, BZ_MINUS);
-             }
-             break;
+                return BnnNumCount(BzToBn(z), zl);
+        default:
+                return (BigNumLength)0;
         }
-
-        return y;
 }
 
 /**
- * BzAnd.
- * Returns y & z.
- * @param [in] y BigZ
+ * BzScan.
+ * Returns the index of the first bit equal to value at or above
+ * start, in two's complement representation.
  * @param [in] z BigZ
- * @return BigZ
- * @pre y != BZNULL.
- * @pre z != BZNULL.
+ * @param [in] start BigNumLength
+ * @param [in] value BigNumBool
+ * @return BigNumLength or BZ_NO_BIT if there is none.
  */
-BigZ
-BzAnd(const BigZ y, const BigZ z) {
-        /*
-         * Returns Y & Z.
-         */
+static BigNumLength
+BzScan(const BigZ z, BigNumLength start, BigNumBool value) {
+        const BigNumLength zl   = BzNumDigits(z);
+        const BigNumDigit  flip = (value == BN_TRUE) ? BN_ZERO : BN_COMPLEMENT;
+        BigNumLength       low  = 0;
+        BigNumLength       k    = start / BN_DIGIT_SIZE;
+        BigNumDigit        d;
 
-        BigZ            n;
-        BigZ            yy;
-        BigZ            zz;
-        BigNumLength    yl;
-        BigNumLength    zl;
-        BigNumLength    l;
-        unsigned int    sign = 0;
+        if (BzGetSign(z) == BZ_MINUS) {
+                low = BzLowestDigit(z);
+        }
 
-        yl = BzNumDigits(y);
-        zl = BzNumDigits(z);
+        if (k < zl) {
+                /*
+                 * Ignore the bits below start in its digit.
+                 */
 
-        if (BzGetSign(y) == BZ_MINUS) {
-                if ((yy = BzCopy(y)) == BZNULL) {
-                        return BZNULL;
-                }
-                BnnComplement2(BzToBn(yy), yl);
-                sign |= BZ_SIGN1;
-        } else {
-                yy = y;
-        }
+                d  = BzTwosComplementDigit(z, zl, low, k) ^ flip;
+                d &= (BN_COMPLEMENT << (start % BN_DIGIT_SIZE));
 
-        if (BzGetSign(z) == BZ_MINUS) {
-                if ((zz = BzCopy(z)) == BZNULL) {
-                        if ((sign & BZ_SIGN1) != 0) {
-                                BzFree(yy);
+                while (d == BN_ZERO) {
+                        if (++k == zl) {
+                                break;
                         }
-                        return BZNULL;
+                        d = BzTwosComplementDigit(z, zl, low, k) ^ flip;
                 }
-                BnnComplement2(BzToBn(zz), zl);
-                sign |= BZ_SIGN2;
-        } else {
-                zz = z;
-        }
 
-        if (yl < zl) {
-                if ((n = BzCopy(zz)) != BZNULL) {
-                        BzSetSign(n, BZ_PLUS);
-                        if ((sign & BZ_SIGN1) == 0) {
-                                for (l = (zl - 1); l >= yl; --l) {
-                                  BnnAndDigits(BzToBn(n) + l, BN_ZERO);
-                                }
-                        }
-                        for (l = 0; l < yl; ++l) {
-                          BnnAndDigits(BzToBn(n) + l, *(BzToBn(yy) + l));
-                        }
+                if (k < zl) {
+                        return (BigNumLength)(k * BN_DIGIT_SIZE)
+                               + BnnNumTrailingZeroBitsInDigit(d);
                 }
-        } else {
-                if ((n = BzCopy(yy)) != BZNULL) {
-                        BzSetSign(n, BZ_PLUS);
-                        if ((sign & BZ_SIGN2) == 0) {
-                                for (l = (yl - 1); l >= zl; --l) {
-                                  BnnAndDigits(BzToBn(n) + l, BN_ZERO);
-                                }
-                        }
-                        for (l = 0; l < zl; ++l) {
-                          BnnAndDigits(BzToBn(n) + l, *(BzToBn(zz) + l));
-                        }
-                }
-        }
 
-        if (n != BZNULL) {
-                if (BnnIsZero(BzToBn(n), BzNumDigits(n)) == BN_TRUE) {
-                        BzSetSign(n, BZ_ZERO);
-                } else if (sign == (unsigned int)(BZ_SIGN1 | BZ_SIGN2)) {
-                        BnnComplement2(BzToBn(n), BzNumDigits(n));
-                        BzSetSign(n, BZ_MINUS);
-                }
+                start = (BigNumLength)(zl * BN_DIGIT_SIZE);
         }
 
         /*
-         *  Free copies.
+         * Above the digits of z, all the bits are the sign bit.
          */
 
-        if ((sign & BZ_SIGN1) != 0) {
-                BzFree(yy);
+        if ((BzTwosComplementDigit(z, zl, low, zl) ^ flip) != BN_ZERO) {
+                return start;
         }
 
-        if ((sign & BZ_SIGN2) != 0) {
-                BzFree(zz);
-        }
+        return BZ_NO_BIT;
+}
 
-        return n;
+/**
+ * BzScan0.
+ * Returns the index of the first bit that is off at or above start, in
+ * two's complement representation.
+ * @param [in] z BigZ
+ * @param [in] start BigNumLength
+ * @return BigNumLength or BZ_NO_BIT if there is none (z < 0).
+ * @pre z != BZNULL.
+ */
+BigNumLength
+BzScan0(const BigZ z, BigNumLength start) {
+        return BzScan(z, start, BN_FALSE);
 }
 
 /**
- * BzOr
- * Returns y | z.
- * @param [in] y BigZ
+ * BzScan1.
+ * Returns the index of the first bit that is on at or above start, in
+ * two's complement representation.
  * @param [in] z BigZ
- * @return BigZ
- * @pre y != BZNULL.
+ * @param [in] start BigNumLength
+ * @return BigNumLength or BZ_NO_BIT if there is none (z >= 0).
  * @pre z != BZNULL.
  */
-BigZ
-BzOr(const BigZ y, const BigZ z) {
-        BigZ         n;
-        BigZ         yy;
-        BigZ         zz;
-        BigNumLength yl;
-        BigNumLength zl;
-        BigNumLength l;
-        unsigned int sign = 0;
+BigNumLength
+BzScan1(const BigZ z, BigNumLength start) {
+        return BzScan(z, start, BN_TRUE);
+}
 
-        yl = BzNumDigits(y);
-        zl = BzNumDigits(z);
+/**
+ * BzLowestSetBit.
+ * Returns the index of the lowest bit that is on, which is the same for
+ * z and -z, that is the largest n such that 2^n divides z.
+ * @param [in] z BigZ
+ * @return BigNumLength or BZ_NO_BIT if z = 0.
+ * @pre z != BZNULL.
+ */
+BigNumLength
+BzLowestSetBit(const BigZ z) {
+        BigNumLength low;
 
-        if (BzGetSign(y) == BZ_MINUS) {
-                if ((yy = BzCopy(y)) == BZNULL) {
-                        return BZNULL;
-                }
-                BnnComplement2(BzToBn(yy), yl);
-                sign |= BZ_SIGN1;
-        } else {
-                yy = y;
+        if (BzGetSign(z) == BZ_ZERO) {
+                return BZ_NO_BIT;
         }
 
-        if (BzGetSign(z) == BZ_MINUS) {
-                if ((zz = BzCopy(z)) == BZNULL) {
-                        if ((sign & BZ_SIGN1) != 0) {
-                                BzFree(yy);
-                        }
-                        return BZNULL;
-                }
-                BnnComplement2(BzToBn(zz), zl);
-                sign |= BZ_SIGN2;
-        } else {
-                zz = z;
-        }
+        low = BzLowestDigit(z);
 
-        if (yl < zl) {
-                if ((n = BzCopy(zz)) != BZNULL) {
-                        BzSetSign(n, BZ_PLUS);
-                        if ((sign & BZ_SIGN1) != 0) {
-                                for (l = (zl - 1); l >= yl; --l) {
-                                  BnnAndDigits(BzToBn(n) + l, BN_ZERO);
-                                }
-                        }
-                        for (l = 0; l < yl; ++l) {
-                          BnnOrDigits(BzToBn(n) + l, *(BzToBn(yy) + l));
-                        }
-                }
-        } else {
-                if ((n = BzCopy(yy)) != BZNULL) {
-                        BzSetSign(n, BZ_PLUS);
-                        if ((sign & BZ_SIGN2) != 0) {
-                                for (l = (yl - 1); l >= zl; --l) {
-                                  BnnAndDigits(BzToBn(n) + l, BN_ZERO);
-                                }
-                        }
-                        for (l = 0; l < zl; ++l) {
-                          BnnOrDigits(BzToBn(n) + l, *(BzToBn(zz) + l));
-                        }
-                }
+        return (BigNumLength)(low * BN_DIGIT_SIZE)
+               + BnnNumTrailingZeroBitsInDigit(BzGetDigit(z, low));
+}
+
+/**
+ * BzExtractDigits.
+ * Stores bits [start, start + len) of z, in two's complement
+ * representation, in the first (len + BN_DIGIT_SIZE - 1) / BN_DIGIT_SIZE
+ * digits of out. The digits of z above that range are not read, nor
+ * below it past the lowest non zero one.
+ * @param [in] z BigZ
+ * @param [in] start BigNumLength
+ * @param [in] len BigNumLength
+ * @param [out] out BigNum
+ */
+static void
+BzExtractDigits(const BigZ z,
+                BigNumLength start,
+                BigNumLength len,
+                BigNum out) {
+        const BigNumLength zl  = BzNumDigits(z);
+        const BigNumLength ol  = BzDigitsForBits(len);
+        const BigNumLength k0  = start / (BigNumLength)BN_DIGIT_SIZE;
+        const BigNumLength s   = start % (BigNumLength)BN_DIGIT_SIZE;
+        const BigNumLength top = len % (BigNumLength)BN_DIGIT_SIZE;
+        BigNumLength       low = 0;
+        BigNumLength       i;
+        BigNumDigit        d;
+
+        if (ol == 0) {
+                return;
         }
 
-        if (n != BZNULL) {
-                if (BnnIsZero(BzToBn(n), BzNumDigits(n)) == BN_TRUE) {
-                        BzSetSign(n, BZ_ZERO);
-                } else if (sign != 0) {
-                        BnnComplement2(BzToBn(n), BzNumDigits(n));
-                        BzSetSign(n, BZ_MINUS);
+        if (BzGetSign(z) == BZ_MINUS) {
+                /*
+                 * Digits k0 to k0 + ol only depend on whether a lower
+                 * digit is non zero: if none is, they are read as if
+                 * the lowest non zero digit was above them.
+                 */
+                const BigNumLength lim = (k0 + ol + 1 < zl) ? k0 + ol + 1 : zl;
+
+                while ((low < lim) && (BzGetDigit(z, low) == BN_ZERO)) {
+                        ++low;
                 }
         }
 
-        /*
-         *  Free copies.
-         */
+        d = BzTwosComplementDigit(z, zl, low, k0);
 
-        if ((sign & BZ_SIGN1) != 0) {
-                BzFree(yy);
-        }
+        for (i = 0; i < ol; ++i) {
+                const BigNumDigit next = BzTwosComplementDigit(z, zl, low, k0 + i + 1);
+
+                if (s == 0) {
+                        out[i] = d;
+                } else {
+                        out[i] = (d >> s) | (next << (BN_DIGIT_SIZE - s));
+                }
 
-        if ((sign & BZ_SIGN2) != 0) {
-                BzFree(zz);
+                d = next;
         }
 
-        return n;
+        if (top != 0) {
+                out[ol - 1] &= (BN_COMPLEMENT >> (BN_DIGIT_SIZE - top));
+        }
 }
 
 /**
- * BzXor.
- * Returns y ^ z.
- * @param [in] y BigZ
- * @param [in] z BigZ
- * @return BigZ
- * @pre y != BZNULL.
- * @pre z != BZNULL.
+ * BzReplaceBits.
+ * Replaces bits [start, start + len) of z, in two's complement
+ * representation, by op applied to them and to the same bits of v (0 if
+ * v is BZNULL). As the bits above are kept, the sign of z is kept and
+ * its magnitude only changes by (new - old) * 2^start: only the digits
+ * of that range, and those reached by a carry, are written.
+ * @param [in,out] z BigZ
+ * @param [in] start BigNumLength
+ * @param [in] len BigNumLength
+ * @param [in] op BzBooleOp
+ * @param [in] v BigZ or BZNULL
+ * @param [in] copy BN_TRUE to return a new BigZ, BN_FALSE to change z,
+ * which is freed if it has to be moved to a larger one.
+ * @return BigZ or BZNULL on error (z is then unchanged).
  */
-BigZ
-BzXor(const BigZ y, const BigZ z) {
+static BigZ
+BzReplaceBits(BigZ z,
+              BigNumLength start,
+              BigNumLength len,
+              BzBooleOp op,
+              const BigZ v,
+              BigNumBool copy) {
+        const BigNumDigit  m0   = BzBooleMask(op, 0);
+        const BigNumDigit  d0   = BzBooleMask(op, 1) ^ m0;
+        const BigNumDigit  m2   = BzBooleMask(op, 2);
+        const BigNumDigit  d2   = BzBooleMask(op, 3) ^ m2;
+        const BigNumLength zl   = BzNumDigits(z);
+        const BigNumLength ol   = BzDigitsForBits(len);
+        const BigNumLength k0   = start / (BigNumLength)BN_DIGIT_SIZE;
+        const BigNumLength top  = len % (BigNumLength)BN_DIGIT_SIZE;
+        const BigNumLength need = ((zl < k0 + ol + 1) ? k0 + ol + 1 : zl) + 1;
+        BigNumDigit        small[3];
+        BigNum             o;
+        BigNum             w;
+        BigNum             rn;
+        BigNumCmp          cmp;
+        BigNumBool         add;
+        BigNumLength       i;
+        BigZ               r;
+
+        if (ol == 0) {
+                return (copy == BN_TRUE) ? BzCopy(z) : z;
+        }
+
+        if (need > BZ_MAX_DIGITS) {
+                return BZNULL;
+        }
+
         /*
-         * Returns Y ^ Z.
+         * Old bits in o, new ones in w, with one more digit after o to
+         * shift their difference.
          */
 
-        BigZ            n;
-        BigZ            yy;
-        BigZ            zz;
-        BigNumLength    yl;
-        BigNumLength    zl;
-        BigNumLength    l;
-        int             sign = 0;
+        if (ol == 1) {
+                o = small;
+        } else if ((o = (BigNum)BzAlloc((2 * (size_t)ol + 1)
+                                        * sizeof(BigNumDigit))) == NULL) {
+                return BZNULL;
+        }
 
-        yl = BzNumDigits(y);
-        zl = BzNumDigits(z);
+        w = o + ol + 1;
 
-        if (BzGetSign(y) == BZ_MINUS) {
-                if ((yy = BzCopy(y)) == BZNULL) {
-                        return BZNULL;
-                }
-                BnnComplement2(BzToBn(yy), yl);
-                sign |= BZ_SIGN1;
+        BzExtractDigits(z, start, len, o);
+
+        if (v != BZNULL) {
+                BzExtractDigits(v, 0, len, w);
         } else {
-                yy = y;
+                BnnSetToZero(w, ol);
         }
 
-        if (BzGetSign(z) == BZ_MINUS) {
-                if ((zz = BzCopy(z)) == BZNULL) {
-                        if ((sign & BZ_SIGN1) != 0) {
-                                BzFree(yy);
-                        }
-                        return BZNULL;
-                }
-                BnnComplement2(BzToBn(zz), zl);
-                sign |= BZ_SIGN2;
-        } else {
-                zz = z;
+        for (i = 0; i < ol; ++i) {
+                w[i] = BzBooleDigit(o[i], w[i]);
         }
 
-        if (yl < zl) {
-                if ((n = BzCopy(zz)) != BZNULL) {
-                        BzSetSign(n, BZ_PLUS);
-                        if ((sign & BZ_SIGN1) != 0) {
-                                for (l = (zl - 1); l >= yl; --l) {
-                                  BnnXorDigits(BzToBn(n) + l, BN_COMPLEMENT);
-                                }
-                        }
-                        for (l = 0; l < yl; ++l) {
-                          BnnXorDigits(BzToBn(n) + l, *(BzToBn(yy) + l));
-                        }
-                }
+        if (top != 0) {
+                w[ol - 1] &= (BN_COMPLEMENT >> (BN_DIGIT_SIZE - top));
+        }
+
+        if ((cmp = BnnCompare(o, ol, w, ol)) == BN_EQ) {
+                r = (copy == BN_TRUE) ? BzCopy(z) : z;
         } else {
-                if ((n = BzCopy(yy)) != BZNULL) {
-                        BzSetSign(n, BZ_PLUS);
-                        if ((sign & BZ_SIGN2) != 0) {
-                                for (l = (yl - 1); l >= zl; --l) {
-                                  BnnXorDigits(BzToBn(n) + l, BN_COMPLEMENT);
-                                }
-                        }
-                        for (l = 0; l < zl; ++l) {
-                          BnnXorDigits(BzToBn(n) + l, *(BzToBn(zz) + l));
-                        }
+                /*
+                 * |new - old| in o, shifted to start.
+                 */
+
+                (void)BnnSubtract(o, ol, w, ol, BN_CARRY);
+
+                if (cmp == BN_LT) {
+                        BnnComplement(o, ol);
+                        (void)BnnAddCarry(o, ol, BN_CARRY);
                 }
-        }
 
-        if (n != BZNULL) {
-                if (BnnIsZero(BzToBn(n), BzNumDigits(n)) == BN_TRUE) {
-                        BzSetSign(n, BZ_ZERO);
-                } else if (sign == BZ_SIGN1 || sign == BZ_SIGN2) {
-                        BnnComplement2(BzToBn(n), BzNumDigits(n));
-                        BzSetSign(n, BZ_MINUS);
+                o[ol] = BnnShiftLeft(o, ol, start % (BigNumLength)BN_DIGIT_SIZE);
+                add   = (BigNumBool)((cmp == BN_LT) == (BzGetSign(z) != BZ_MINUS));
+
+                if ((copy == BN_FALSE) && (BzGetSize(z) >= need)) {
+                        r = z;
+                } else if ((r = BzCreate(((copy == BN_TRUE)
+                                          || (need > BZ_MAX_DIGITS - need / 2))
+                                         ? need
+                                         : need + need / 2)) != BZNULL) {
+                        /*
+                         * Leave room to grow when changing in place.
+                         */
+
+                        BnnAssign(BzToBn(r), BzToBn(z), zl);
+                        BzSetSign(r, BzGetSign(z));
+
+                        if (copy == BN_FALSE) {
+                                BzFree(z);
+                        }
                 }
-        }
 
-        /*
-         *  Free copies.
-         */
+                if (r != BZNULL) {
+                        rn = BzToBn(r);
 
-        if ((sign & BZ_SIGN1) != 0) {
-                BzFree(yy);
+                        if (add == BN_TRUE) {
+                                (void)BnnAdd(rn + k0, need - k0, o, ol + 1, BN_NOCARRY);
+
+                                if (BzGetSign(r) == BZ_ZERO) {
+                                        BzSetSign(r, BZ_PLUS);
+                                }
+                        } else {
+                                (void)BnnSubtract(rn + k0, need - k0, o, ol + 1, BN_CARRY);
+
+                                if (BnnIsZero(rn, need) == BN_TRUE) {
+                                        BzSetSign(r, BZ_ZERO);
+                                }
+                        }
+                }
         }
 
-        if ((sign & BZ_SIGN2) != 0) {
-                BzFree(zz);
+        if (o != small) {
+                BzFree(o);
         }
 
-        return n;
+        return r;
 }
 
 /**
- * BzTestBit.
- * Returns BN_TRUE iff bit is on (i.e.  2**bit is one).  It assumes
- * that bit is a non-negative integer.
- * @param [in] bit BigNumLength
+ * BzSetBit.
+ * Returns z with bit set, in two's complement representation.
  * @param [in] z BigZ
- * @return BigNumBool
+ * @param [in] bit BigNumLength
+ * @return BigZ
  * @pre z != BZNULL.
  */
-BigNumBool
-BzTestBit(BigNumLength bit, const BigZ z) {
-        BigNumLength zl;
-        BigNumBool   r;
+BigZ
+BzSetBit(const BigZ z, BigNumLength bit) {
+        return BzReplaceBits(z, bit, 1, BZ_BOOLE_SET, BZNULL, BN_TRUE);
+}
 
-        zl = (BigNumLength)(bit / BN_DIGIT_SIZE);
+/**
+ * BzClearBit.
+ * Returns z with bit cleared, in two's complement representation.
+ * @param [in] z BigZ
+ * @param [in] bit BigNumLength
+ * @return BigZ
+ * @pre z != BZNULL.
+ */
+BigZ
+BzClearBit(const BigZ z, BigNumLength bit) {
+        return BzReplaceBits(z, bit, 1, BZ_BOOLE_CLR, BZNULL, BN_TRUE);
+}
 
-        if (zl >= BzNumDigits(z)) {
-                return (BzGetSign(z) == BZ_MINUS) ? BN_TRUE : BN_FALSE;
-        }
+/**
+ * BzFlipBit.
+ * Returns z with bit complemented, in two's complement representation.
+ * @param [in] z BigZ
+ * @param [in] bit BigNumLength
+ * @return BigZ
+ * @pre z != BZNULL.
+ */
+BigZ
+BzFlipBit(const BigZ z, BigNumLength bit) {
+        return BzReplaceBits(z, bit, 1, BZ_BOOLE_C1, BZNULL, BN_TRUE);
+}
 
-        bit = (bit % BN_DIGIT_SIZE);
+/**
+ * BzExtractBits.
+ * Returns the non negative number made of bits [start, start + len) of
+ * z, in two's complement representation, as Common Lisp ldb. It only
+ * reads the digits of z in that range (and below it, up to the lowest
+ * non zero digit, when z < 0).
+ * @param [in] z BigZ
+ * @param [in] start BigNumLength
+ * @param [in] len BigNumLength
+ * @return BigZ
+ * @pre z != BZNULL.
+ */
+BigZ
+BzExtractBits(const BigZ z, BigNumLength start, BigNumLength len) {
+        const BigNumLength ol = BzDigitsForBits(len);
+        BigZ               r;
 
-        if (BzGetSign(z) == BZ_MINUS) {
-                const BigZ y = BzCopy(z);
-                BigNumLength yl;
+        if ((r = BzCreate((ol == 0) ? 1 : ol)) != BZNULL) {
+                BzExtractDigits(z, start, len, BzToBn(r));
 
-                if (y == BZNULL) {
-                        return BN_FALSE;
+                if (BnnIsZero(BzToBn(r), BzGetSize(r)) == BN_FALSE) {
+                        BzSetSign(r, BZ_PLUS);
                 }
-
-                yl = BzNumDigits(y);
-
-                BnnComplement2(BzToBn(y), yl);
-                BzSetSign(y, BZ_PLUS);
-                r = (BigNumBool)(((*(BzToBn(y) + zl)) & (BN_ONE << bit)) != 0);
-                BzFree(y);
-        } else {
-                r = (BigNumBool)(((*(BzToBn(z) + zl)) & (BN_ONE << bit)) != 0);
         }
 
         return r;
 }
 
 /**
- * BzBitCount.
- * Returns the number of bits set in z.
+ * BzDepositBits.
+ * Returns z with bits [start, start + len) replaced by the len low bits
+ * of v, in two's complement representation, as Common Lisp dpb.
  * @param [in] z BigZ
- * @return BigNumLength
+ * @param [in] start BigNumLength
+ * @param [in] len BigNumLength
+ * @param [in] v BigZ
+ * @return BigZ
  * @pre z != BZNULL.
+ * @pre v != BZNULL.
  */
-BigNumLength
-BzBitCount(const BigZ z) {
-        BigNumLength nl = (BigNumLength)0;
-        BigZ    y;
+BigZ
+BzDepositBits(const BigZ z,
+              BigNumLength start,
+              BigNumLength len,
+              const BigZ v) {
+        return BzReplaceBits(z, start, len, BZ_BOOLE_2, v, BN_TRUE);
+}
 
-        switch (BzGetSign(z)) {
-        case BZ_MINUS:
-                if ((y = BzCopy(z)) == BZNULL) {
-                        return (BigNumLength)0;
-                }
-                BnnComplement2(BzToBn(y), BzNumDigits(y));
-                BnnComplement(BzToBn(y), BzNumDigits(y));
-                nl = BnnNumCount(BzToBn(y), BzNumDigits(y));
-                BzFree(y);
-                break;
-        case BZ_ZERO:
-                nl = (BigNumLength)0;
-                break;
-        case BZ_PLUS:
-                nl = BnnNumCount(BzToBn(z), BzNumDigits(z));
-                break;
-        }
+/**
+ * BzSetBitInPlace.
+ * Sets bit of z, in two's complement representation, changing z. It
+ * takes constant time unless a carry propagates (z < 0) or z grows.
+ * @param [in,out] z BigZ
+ * @param [in] bit BigNumLength
+ * @return z, or a new BigZ if z had to grow (z is then freed), or
+ * BZNULL on error (z is then unchanged).
+ * @pre z != BZNULL.
+ */
+BigZ
+BzSetBitInPlace(BigZ z, BigNumLength bit) {
+        return BzReplaceBits(z, bit, 1, BZ_BOOLE_SET, BZNULL, BN_FALSE);
+}
+
+/**
+ * BzClearBitInPlace.
+ * Clears bit of z, in two's complement representation, changing z.
+ * @param [in,out] z BigZ
+ * @param [in] bit BigNumLength
+ * @return z, or a new BigZ if z had to grow (z is then freed), or
+ * BZNULL on error (z is then unchanged).
+ * @pre z != BZNULL.
+ */
+BigZ
+BzClearBitInPlace(BigZ z, BigNumLength bit) {
+        return BzReplaceBits(z, bit, 1, BZ_BOOLE_CLR, BZNULL, BN_FALSE);
+}
 
-        return nl;
+/**
+ * BzFlipBitInPlace.
+ * Complements bit of z, in two's complement representation, changing z.
+ * @param [in,out] z BigZ
+ * @param [in] bit BigNumLength
+ * @return z, or a new BigZ if z had to grow (z is then freed), or
+ * BZNULL on error (z is then unchanged).
+ * @pre z != BZNULL.
+ */
+BigZ
+BzFlipBitInPlace(BigZ z, BigNumLength bit) {
+        return BzReplaceBits(z, bit, 1, BZ_BOOLE_C1, BZNULL, BN_FALSE);
 }
 
-/*
- * Simple logical equivalence rules.
+/**
+ * BzDepositBitsInPlace.
+ * Replaces bits [start, start + len) of z by the len low bits of v, in
+ * two's complement representation, changing z. It takes O(len) time
+ * unless a carry propagates (z < 0) or z grows.
+ * @param [in,out] z BigZ
+ * @param [in] start BigNumLength
+ * @param [in] len BigNumLength
+ * @param [in] v BigZ
+ * @return z, or a new BigZ if z had to grow (z is then freed), or
+ * BZNULL on error (z is then unchanged).
+ * @pre z != BZNULL.
+ * @pre v != BZNULL.
  */
+BigZ
+BzDepositBitsInPlace(BigZ z,
+                     BigNumLength start,
+                     BigNumLength len,
+                     const BigZ v) {
+        return BzReplaceBits(z, start, len, BZ_BOOLE_2, v, BN_FALSE);
+}
 
 /**
  * BzNand.
- * Returns ~(y & z).
+ * Returns ~(x & y).
  * @param [in] x BigZ
  * @param [in] y BigZ
  * @return BigZ
@@ -2596,10 +3970,7 @@ BzBitCount(const BigZ z) {
  */
 BigZ
 BzNand(const BigZ x, const BigZ y) {
-        const BigZ tmp = BzAnd(x, y);
-        BigZ res = BzNot(tmp);
-        BzFree(tmp);
-        return res;
+        return BzBoole(BZ_BOOLE_NAND, x, y);
 }
 
 /**
@@ -2613,10 +3984,7 @@ BzNand(const BigZ x, const BigZ y) {
  */
 BigZ
 BzNor(const BigZ x, const BigZ y) {
-        const BigZ tmp = BzOr(x, y);
-        BigZ res = BzNot(tmp);
-        BzFree(tmp);
-        return res;
+        return BzBoole(BZ_BOOLE_NOR, x, y);
 }
 
 /**
@@ -2630,10 +3998,7 @@ BzNor(const BigZ x, const BigZ y) {
  */
 BigZ
 BzEqv(const BigZ x, const BigZ y) {
-        const BigZ tmp = BzXor(x, y);
-        BigZ res = BzNot(tmp);
-        BzFree(tmp);
-        return res;
+        return BzBoole(BZ_BOOLE_EQV, x, y);
 }
 
 /**
@@ -2647,10 +4012,7 @@ BzEqv(const BigZ x, const BigZ y) {
  */
 BigZ
 BzAndC1(const BigZ x, const BigZ y) {
-        const BigZ tmp = BzNot(x);
-        BigZ res = BzAnd(tmp, y);
-        BzFree(tmp);
-        return res;
+        return BzBoole(BZ_BOOLE_ANDC1, x, y);
 }
 
 /**
@@ -2664,10 +4026,7 @@ BzAndC1(const BigZ x, const BigZ y) {
  */
 BigZ
 BzAndC2(const BigZ x, const BigZ y) {
-        const BigZ tmp = BzNot(y);
-        BigZ res = BzAnd(x, tmp);
-        BzFree(tmp);
-        return res;
+        return BzBoole(BZ_BOOLE_ANDC2, x, y);
 }
 
 /**
@@ -2681,10 +4040,7 @@ BzAndC2(const BigZ x, const BigZ y) {
  */
 BigZ
 BzOrC1(const BigZ x, const BigZ y) {
-        const BigZ tmp = BzNot(x);
-        BigZ res = BzOr(tmp, y);
-        BzFree(tmp);
-        return res;
+        return BzBoole(BZ_BOOLE_ORC1, x, y);
 }
 
 /**
@@ -2698,130 +4054,196 @@ BzOrC1(const BigZ x, const BigZ y) {
  */
 BigZ
 BzOrC2(const BigZ x, const BigZ y) {
-        const BigZ tmp = BzNot(y);
-        BigZ res = BzOr(x, y);
-        BzFree(tmp);
-        return res;
+        return BzBoole(BZ_BOOLE_ORC2, x, y);
 }
 
 /**
- * BzAsh.
- * Returns y << n.
+ * BzAshSize.
+ * Returns the number of digits BzAshTo needs to store y << n.
  * @param [in] y BigZ
  * @param [in] n int
- * @return BigZ
+ * @return BigNumLength
  * @pre y != BZNULL.
  */
-BigZ
-BzAsh(const BigZ y, int n) {
-        BigZ z;
+BigNumLength
+BzAshSize(const BigZ y, int n) {
+        const BigNumLength yl = BzNumDigits(y);
+        BigNumLength       m;
+        BigNumLength       k;
+
+        if (n >= 0) {
+                m = (BigNumLength)n;
+                k = m / (BigNumLength)BN_DIGIT_SIZE;
+                return yl + k + (((m % (BigNumLength)BN_DIGIT_SIZE) != 0) ? 1 : 0);
+        }
 
-        if (n > 0) {
-                /*
-                 * Create a copy + space for the shift.
-                 */
+        /*
+         * -n written so that it does not overflow for INT_MIN. A negative
+         * y rounded towards -infinity may need one more digit.
+         */
 
-                if ((BzNumDigits(y) == (BigNumLength)1)
-                    && (BzGetDigit(y, 0) == (BigNumDigit)1)) {
-                        /*
-                         * Optimize case where y == 1 (power of two).
-                         */
-                        int bitnb = n + 1;
-                        BigNumDigit digit;
-                        BigNumLength zl;
+        m = (BigNumLength)(-(n + 1)) + 1;
+        k = m / (BigNumLength)BN_DIGIT_SIZE;
 
-                        /*
-                         * Compute the number of buckets.
-                         */
+        if (k >= yl) {
+                return (BigNumLength)1;
+        }
 
-                        zl = (BigNumLength)bitnb / BN_DIGIT_SIZE;
+        return yl - k + ((BzGetSign(y) == BZ_MINUS) ? 1 : 0);
+}
 
-                        if (((BigNumLength)bitnb % BN_DIGIT_SIZE) != 0) {
-                                ++zl;
-                        }
+/**
+ * BzAshTo.
+ * Stores y << n in r without allocating, as BzAsh (a right shift rounds
+ * towards -infinity). Digits move by a memmove and bits by a single
+ * pass, only the digits of y and r are touched.
+ * @param [in,out] r BigZ, overwritten, it may be y to shift in place.
+ * @param [in] y BigZ
+ * @param [in] n int
+ * @return r or BZNULL if r has less than BzAshSize(y, n) digits.
+ * @pre r != BZNULL.
+ * @pre y != BZNULL.
+ */
+BigZ
+BzAshTo(BigZ r, const BigZ y, int n) {
+        const BigNumLength yl   = BzNumDigits(y);
+        const BigNumLength rl   = BzNumDigits(r);
+        const BigNumLength need = BzAshSize(y, n);
+        const BzSign       sign = BzGetSign(y);
+        const BigNum       rn   = BzToBn(r);
+        const BigNum       yn   = BzToBn(y);
+        BigNumLength       m;
+        BigNumLength       k;
+        BigNumLength       s;
+        BigNumLength       ql;
+
+        if (BzGetSize(r) < need) {
+                return BZNULL;
+        }
 
-                        /*
-                         * Create a zeroed BigZ of zl buckets.
-                         */
+        if (sign == BZ_ZERO) {
+                BnnSetToZero(rn, rl);
+                BzSetSign(r, BZ_ZERO);
+                return r;
+        }
 
-                        if ((z = BzCreate(zl)) == BZNULL) {
-                                return z;
-                        }
+        if (n >= 0) {
+                m  = (BigNumLength)n;
+                k  = m / (BigNumLength)BN_DIGIT_SIZE;
+                s  = m % (BigNumLength)BN_DIGIT_SIZE;
+                ql = yl + k;
 
-                        /*
-                         * Set the highest bit.
-                         */
+                BnnAssign(rn + k, yn, yl);
+                BnnSetToZero(rn, k);
 
-                        digit = ((BigNumDigit)1 << ((BzUInt)n % BN_DIGIT_SIZE));
-                        BzSetDigit(z, zl - 1, digit);
+                if (s != 0) {
+                        rn[ql] = BnnShiftLeft(rn + k, yl, s);
+                        ++ql;
+                }
+        } else {
+                m = (BigNumLength)(-(n + 1)) + 1;
+                k = m / (BigNumLength)BN_DIGIT_SIZE;
+                s = m % (BigNumLength)BN_DIGIT_SIZE;
 
+                if (k >= yl) {
                         /*
-                         * Sign is the sign of y.
+                         * Only the sign is left: 0 or -1.
                          */
-                        BzSetSign(z, BzGetSign(y));
-                        return z;
+
+                        ql    = 1;
+                        rn[0] = (sign == BZ_MINUS) ? BN_ONE : BN_ZERO;
                 } else {
-                        int ll;
-                        BigNumLength zl;
-                        int len = (int)BN_DIGIT_SIZE - 1;
+                        /*
+                         * Rounding a negative y towards -infinity adds
+                         * 1 to the magnitude when a bit shifted out is
+                         * set.
+                         */
+                        const BigNumBool inexact
+                                = (BigNumBool)((sign == BZ_MINUS)
+                                               && (BzLowestSetBit(y) < m));
 
-                        zl = (BigNumLength)n / BN_DIGIT_SIZE;
+                        ql = yl - k;
 
-                        if (((BigNumLength)n % BN_DIGIT_SIZE) != 0) {
-                                ++zl;
-                        }
+                        BnnAssign(rn, yn + k, ql);
+                        (void)BnnShiftRight(rn, ql, s);
 
-                        zl += BzNumDigits(y);
+                        if (sign == BZ_MINUS) {
+                                rn[ql++] = BN_ZERO;
 
-                        if ((z = BzCreate(zl)) == BZNULL) {
-                                return z;
+                                if (inexact == BN_TRUE) {
+                                        (void)BnnAddCarry(rn, ql, BN_CARRY);
+                                }
                         }
+                }
+        }
 
-                        BnnAssign(BzToBn(z), BzToBn(y), BzNumDigits(y));
-                        BzSetSign(z, BzGetSign(y));
-
-                        /*
-                         * Now do the shift by BN_DIGIT_SIZE increment.
-                         */
+        /*
+         * Clear what is left of the previous value of r.
+         */
 
-                        for (ll = n; ll >= (int)BN_DIGIT_SIZE; ll -= len) {
-                                (void)BnnShiftLeft(BzToBn(z),
-                                                   zl,
-                                                   (BigNumLength)len);
-                        }
+        if (ql < rl) {
+                BnnSetToZero(rn + ql, rl - ql);
+        }
 
-                        (void)BnnShiftLeft(BzToBn(z), zl, (BigNumLength)ll);
-                }
-        } else if (n < 0) {
-                BigZ one;
-                BigZ d;
+        if (BnnIsZero(rn, ql) == BN_TRUE) {
+                BzSetSign(r, BZ_ZERO);
+        } else {
+                BzSetSign(r, sign);
+        }
 
-                if (y == BZNULL) {
-                        return BZNULL;
-                } else if (BzGetSign(y) == BZ_ZERO) {
-                        return BzCopy(y);
-                }
+        return r;
+}
 
-                if ((one = BzFromInteger((BzInt)1)) == BZNULL) {
-                        return BZNULL;
-                }
+/**
+ * BzAsh.
+ * Returns y << n, a right shift (n < 0) rounds towards -infinity.
+ * @param [in] y BigZ
+ * @param [in] n int
+ * @return BigZ
+ * @pre y != BZNULL.
+ */
+BigZ
+BzAsh(const BigZ y, int n) {
+        BigZ z;
 
-                if ((d = BzAsh(one, -n)) == BZNULL) {
-                        BzFree(one);
-                        return BZNULL;
-                }
+        if (y == BZNULL) {
+                return BZNULL;
+        }
 
-                z = BzFloor(y, d);
-                BzFree(d);
-                BzFree(one);
-        } else {
-                /* n == 0, strange but legal. */
-                return BzCopy(y);
+        if ((z = BzCreate(BzAshSize(y, n))) != BZNULL) {
+                (void)BzAshTo(z, y, n);
         }
 
         return z;
 }
 
+/**
+ * BzAshInPlace.
+ * Shifts z by n bits as BzAsh, changing z. It only allocates when z has
+ * to grow.
+ * @param [in,out] z BigZ
+ * @param [in] n int
+ * @return z, or a new BigZ if z had to grow (z is then freed), or
+ * BZNULL on error (z is then unchanged).
+ * @pre z != BZNULL.
+ */
+BigZ
+BzAshInPlace(BigZ z, int n) {
+        const BigNumLength need = BzAshSize(z, n);
+        BigZ               r;
+
+        if (BzGetSize(z) >= need) {
+                return BzAshTo(z, z, n);
+        }
+
+        if ((r = BzCreate(need)) != BZNULL) {
+                (void)BzAshTo(r, z, n);
+                BzFree(z);
+        }
+
+        return r;
+}
+
 /**
  * BzSqrt.
  * @param [in] z BigZ
@@ -2832,7 +4254,6 @@ BigZ
 BzSqrt(const BigZ z) {
         BigNumLength n;
         BigZ         x;
-        BigZ         two;
 
         if (BzGetSign(z) == BZ_ZERO) {
                 return BzFromInteger((BzInt)0);
@@ -2859,8 +4280,6 @@ BzSqrt(const BigZ z) {
                 BzFree(one);
         }
 
-        two = BzFromInteger((BzInt)2);
-
         for (;;) {
                 const BigZ y = BzFloor(z, x);
                 BigZ v;
@@ -2870,20 +4289,17 @@ BzSqrt(const BigZ z) {
                         break;
                 }
 
+                /*
+                 * x = (x + y) / 2, halving the sum in place.
+                 */
+
                 v = BzAdd(x, y);
 
                 BzFree(x);
-                x = BzFloor(v, two);
-                BzFree(v);
+                x = BzAshInPlace(v, -1);
                 BzFree(y);
         }
 
-        /*
-         * Free temporary two
-         */
-
-        BzFree(two);
-
         return x;
 }
 
@@ -2968,139 +4384,317 @@ BzGcd(const BigZ y, const BigZ z) {
         }
 }
 
-static BigNumDigit BzInternalRandom(BzSeed *seed);
-
-#if defined(HAVE_STDINT_H)
-typedef uint32_t BzUInt32;
-#else
-typedef unsigned int BzUInt32;
-#endif
+static BzUInt64 BzSplitMix64(BzUInt64 *x);
+static BzUInt64 BzRandomNextSource(void *state);
+static BigNumDigit BzRandomDigit(BzRandomSource next, void *state);
 
-#define BZ_XORSHIFT
+/** @cond */
+#define BzRotl64(x, k)          (((x) << (k)) | ((x) >> (64 - (k))))
+/** @endcond */
 
 /**
- * BzInternalRandom
- * Compute an internal  portable pseudo random value.
- * @param [in] seed pointer to current BzSeed value.
- * @return BigNumDigit in range [0 .. 32767]
+ * BzSplitMix64
+ * Steps a splitmix64 generator, used to expand a seed into a
+ * xoshiro256** state.
+ * http://prng.di.unimi.it/splitmix64.c
+ * @param [in,out] x pointer to the splitmix64 state.
+ * @return BzUInt64
  */
-static BigNumDigit
-BzInternalRandom(BzSeed *seed) {
-        BzUInt32 s;
+static BzUInt64
+BzSplitMix64(BzUInt64 *x) {
+        BzUInt64 z;
 
-        if (seed == (BzSeed *)0) {
-                /*
-                 * Should not happen. Returns 0 instead of hanging.
-                 */
-                return 0;
-        }
+        *x += (BzUInt64)0x9e3779b97f4a7c15ULL;
+        z   = *x;
+        z   = (z ^ (z >> 30)) * (BzUInt64)0xbf58476d1ce4e5b9ULL;
+        z   = (z ^ (z >> 27)) * (BzUInt64)0x94d049bb133111ebULL;
 
-        s = *seed;
+        return z ^ (z >> 31);
+}
+
+/**
+ * BzRandomSeed
+ * Initializes a random state from a 64 bit seed. Equal seeds give
+ * equal sequences.
+ * @param [out] state BzRandomState
+ * @param [in] seed BzUInt64
+ */
+void
+BzRandomSeed(BzRandomState *state, BzUInt64 seed) {
+        int i;
 
-#if !defined(BZ_XORSHIFT)
-        /*
-         * http://en.wikipedia.org/wiki/Linear_congruential_generator
-         * a - 1 is divisible by all prime factors of m.
-         * (In our case m = 2^32, size of the int, so m has only one prime
-         * factor = 2)
-         * a - 1 is a multiple of 4 if m is a multiple of 4.
-         * (32768 is multiple of 4, and 1103515244 too)
-         */
-        *seed = (BzSeed)(s * 1103515245 + 12345);
-        return (BigNumDigit)(((BzUInt32)*seed / 65536) % 32768);
-#else
         /*
-         * https://en.wikipedia.org/wiki/Xorshift
-         * Algorithm "xor" from p. 4 of Marsaglia, "Xorshift RNGs"
-         * We subtract 1 in order to be able to return 0.
+         * splitmix64 never produces four zero words in a row, so the
+         * state is never the all-zero fixed point of xoshiro256**.
          */
-        if (s == 0) {
-                s = 1; /* otherwise it will infinitely return 0. */
+
+        for (i = 0; i < 4; ++i) {
+                state->S[i] = BzSplitMix64(&seed);
         }
+}
 
-        s ^= s << 13;
-        s ^= s >> 17;
-        s ^= s << 5;
-        *seed = s;
+/**
+ * BzRandomNext
+ * Returns the next 64 random bits of a state, xoshiro256** algorithm.
+ * http://prng.di.unimi.it/xoshiro256starstar.c
+ * @param [in,out] state BzRandomState
+ * @return BzUInt64
+ */
+BzUInt64
+BzRandomNext(BzRandomState *state) {
+        BzUInt64 *s      = state->S;
+        BzUInt64  result = BzRotl64(s[1] * 5, 7) * 9;
+        BzUInt64  t      = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3]  = BzRotl64(s[3], 45);
+
+        return result;
+}
 
-#if defined(BZ_TRACE_MIN_MAX_SEED)
-        {
-                static BigNumDigit _min = ~0;
-                static BigNumDigit _max = 0;
+/**
+ * BzRandomJump
+ * Advances a state by 2^128 steps, as many calls of BzRandomNext. A
+ * state and its copies jumped 1, 2, ... times give non-overlapping
+ * sequences for independent workers.
+ * http://prng.di.unimi.it/xoshiro256starstar.c
+ * @param [in,out] state BzRandomState
+ */
+void
+BzRandomJump(BzRandomState *state) {
+        static const BzUInt64 jump[4] = {
+                (BzUInt64)0x180ec6d33cfd0abaULL,
+                (BzUInt64)0xd5a61266f0c9392cULL,
+                (BzUInt64)0xa9582618e03fc9aaULL,
+                (BzUInt64)0x39abdc4529b1661cULL
+        };
+        BzUInt64 s[4] = { 0, 0, 0, 0 };
+        int      i;
+        int      b;
+
+        for (i = 0; i < 4; ++i) {
+                for (b = 0; b < 64; ++b) {
+                        if ((jump[i] & ((BzUInt64)1 << b)) != 0) {
+                                s[0] ^= state->S[0];
+                                s[1] ^= state->S[1];
+                                s[2] ^= state->S[2];
+                                s[3] ^= state->S[3];
+                        }
+                        (void)BzRandomNext(state);
+                }
+        }
 
-                BigNumDigit val = (BigNumDigit)(((BzUInt32)*seed - 1) % 32768);
+        for (i = 0; i < 4; ++i) {
+                state->S[i] = s[i];
+        }
+}
 
-                if (val > _max) {
-                        (void)printf("New _max = %x\n", val);
-                        _max = val;
-                }
+/**
+ * BzRandomSplit
+ * Initializes child with the current sequence of parent, then jumps
+ * parent ahead so that the two sequences do not overlap.
+ * @param [in,out] parent BzRandomState
+ * @param [out] child BzRandomState
+ */
+void
+BzRandomSplit(BzRandomState *parent, BzRandomState *child) {
+        *child = *parent;
+        BzRandomJump(parent);
+}
 
-                if (val < _min) {
-                        (void)printf("New _min = %x\n", val);
-                        _min = val;
-                }
+/**
+ * BzRandomNextSource
+ * BzRandomSource reading a BzRandomState.
+ * @param [in,out] state BzRandomState
+ * @return BzUInt64
+ */
+static BzUInt64
+BzRandomNextSource(void *state) {
+        return BzRandomNext((BzRandomState *)state);
+}
+
+/**
+ * BzRandomDigit
+ * Returns a BigNumDigit made of random bits, using as few source
+ * calls as the digit size allows.
+ * @param [in] next BzRandomSource
+ * @param [in,out] state state of next
+ * @return BigNumDigit
+ */
+static BigNumDigit
+BzRandomDigit(BzRandomSource next, void *state) {
+        BigNumDigit  d = 0;
+        BigNumLength i;
+
+        /*
+         * One call for 32 or 64 bit digits, two for 128 bit digits. The
+         * shift by 64 is made in steps of 16, as in BzHash, so that it
+         * stays defined for 32-bit digits.
+         */
 
-                return val;
+        for (i = 0; i < BN_DIGIT_SIZE; i += 64) {
+                d = (((d << 16) << 16) << 16) << 16;
+                d |= (BigNumDigit)(*next)(state);
         }
-#else
-        return (BigNumDigit)(((BzUInt32)*seed - 1) % 32768);
-#endif
-#endif
+
+        return d;
 }
 
 /**
- * BzRandom
- * @param [in] n BigZ
- * @param [in] seed BzSeed 
+ * BzRandomBitsFrom
+ * Returns a random non negative BigZ of at most bits bits, all values
+ * in [0, 2^bits) being equally likely, drawing 64 bits at a time from
+ * a random source.
+ * @param [in] bits BigNumLength
+ * @param [in] next BzRandomSource
+ * @param [in,out] state state of next
  * @return BigZ
- * @pre n != BZNULL && seed != NULL
+ * @pre next != NULL
  */
 BigZ
-BzRandom(const BigZ n, BzSeed *seed) {
-        BigZ r;
-        BigZ res;
-        BigNumLength len;
+BzRandomBitsFrom(BigNumLength bits, BzRandomSource next, void *state) {
+        BigNumLength nl = BzDigitsForBits(bits);
         BigNumLength i;
-        BigNumLength bytes;
-
-        /*
-         * Algo:
-         * - create empty r as big as n
-         * - call BzInternalRandom() to replace all its bytes (8 bits a a time).
-         * - return r mod n.
-         * Assume any bit has an equiprobable [0-1] value.
-         */
+        BigZ         r;
 
-        if ((r = BzCreate(BzNumDigits(n))) == BZNULL) {
+        if ((r = BzCreate((nl == 0) ? (BigNumLength)1 : nl)) == BZNULL) {
                 return BZNULL;
         }
 
-        len   = BzLength(n);
-        bytes = len / BN_BYTE_SIZE;
+        for (i = 0; i < nl; ++i) {
+                BzSetDigit(r, i, BzRandomDigit(next, state));
+        }
+
+        if ((bits % BN_DIGIT_SIZE) != 0) {
+                BigNumDigit mask = (BN_ONE << (bits % BN_DIGIT_SIZE)) - 1;
 
-        if (len % BN_BYTE_SIZE) {
-                ++bytes;
+                BzSetDigit(r, nl - 1, BzGetDigit(r, nl - 1) & mask);
         }
 
-        for (i = 0; bytes > 0; ++i) {
-                BigNumLength j;
-                BigNumDigit  *d = BzToBn(r) + i;
+        if (BnnIsZero(BzToBn(r), BzGetSize(r)) == BN_FALSE) {
+                BzSetSign(r, BZ_PLUS);
+        }
 
-                for (j = 0;
-                     (bytes > 0) && (j < (BigNumLength)sizeof(BigNumDigit));
-                     ++j) {
-                        BigNumDigit chunk = (BzInternalRandom(seed) & 0xff);
-                        *d += (chunk << (j * BN_BYTE_SIZE));
-                        --bytes;
-                }
+        return r;
+}
+
+/**
+ * BzRandomBelowFrom
+ * Returns a random BigZ in [0, n), all values being equally likely,
+ * drawing 64 bits at a time from a random source.
+ * @param [in] n BigZ
+ * @param [in] next BzRandomSource
+ * @param [in,out] state state of next
+ * @return BigZ or BZNULL if n <= 0.
+ * @pre n != BZNULL && next != NULL
+ */
+BigZ
+BzRandomBelowFrom(const BigZ n, BzRandomSource next, void *state) {
+        BigNumLength nl;
+        BigNumDigit  top;
+        BigNumDigit  mask;
+        BigNum       rn;
+        BigZ         r;
+
+        if (BzGetSign(n) != BZ_PLUS) {
+                return BZNULL;
+        }
+
+        nl   = BzNumDigits(n);
+        top  = BzGetDigit(n, nl - 1);
+        mask = BN_COMPLEMENT >> (BN_DIGIT_SIZE - BnnNumLength(&top, 1));
+
+        if ((r = BzCreate(nl)) == BZNULL) {
+                return BZNULL;
         }
 
+        rn = BzToBn(r);
+
         /*
-         * Call BzMod to ensure result is less than n.
+         * Rejection sampling: draw BzLength(n) bits until the value is
+         * below n, less than two draws on average. The top digit is
+         * drawn first so that most rejections are decided before the
+         * lower digits are drawn.
          */
-        res = BzMod(r, n);
 
-        BzFree(r);
+        for (;;) {
+                BigNumLength i;
+
+                rn[nl - 1] = BzRandomDigit(next, state) & mask;
+
+                if (rn[nl - 1] > top) {
+                        continue;
+                }
+
+                for (i = 0; i < nl - 1; ++i) {
+                        rn[i] = BzRandomDigit(next, state);
+                }
+
+                if ((rn[nl - 1] < top)
+                    || ((nl > 1)
+                        && (BnnCompare(rn, nl - 1, BzToBn(n), nl - 1) == BN_LT))) {
+                        break;
+                }
+        }
+
+        if (BnnIsZero(rn, nl) == BN_FALSE) {
+                BzSetSign(r, BZ_PLUS);
+        }
+
+        return r;
+}
+
+/**
+ * BzRandomBits
+ * Returns a random non negative BigZ of at most bits bits, all values
+ * in [0, 2^bits) being equally likely.
+ * @param [in] bits BigNumLength
+ * @param [in,out] state BzRandomState
+ * @return BigZ
+ * @pre state != NULL
+ */
+BigZ
+BzRandomBits(BigNumLength bits, BzRandomState *state) {
+        return BzRandomBitsFrom(bits, BzRandomNextSource, (void *)state);
+}
+
+/**
+ * BzRandomBelow
+ * Returns a random BigZ in [0, n), all values being equally likely.
+ * @param [in] n BigZ
+ * @param [in,out] state BzRandomState
+ * @return BigZ or BZNULL if n <= 0.
+ * @pre n != BZNULL && state != NULL
+ */
+BigZ
+BzRandomBelow(const BigZ n, BzRandomState *state) {
+        return BzRandomBelowFrom(n, BzRandomNextSource, (void *)state);
+}
+
+/**
+ * BzRandom
+ * Returns a random BigZ in [0, n) using a 32 bit seed, which is
+ * updated so that successive calls give different values. The seed
+ * only selects a BzRandomState, use BzRandomBelow to keep a full
+ * state between calls.
+ * @param [in] n BigZ
+ * @param [in,out] seed BzSeed
+ * @return BigZ or BZNULL if n <= 0.
+ * @pre n != BZNULL && seed != NULL
+ */
+BigZ
+BzRandom(const BigZ n, BzSeed *seed) {
+        BzRandomState state;
+        BigZ          res;
+
+        BzRandomSeed(&state, (BzUInt64)*seed);
+
+        res   = BzRandomBelow(n, &state);
+        *seed = (BzSeed)(BzRandomNext(&state) >> 32);
 
         return res;
 }
@@ -3176,11 +4770,12 @@ BzPow(const BigZ base, BzUInt exponent) {
  */
 BigZ
 BzModExp(const BigZ base, const BigZ exponent, const BigZ modulus) {
-        BigZ result;
-        BigZ mod;
-        BigZ expnt;
-        BigZ b;
-        int  neg;
+        BigZ         result;
+        BigZ         mod;
+        BigZ         b;
+        BigNumLength el;
+        BigNumLength i;
+        int          neg;
 
         if ((result = BzFromInteger((BzInt)1)) == BZNULL) {
                 return BZNULL;
@@ -3249,25 +4844,21 @@ BzModExp(const BigZ base, const BigZ exponent, const BigZ modulus) {
                 }
 
                 /*
-                 * Copy exponent as it will be modified.
+                 * Read the bits of exponent in place rather than
+                 * shifting it, and skip the last squaring.
                  */
 
-                if ((expnt = BzCopy(exponent)) == BZNULL) {
-                        BzFreeIf(neg, mod);
-                        BzFree(b);
-                        BzFree(result);
-                        return BZNULL;
-                }
+                el = BzLength(exponent);
 
-                while (BzGetSign(expnt) == BZ_PLUS) {
+                for (i = 0; i < el; ++i) {
                         BigZ tmp;
 
-                        if (BzIsOdd(expnt)) {
+                        if (((BzGetDigit(exponent, i / BN_DIGIT_SIZE)
+                              >> (i % BN_DIGIT_SIZE)) & BN_ONE) != 0) {
                                 tmp = BzMultiply(result, b);
                                 BzFree(result);
                                 if (tmp == BZNULL) {
                                         BzFreeIf(neg, mod);
-                                        BzFree(expnt);
                                         BzFree(b);
                                         return BZNULL;
                                 }
@@ -3275,22 +4866,19 @@ BzModExp(const BigZ base, const BigZ exponent, const BigZ modulus) {
                                 BzFree(tmp);
                                 if (result == BZNULL) {
                                         BzFreeIf(neg, mod);
-                                        BzFree(expnt);
                                         BzFree(b);
                                         return BZNULL;
                                 }
                         }
-                        /*
-                         * expnt = expnt >> 1;
-                         */
-                        tmp = BzAsh(expnt, -1);
-                        BzFree(expnt);
-                        expnt = tmp;
+
+                        if (i + 1 == el) {
+                                break;
+                        }
+
                         tmp = BzMultiply(b, b);
                         BzFree(b);
                         if (tmp == BZNULL) {
                                 BzFreeIf(neg, mod);
-                                BzFree(expnt);
                                 BzFree(result);
                                 return BZNULL;
                         }
@@ -3298,13 +4886,11 @@ BzModExp(const BigZ base, const BigZ exponent, const BigZ modulus) {
                         BzFree(tmp);
                         if (b == BZNULL) {
                                 BzFreeIf(neg, mod);
-                                BzFree(expnt);
                                 BzFree(result);
                                 return BZNULL;
                         }
                 }
 
-                BzFree(expnt);
                 BzFree(b);
 
                 if (neg) {
@@ -55,6 +55,7 @@ extern  "C"     {
 
 #include <stdlib.h>
 #include <float.h>
+#include <limits.h>
 
 /** @cond */
 #define BZ_PURE_FUNCTION                BN_PURE_FUNCTION
@@ -90,6 +91,46 @@ typedef enum {
         BZ_GT    = BN_GT
 } BzCmp;
 
+/**
+ * BzBoole operations, as in Common Lisp boole. The value of an
+ * operation is its truth table: bit 2 * a + b is the result for bits a
+ * of the first operand and b of the second one.
+ */
+typedef enum {
+        /** 0. */
+        BZ_BOOLE_CLR   = 0,
+        /** ~(a | b). */
+        BZ_BOOLE_NOR   = 1,
+        /** ~a & b. */
+        BZ_BOOLE_ANDC1 = 2,
+        /** ~a. */
+        BZ_BOOLE_C1    = 3,
+        /** a & ~b. */
+        BZ_BOOLE_ANDC2 = 4,
+        /** ~b. */
+        BZ_BOOLE_C2    = 5,
+        /** a ^ b. */
+        BZ_BOOLE_XOR   = 6,
+        /** ~(a & b). */
+        BZ_BOOLE_NAND  = 7,
+        /** a & b. */
+        BZ_BOOLE_AND   = 8,
+        /** ~(a ^ b). */
+        BZ_BOOLE_EQV   = 9,
+        /** b. */
+        BZ_BOOLE_2     = 10,
+        /** ~a | b. */
+        BZ_BOOLE_ORC1  = 11,
+        /** a. */
+        BZ_BOOLE_1     = 12,
+        /** a | ~b. */
+        BZ_BOOLE_ORC2  = 13,
+        /** a | b. */
+        BZ_BOOLE_IOR   = 14,
+        /** -1, all bits set. */
+        BZ_BOOLE_SET   = 15
+} BzBooleOp;
+
 /** @cond */
 typedef enum {
         BZ_UNTIL_END     = 0,
@@ -149,6 +190,12 @@ typedef const BigZStruct *              __CBigZ;
  */
 #define BZ_FORCE_SIGN                   1
 
+/**
+ * Returned by BzScan0, BzScan1 and BzLowestSetBit when there is no such
+ * bit.
+ */
+#define BZ_NO_BIT                       ((BigNumLength)~(BigNumLength)0)
+
 /*
  * macros of bigz.c
  */
@@ -195,28 +242,79 @@ typedef unsigned int                    BzUInt;
 
 #if !defined(BZ_DBL_MAX) && defined(LDBL_MAX)
 #define BZ_DBL_MAX                      LDBL_MAX
+#define BZ_LDBL_MANT_DIG                LDBL_MANT_DIG
+#define BZ_LDBL_MIN_EXP                 LDBL_MIN_EXP
+#define BzLdexp(x, e)                   ldexpl((x), (e))
+#define BzFrexp(x, e)                   frexpl((x), (e))
 typedef long double                     BzLDouble;
 #endif
 
 #if !defined(BZ_DBL_MAX) && defined(DBL_MAX)
 #define BZ_DBL_MAX                      DBL_MAX
+#define BZ_LDBL_MANT_DIG                DBL_MANT_DIG
+#define BZ_LDBL_MIN_EXP                 DBL_MIN_EXP
+#define BzLdexp(x, e)                   ldexp((x), (e))
+#define BzFrexp(x, e)                   frexp((x), (e))
 typedef double                          BzLDouble;
 #endif
 
 #if !defined(BZ_DBL_MAX)
 #define BZ_DBL_MAX                      ((double)+1.7976931348623158e+308)
+#define BZ_LDBL_MANT_DIG                53
+#define BZ_LDBL_MIN_EXP                 (-1021)
+#define BzLdexp(x, e)                   ldexp((x), (e))
+#define BzFrexp(x, e)                   frexp((x), (e))
 typedef double                          BzLDouble;
 #endif
 
+#if defined(DBL_MANT_DIG)
+#define BZ_DBL_MANT_DIG                 DBL_MANT_DIG
+#define BZ_DBL_MIN_EXP                  DBL_MIN_EXP
+#else
+#define BZ_DBL_MANT_DIG                 53
+#define BZ_DBL_MIN_EXP                  (-1021)
+#endif
+
 /*
  * Random seed type, by contract it must be an unsigned int.
  */
 typedef unsigned int                    BzSeed;
 
+#if !defined(BZ_UINT64_TYPE)
+#define BZ_UINT64_TYPE
+#if defined(HAVE_STDINT_H)
+typedef uint64_t                        BzUInt64;
+#else
+typedef unsigned long long              BzUInt64;
+#endif
+#endif
+
+/*
+ * State of the xoshiro256** generator used by the random functions,
+ * initialized by BzRandomSeed.
+ */
+typedef struct {
+        BzUInt64 S[4];
+} BzRandomState;
+
+/*
+ * Source of random bits for BzRandomBitsFrom and BzRandomBelowFrom,
+ * returns the next 64 bits drawn from state.
+ */
+typedef BzUInt64 (*BzRandomSource)(void *state);
+
 #define BZ_OPTIMIZE_PRINT
 
+/*
+ * Size of BigNumDigit in bits, as chosen by bign.h (BN_DIGIT_SIZE can't
+ * be used by the preprocessor).
+ */
 #if !defined(BZ_BUCKET_SIZE)
-#if (defined(SIZEOF_LONG) && (SIZEOF_LONG == 8))
+#if defined(BN_EXPERIMENTAL_128BIT)
+#define BZ_BUCKET_SIZE 128
+#elif (defined(HAVE_STDINT_H) && defined(SIZEOF_VOID_P) && (SIZEOF_VOID_P >= 8)) \
+      || (defined(SIZEOF_LONG) && (SIZEOF_LONG == 8))                          \
+      || (ULONG_MAX > 0xffffffffUL)
 #define BZ_BUCKET_SIZE 64
 #else
 #define BZ_BUCKET_SIZE 32
@@ -263,6 +361,17 @@ typedef unsigned int                    BzSeed;
 #define BzSetDigit(z, n, v)             (__toBzObj(z)->Digits[n]   = (v))
 /** @endcond */
 
+/**
+ * Largest number of digits of a BigZ, BzCreate fails above it. The bit
+ * length of a BigZ, and sums of a few digit counts, fit a BigNumLength,
+ * and byte sizes a size_t, so size computations below it cannot wrap.
+ */
+#define BZ_MAX_DIGITS                                                   \
+        ((BN_LENGTH_MAX / BN_DIGIT_SIZE                                 \
+          < ((size_t)-1) / (4 * sizeof(BigNumDigit)))                   \
+         ? (BigNumLength)(BN_LENGTH_MAX / BN_DIGIT_SIZE)                \
+         : (BigNumLength)(((size_t)-1) / (4 * sizeof(BigNumDigit))))
+
 /*
  *      functions of bigz.c
  */
@@ -275,6 +384,7 @@ extern BigZ         BzCopy(const BigZ z);
 extern BigZ         BzNegate(const BigZ z);
 extern BigZ         BzAbs(const BigZ z);
 extern BzCmp        BzCompare(const BigZ y, const BigZ z) BZ_PURE_FUNCTION;
+extern BzUInt       BzHash(const BigZ z) BZ_PURE_FUNCTION;
 extern BigZ         BzAdd(const BigZ y, const BigZ z);
 extern BigZ         BzSubtract(const BigZ y, const BigZ z);
 extern BigZ         BzMultiply(const BigZ y, const BigZ z);
@@ -300,6 +410,8 @@ extern BigZ         BzFromUnsignedInteger(BzUInt i);
 extern BzInt        BzToInteger(const BigZ z) BZ_PURE_FUNCTION;
 extern double       BzToDouble(const BigZ z) BZ_PURE_FUNCTION;
 extern BzLDouble    BzToLongDouble(const BigZ z) BZ_PURE_FUNCTION;
+extern double       BzToDoubleScaled(const BigZ z, long scale, BigNumBool inexact) BZ_PURE_FUNCTION;
+extern BzLDouble    BzToLongDoubleScaled(const BigZ z, long scale, BigNumBool inexact) BZ_PURE_FUNCTION;
 extern int          BzToIntegerPointer(const BigZ z, BzInt *p);
 extern BzUInt       BzToUnsignedInteger(const BigZ z) BZ_PURE_FUNCTION;
 extern int          BzToUnsignedIntegerPointer(const BigZ z, BzUInt *p);
@@ -307,6 +419,19 @@ extern BigZ         BzFromBigNum(const BigNum n, BigNumLength nl);
 extern BigNum       BzToBigNum(const BigZ z, BigNumLength *nl);
 extern BigNumBool   BzTestBit(BigNumLength bit, const BigZ z);
 extern BigNumLength BzBitCount(const BigZ z);
+extern BigNumLength BzScan0(const BigZ z, BigNumLength start);
+extern BigNumLength BzScan1(const BigZ z, BigNumLength start);
+extern BigNumLength BzLowestSetBit(const BigZ z);
+extern BigZ         BzSetBit(const BigZ z, BigNumLength bit);
+extern BigZ         BzClearBit(const BigZ z, BigNumLength bit);
+extern BigZ         BzFlipBit(const BigZ z, BigNumLength bit);
+extern BigZ         BzExtractBits(const BigZ z, BigNumLength start, BigNumLength len);
+extern BigZ         BzDepositBits(const BigZ z, BigNumLength start, BigNumLength len, const BigZ v);
+extern BigZ         BzSetBitInPlace(BigZ z, BigNumLength bit);
+extern BigZ         BzClearBitInPlace(BigZ z, BigNumLength bit);
+extern BigZ         BzFlipBitInPlace(BigZ z, BigNumLength bit);
+extern BigZ         BzDepositBitsInPlace(BigZ z, BigNumLength start, BigNumLength len, const BigZ v);
+extern BigZ         BzBoole(BzBooleOp op, const BigZ y, const BigZ z);
 extern BigZ         BzNot(const BigZ z);
 extern BigZ         BzAnd(const BigZ y, const BigZ z);
 extern BigZ         BzOr(const BigZ y, const BigZ z);
@@ -319,10 +444,21 @@ extern BigZ         BzAndC2(const BigZ x, const BigZ y);
 extern BigZ         BzOrC1(const BigZ x, const BigZ y);
 extern BigZ         BzOrC2(const BigZ x, const BigZ y);
 extern BigZ         BzAsh(const BigZ y, int n);
+extern BigNumLength BzAshSize(const BigZ y, int n);
+extern BigZ         BzAshTo(BigZ r, const BigZ y, int n);
+extern BigZ         BzAshInPlace(BigZ z, int n);
 extern BigZ         BzSqrt(const BigZ z);
 extern BigZ         BzLcm(const BigZ y, const BigZ z);
 extern BigZ         BzGcd(const BigZ y, const BigZ z);
 extern BigZ         BzRandom(const BigZ n, BzSeed *seed);
+extern void         BzRandomSeed(BzRandomState *state, BzUInt64 seed);
+extern BzUInt64     BzRandomNext(BzRandomState *state);
+extern void         BzRandomJump(BzRandomState *state);
+extern void         BzRandomSplit(BzRandomState *parent, BzRandomState *child);
+extern BigZ         BzRandomBits(BigNumLength bits, BzRandomState *state);
+extern BigZ         BzRandomBelow(const BigZ n, BzRandomState *state);
+extern BigZ         BzRandomBitsFrom(BigNumLength bits, BzRandomSource next, void *state);
+extern BigZ         BzRandomBelowFrom(const BigZ n, BzRandomSource next, void *state);
 extern BigZ         BzModExp(const BigZ base, const BigZ exponent, const BigZ modulus);
 
 /*
@@ -0,0 +1,256 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bnthread.c
+ * @brief provides the thread pool of large BigNum operations.
+ *
+ * BnnParallelFor runs the parts of a task on the calling thread and on
+ * BnnGetThreads() - 1 worker threads, each taking the next part not
+ * started yet so that faster threads do more parts. There is a single
+ * pool: a call made while another thread is using it, or from a task,
+ * runs its parts on the calling thread alone.
+ *
+ * The pool is empty until BnnSetThreads is called, and always empty on
+ * Windows, where every task runs on the calling thread.
+ */
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#define BN_HAVE_PTHREAD
+#endif
+
+#include <stdlib.h>
+
+#if !defined(__BNTHREAD_H)
+#include "./bnthread.h"
+#endif
+
+#if defined(BN_HAVE_PTHREAD)
+/** @cond */
+/*
+ * BnnPoolCall is held by the thread running a task on the pool, or
+ * changing its size. BnnPoolLock protects the other variables.
+ */
+static pthread_mutex_t BnnPoolCall = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t BnnPoolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  BnnPoolWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  BnnPoolDone = PTHREAD_COND_INITIALIZER;
+static pthread_t *     BnnPoolThreads;
+static unsigned int    BnnPoolSize;
+static unsigned long   BnnPoolGeneration;
+static int             BnnPoolStop;
+static BnnTask         BnnPoolTask;
+static void *          BnnPoolArg;
+static BigNumLength    BnnPoolNext;
+static BigNumLength    BnnPoolCount;
+static BigNumLength    BnnPoolFinished;
+/** @endcond */
+
+static void     BnnPoolRun(void);
+static void *   BnnPoolWorker(void *unused);
+static void     BnnPoolShutdown(void);
+
+/**
+ * BnnPoolRun.
+ * Runs parts of the current task until none is left to start.
+ * @pre BnnPoolLock is held.
+ */
+static void
+BnnPoolRun(void) {
+        while (BnnPoolNext < BnnPoolCount) {
+                const BigNumLength i = BnnPoolNext++;
+
+                (void)pthread_mutex_unlock(&BnnPoolLock);
+                BnnPoolTask(BnnPoolArg, i);
+                (void)pthread_mutex_lock(&BnnPoolLock);
+
+                if (++BnnPoolFinished == BnnPoolCount) {
+                        (void)pthread_cond_broadcast(&BnnPoolDone);
+                }
+        }
+}
+
+/**
+ * BnnPoolWorker.
+ * Body of the worker threads, joins each new task until the pool stops.
+ * @param [in] unused
+ * @return NULL
+ */
+static void *
+BnnPoolWorker(void *unused) {
+        unsigned long seen;
+
+        (void)unused;
+        (void)pthread_mutex_lock(&BnnPoolLock);
+        seen = BnnPoolGeneration;
+
+        for (;;) {
+                while (BnnPoolStop == 0 && BnnPoolGeneration == seen) {
+                        (void)pthread_cond_wait(&BnnPoolWork, &BnnPoolLock);
+                }
+
+                if (BnnPoolStop != 0) {
+                        break;
+                }
+
+                seen = BnnPoolGeneration;
+                BnnPoolRun();
+        }
+
+        (void)pthread_mutex_unlock(&BnnPoolLock);
+        return NULL;
+}
+
+/**
+ * BnnPoolShutdown.
+ * Stops and joins the worker threads.
+ * @pre BnnPoolCall is held.
+ */
+static void
+BnnPoolShutdown(void) {
+        unsigned int i;
+
+        (void)pthread_mutex_lock(&BnnPoolLock);
+        BnnPoolStop = 1;
+        (void)pthread_cond_broadcast(&BnnPoolWork);
+        (void)pthread_mutex_unlock(&BnnPoolLock);
+
+        for (i = 0; i < BnnPoolSize; ++i) {
+                (void)pthread_join(BnnPoolThreads[i], NULL);
+        }
+
+        free(BnnPoolThreads);
+        BnnPoolThreads = NULL;
+        BnnPoolSize    = 0;
+        BnnPoolStop    = 0;
+}
+#endif  /* BN_HAVE_PTHREAD */
+
+/**
+ * BnnGetThreads.
+ * Returns the number of threads BnnParallelFor runs tasks on, the
+ * calling thread included.
+ * @return unsigned int, at least 1.
+ */
+unsigned int
+BnnGetThreads(void) {
+#if defined(BN_HAVE_PTHREAD)
+        unsigned int n;
+
+        (void)pthread_mutex_lock(&BnnPoolLock);
+        n = BnnPoolSize + 1;
+        (void)pthread_mutex_unlock(&BnnPoolLock);
+
+        return n;
+#else
+        return 1;
+#endif
+}
+
+/**
+ * BnnSetThreads.
+ * Sets the number of threads BnnParallelFor runs tasks on, the calling
+ * thread included, waiting for a task running on the pool to finish.
+ * 1 runs every task on the calling thread, 0 uses one thread per
+ * online processor.
+ * @param [in] n unsigned int
+ * @return unsigned int, the number of threads, which is lower than n
+ * when threads cannot be created.
+ */
+unsigned int
+BnnSetThreads(unsigned int n) {
+#if defined(BN_HAVE_PTHREAD)
+        unsigned int i;
+
+        if (n == 0) {
+                const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+                n = (cpus > 0) ? (unsigned int)cpus : 1;
+        }
+
+        (void)pthread_mutex_lock(&BnnPoolCall);
+
+        BnnPoolShutdown();
+
+        if (n > 1
+            && (BnnPoolThreads = (pthread_t *)malloc((n - 1)
+                                                     * sizeof(pthread_t))) != NULL) {
+                (void)pthread_mutex_lock(&BnnPoolLock);
+
+                for (i = 0; i < n - 1; ++i) {
+                        if (pthread_create(&BnnPoolThreads[i],
+                                           NULL,
+                                           BnnPoolWorker,
+                                           NULL) != 0) {
+                                break;
+                        }
+                }
+
+                BnnPoolSize = i;
+                (void)pthread_mutex_unlock(&BnnPoolLock);
+        }
+
+        (void)pthread_mutex_unlock(&BnnPoolCall);
+
+        return BnnGetThreads();
+#else
+        (void)n;
+        return 1;
+#endif
+}
+
+/**
+ * BnnParallelFor.
+ * Calls task(arg, i) for each i in [0, count), on the threads of the
+ * pool, and returns when all calls have returned. The calls may run in
+ * any order and at the same time, so they must not write to the same
+ * memory.
+ * @param [in] count BigNumLength
+ * @param [in] task BnnTask
+ * @param [in] arg passed to task
+ */
+void
+BnnParallelFor(BigNumLength count, BnnTask task, void *arg) {
+        BigNumLength i;
+
+#if defined(BN_HAVE_PTHREAD)
+        if (count > 1 && pthread_mutex_trylock(&BnnPoolCall) == 0) {
+                (void)pthread_mutex_lock(&BnnPoolLock);
+
+                if (BnnPoolSize != 0) {
+                        BnnPoolTask     = task;
+                        BnnPoolArg      = arg;
+                        BnnPoolNext     = 0;
+                        BnnPoolCount    = count;
+                        BnnPoolFinished = 0;
+                        ++BnnPoolGeneration;
+                        (void)pthread_cond_broadcast(&BnnPoolWork);
+
+                        BnnPoolRun();
+
+                        while (BnnPoolFinished < BnnPoolCount) {
+                                (void)pthread_cond_wait(&BnnPoolDone,
+                                                        &BnnPoolLock);
+                        }
+
+                        (void)pthread_mutex_unlock(&BnnPoolLock);
+                        (void)pthread_mutex_unlock(&BnnPoolCall);
+                        return;
+                }
+
+                (void)pthread_mutex_unlock(&BnnPoolLock);
+                (void)pthread_mutex_unlock(&BnnPoolCall);
+        }
+#endif
+
+        for (i = 0; i < count; ++i) {
+                task(arg, i);
+        }
+}
@@ -0,0 +1,39 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bnthread.h
+ * @brief Thread pool spreading the work of large BigNum operations over
+ * several cores.
+ */
+
+#if !defined(__BNTHREAD_H)
+#define __BNTHREAD_H
+
+#if !defined(__BIGN_H)
+#include "./bign.h"
+#endif
+
+#if defined(__cplusplus)
+extern  "C"     {
+#endif
+
+/**
+ * A task run by BnnParallelFor, i is the index of the part to do.
+ */
+typedef void (*BnnTask)(void *arg, BigNumLength i);
+
+extern unsigned int BnnGetThreads(void);
+extern unsigned int BnnSetThreads(unsigned int n);
+extern void         BnnParallelFor(BigNumLength count, BnnTask task, void *arg);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  /* __BNTHREAD_H */
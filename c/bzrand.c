@@ -0,0 +1,440 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bzrand.c
+ * @brief provides cryptographically secure random BigZ.
+ *
+ * Random bytes are produced by ChaCha20 keyed from operating system
+ * entropy (getrandom(2) on Linux, arc4random_buf(3) on BSD and macOS,
+ * rand_s on Windows, /dev/urandom elsewhere). Each refill generates
+ * BZ_SECURE_BLOCKS blocks at once; the first 32 bytes become the next
+ * key and are erased, the others are served and erased as they are
+ * read. New entropy is read after BZ_SECURE_RESEED bytes, or when the
+ * process has forked, so that many keys can be generated with few
+ * system calls.
+ *
+ * A state must not be used by two threads at the same time.
+ *
+ * @note Functions return BZNULL on error (out of memory, entropy that
+ * cannot be read), the Error member of the state tells which.
+ */
+
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+#if defined(_WIN32) && !defined(_CRT_RAND_S)
+#define _CRT_RAND_S
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/random.h>
+#endif
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if !defined(__BZRAND_H)
+#include "./bzrand.h"
+#endif
+
+/** @cond */
+#if defined(HAVE_STDINT_H)
+typedef uint32_t BzUInt32;
+#else
+typedef unsigned int BzUInt32;
+#endif
+
+#define BzRotl32(x, k)          ((BzUInt32)(((x) << (k)) | ((x) >> (32 - (k)))))
+
+#define BzQuarterRound(x, a, b, c, d)                                   \
+        x[a] += x[b]; x[d] ^= x[a]; x[d] = BzRotl32(x[d], 16);          \
+        x[c] += x[d]; x[b] ^= x[c]; x[b] = BzRotl32(x[b], 12);          \
+        x[a] += x[b]; x[d] ^= x[a]; x[d] = BzRotl32(x[d], 8);           \
+        x[c] += x[d]; x[b] ^= x[c]; x[b] = BzRotl32(x[b], 7)
+
+#if !defined(_WIN32)
+/*
+ * BzForkCount is incremented in the child by a pthread_atfork handler,
+ * installed once by BzForkInit. BzForkHandler tells whether it could be.
+ */
+static pthread_once_t   BzForkOnce = PTHREAD_ONCE_INIT;
+static long             BzForkCount;
+static int              BzForkHandler;
+#endif
+/** @endcond */
+
+static BzUInt32 BzLoad32(const unsigned char *p);
+static void     BzStore32(unsigned char *p, BzUInt32 v);
+static void     BzChaChaBlock(const unsigned char *key,
+                              BzUInt32 counter,
+                              const BzUInt32 *nonce,
+                              unsigned char *out);
+static int      BzOsEntropy(unsigned char *buf, size_t len);
+#if !defined(_WIN32)
+static void     BzForkChild(void);
+static void     BzForkInit(void);
+#endif
+static long     BzForkGeneration(void);
+static int      BzSecureRandomRefill(BzSecureRandomState *state);
+static void     BzSecureRandomCheckFork(BzSecureRandomState *state);
+
+/**
+ * BzLoad32.
+ * Reads a little endian 32 bit word.
+ * @param [in] p bytes
+ * @return BzUInt32
+ */
+static BzUInt32
+BzLoad32(const unsigned char *p) {
+        return (BzUInt32)p[0]
+               | ((BzUInt32)p[1] << 8)
+               | ((BzUInt32)p[2] << 16)
+               | ((BzUInt32)p[3] << 24);
+}
+
+/**
+ * BzStore32.
+ * Writes a little endian 32 bit word.
+ * @param [out] p bytes
+ * @param [in] v BzUInt32
+ */
+static void
+BzStore32(unsigned char *p, BzUInt32 v) {
+        p[0] = (unsigned char)(v & 0xff);
+        p[1] = (unsigned char)((v >> 8) & 0xff);
+        p[2] = (unsigned char)((v >> 16) & 0xff);
+        p[3] = (unsigned char)((v >> 24) & 0xff);
+}
+
+/**
+ * BzChaChaBlock.
+ * Computes a 64 bytes ChaCha20 block (RFC 8439).
+ * @param [in] key 32 bytes
+ * @param [in] counter block counter
+ * @param [in] nonce 3 words
+ * @param [out] out 64 bytes
+ */
+static void
+BzChaChaBlock(const unsigned char *key,
+              BzUInt32 counter,
+              const BzUInt32 *nonce,
+              unsigned char *out) {
+        BzUInt32 in[16];
+        BzUInt32 x[16];
+        int      i;
+
+        in[0]  = (BzUInt32)0x61707865U;
+        in[1]  = (BzUInt32)0x3320646eU;
+        in[2]  = (BzUInt32)0x79622d32U;
+        in[3]  = (BzUInt32)0x6b206574U;
+
+        for (i = 0; i < 8; ++i) {
+                in[4 + i] = BzLoad32(key + 4 * i);
+        }
+
+        in[12] = counter;
+        in[13] = nonce[0];
+        in[14] = nonce[1];
+        in[15] = nonce[2];
+
+        for (i = 0; i < 16; ++i) {
+                x[i] = in[i];
+        }
+
+        for (i = 0; i < 10; ++i) {
+                BzQuarterRound(x, 0, 4,  8, 12);
+                BzQuarterRound(x, 1, 5,  9, 13);
+                BzQuarterRound(x, 2, 6, 10, 14);
+                BzQuarterRound(x, 3, 7, 11, 15);
+                BzQuarterRound(x, 0, 5, 10, 15);
+                BzQuarterRound(x, 1, 6, 11, 12);
+                BzQuarterRound(x, 2, 7,  8, 13);
+                BzQuarterRound(x, 3, 4,  9, 14);
+        }
+
+        for (i = 0; i < 16; ++i) {
+                BzStore32(out + 4 * i, (BzUInt32)(x[i] + in[i]));
+        }
+
+        (void)memset(in, 0, sizeof(in));
+        (void)memset(x, 0, sizeof(x));
+}
+
+/**
+ * BzOsEntropy.
+ * Fills a buffer with operating system entropy.
+ * @param [out] buf bytes
+ * @param [in] len size of buf, at most 256
+ * @return 1 on success, 0 on failure.
+ */
+static int
+BzOsEntropy(unsigned char *buf, size_t len) {
+#if defined(__linux__)
+        size_t done = 0;
+
+        while (done < len) {
+                ssize_t got = getrandom(buf + done, len - done, 0);
+
+                if (got < 0) {
+                        if (errno == EINTR) {
+                                continue;
+                        }
+                        return 0;
+                }
+
+                done += (size_t)got;
+        }
+
+        return 1;
+#elif defined(__APPLE__) || defined(__OpenBSD__) \
+      || defined(__FreeBSD__) || defined(__NetBSD__)
+        arc4random_buf(buf, len);
+        return 1;
+#elif defined(_WIN32)
+        size_t i;
+
+        for (i = 0; i < len; i += 4) {
+                unsigned int v;
+                size_t       j;
+
+                if (rand_s(&v) != 0) {
+                        return 0;
+                }
+
+                for (j = 0; (j < 4) && (i + j < len); ++j) {
+                        buf[i + j] = (unsigned char)((v >> (8 * j)) & 0xff);
+                }
+        }
+
+        return 1;
+#else
+        FILE *f = fopen("/dev/urandom", "rb");
+        int   ok;
+
+        if (f == NULL) {
+                return 0;
+        }
+
+        ok = (fread(buf, 1, len, f) == len);
+        (void)fclose(f);
+
+        return ok;
+#endif
+}
+
+#if !defined(_WIN32)
+/**
+ * BzForkChild.
+ * Runs in the child process after fork.
+ */
+static void
+BzForkChild(void) {
+        ++BzForkCount;
+}
+
+/**
+ * BzForkInit.
+ * Installs BzForkChild, once per process.
+ */
+static void
+BzForkInit(void) {
+        BzForkHandler = (pthread_atfork(NULL, NULL, BzForkChild) == 0);
+}
+#endif
+
+/**
+ * BzForkGeneration.
+ * Returns a number that changes in a child process after fork: the
+ * number of forks seen by BzForkChild, or the process id if it could
+ * not be installed, 0 where processes cannot fork.
+ * @return long
+ */
+static long
+BzForkGeneration(void) {
+#if defined(_WIN32)
+        return 0;
+#else
+        (void)pthread_once(&BzForkOnce, BzForkInit);
+
+        return BzForkHandler ? BzForkCount : (long)getpid();
+#endif
+}
+
+/**
+ * BzSecureRandomRefill.
+ * Refills the buffer of a state, reading operating system entropy
+ * first when needed.
+ * @param [in,out] state BzSecureRandomState
+ * @return 1 on success, 0 if entropy cannot be read.
+ */
+static int
+BzSecureRandomRefill(BzSecureRandomState *state) {
+        static const BzUInt32 nonce[3] = { 0, 0, 0 };
+        unsigned char         seed[sizeof(state->Key)];
+        const long            generation = BzForkGeneration();
+        size_t                i;
+
+        if ((state->Count == 0) || (state->Fork != generation)) {
+                /*
+                 * Mix new entropy into the key rather than replacing
+                 * it, a weak source can then only add to the state.
+                 */
+
+                if (BzOsEntropy(seed, sizeof(seed)) == 0) {
+                        state->Error = 1;
+                        return 0;
+                }
+
+                for (i = 0; i < sizeof(seed); ++i) {
+                        state->Key[i] ^= seed[i];
+                }
+
+                (void)memset(seed, 0, sizeof(seed));
+                state->Count = BZ_SECURE_RESEED;
+                state->Fork  = generation;
+        }
+
+        /*
+         * The key changes at each refill, so the counter can start at 0
+         * with a constant nonce.
+         */
+
+        for (i = 0; i < BZ_SECURE_BLOCKS; ++i) {
+                BzChaChaBlock(state->Key,
+                              (BzUInt32)i,
+                              nonce,
+                              state->Buffer + 64 * i);
+        }
+
+        (void)memcpy(state->Key, state->Buffer, sizeof(state->Key));
+        (void)memset(state->Buffer, 0, sizeof(state->Key));
+
+        state->Avail  = sizeof(state->Buffer) - sizeof(state->Key);
+        state->Count -= (state->Count < sizeof(state->Buffer))
+                        ? state->Count
+                        : sizeof(state->Buffer);
+
+        return 1;
+}
+
+/**
+ * BzSecureRandomCheckFork.
+ * Discards the buffer and forces a reseed of a state seeded in another
+ * process, so that a forked child does not repeat the bytes of its
+ * parent. Checked once per generated number rather than per word; it
+ * makes no system call unless the fork handler cannot be installed.
+ * @param [in,out] state BzSecureRandomState
+ */
+static void
+BzSecureRandomCheckFork(BzSecureRandomState *state) {
+        state->Error = 0;
+
+        if (state->Fork != BzForkGeneration()) {
+                (void)memset(state->Buffer, 0, sizeof(state->Buffer));
+                state->Avail = 0;
+                state->Count = 0;
+        }
+}
+
+/**
+ * BzSecureRandomNext.
+ * Returns the next 64 random bits of a secure state. It is a
+ * BzRandomSource, suitable for BzRandomBitsFrom and BzRandomBelowFrom.
+ * Unlike BzSecureRandomBits and BzSecureRandomBelow, it does not check
+ * whether the process has forked since the state was last seeded.
+ * @param [in,out] state BzSecureRandomState
+ * @return BzUInt64, 0 with the Error member set if entropy cannot be
+ * read.
+ */
+BzUInt64
+BzSecureRandomNext(void *state) {
+        BzSecureRandomState *s = (BzSecureRandomState *)state;
+        unsigned char       *p;
+        BzUInt64             v;
+
+        if ((s->Avail < 8) && (BzSecureRandomRefill(s) == 0)) {
+                return 0;
+        }
+
+        p = s->Buffer + sizeof(s->Buffer) - s->Avail;
+        v = ((BzUInt64)BzLoad32(p + 4) << 32) | (BzUInt64)BzLoad32(p);
+
+        (void)memset(p, 0, 8);
+        s->Avail -= 8;
+
+        return v;
+}
+
+/**
+ * BzSecureRandomBits.
+ * Returns a secure random non negative BigZ of at most bits bits.
+ * @param [in] bits BigNumLength
+ * @param [in,out] state BzSecureRandomState
+ * @return BigZ or BZNULL on error.
+ */
+BigZ
+BzSecureRandomBits(BigNumLength bits, BzSecureRandomState *state) {
+        BigZ r;
+
+        BzSecureRandomCheckFork(state);
+        r = BzRandomBitsFrom(bits, BzSecureRandomNext, (void *)state);
+
+        if ((r != BZNULL) && (state->Error != 0)) {
+                BzFree(r);
+                return BZNULL;
+        }
+
+        return r;
+}
+
+/**
+ * BzSecureRandomBelow.
+ * Returns a secure random BigZ in [0, n), by the same rejection sampling
+ * as BzRandomBelow.
+ * @param [in] n BigZ
+ * @param [in,out] state BzSecureRandomState
+ * @return BigZ or BZNULL if n <= 0 or on error.
+ */
+BigZ
+BzSecureRandomBelow(const BigZ n, BzSecureRandomState *state) {
+        BigZ r;
+
+        BzSecureRandomCheckFork(state);
+        r = BzRandomBelowFrom(n, BzSecureRandomNext, (void *)state);
+
+        if ((r != BZNULL) && (state->Error != 0)) {
+                BzFree(r);
+                return BZNULL;
+        }
+
+        return r;
+}
+
+/**
+ * BzSecureRandomWipe.
+ * Erases a secure state. It reads new entropy on its next use.
+ * @param [out] state BzSecureRandomState
+ */
+void
+BzSecureRandomWipe(BzSecureRandomState *state) {
+        volatile unsigned char *p = (volatile unsigned char *)state;
+        size_t                  i;
+
+        for (i = 0; i < sizeof(*state); ++i) {
+                p[i] = 0;
+        }
+}
@@ -0,0 +1,75 @@
+/*
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2025, Lars Nilsson
+ *
+ * See the LICENSE file at the top of this project for details.
+ */
+
+/**
+ * @file bzrand.h
+ * @brief Types and structures for clients of the secure random BigZ
+ * functions.
+ */
+
+#if !defined(__BZRAND_H)
+#define __BZRAND_H
+
+#if !defined(__BIGZ_H)
+#include "./bigz.h"
+#endif
+
+#if defined(__cplusplus)
+extern  "C"     {
+#endif
+
+/**
+ * Number of ChaCha20 blocks, 64 bytes each, generated per refill of the
+ * buffer of a BzSecureRandomState.
+ */
+#define BZ_SECURE_BLOCKS                16
+
+/**
+ * Number of bytes generated from a key before new entropy is read from
+ * the operating system.
+ */
+#define BZ_SECURE_RESEED                ((size_t)1 << 20)
+
+/** @cond */
+/**
+ * State of the secure generator: a ChaCha20 key, replaced at each
+ * refill by the first bytes of the output so that past outputs cannot be
+ * recovered from the state, and a buffer of generated bytes. A state
+ * filled with zeros is valid and reads operating system entropy on its
+ * first use.
+ */
+typedef struct {
+        /** current ChaCha20 key. */
+        unsigned char Key[32];
+        /** generated bytes, the last Avail of which are not used yet. */
+        unsigned char Buffer[64 * BZ_SECURE_BLOCKS];
+        /** number of unused bytes in Buffer. */
+        size_t        Avail;
+        /** number of bytes to generate before reseeding. */
+        size_t        Count;
+        /** fork generation the key was seeded in, to reseed after fork. */
+        long          Fork;
+        /** non zero if operating system entropy could not be read. */
+        int           Error;
+} BzSecureRandomState;
+/** @endcond */
+
+/*
+ * functions of bzrand.c
+ */
+
+extern BzUInt64  BzSecureRandomNext(void *state);
+extern BigZ      BzSecureRandomBits(BigNumLength bits, BzSecureRandomState *state);
+extern BigZ      BzSecureRandomBelow(const BigZ n, BzSecureRandomState *state);
+extern void      BzSecureRandomWipe(BzSecureRandomState *state);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  /* __BZRAND_H */
@@ -1,7 +1,28 @@
+#if defined(BIGZ_STATS) && defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
 #include <janet.h>
+#include <limits.h>
 #include "bigz.h"
 #include "bign.h"
 #include "bigq.h"
+#include "bigf.h"
+#include "bigd.h"
+#include "bigm.h"
+#include "bzrand.h"
+#include "bnthread.h"
+
+#ifdef BIGZ_STATS
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 static int bigz_gc(BigZ *p, size_t s)
 {
@@ -9,13 +30,74 @@ static int bigz_gc(BigZ *p, size_t s)
     return 0;
 }
 
+/* Digits are marshalled as 32-bit words so the format does not depend
+ * on the BigNumDigit size the module was built with. */
+#define BIGZ_WORD_BITS 32
+#define BIGZ_WORDS_PER_DIGIT (BN_DIGIT_SIZE / BIGZ_WORD_BITS)
+
+static void bigz_marshal_value(BigZ z, JanetMarshalContext *ctx)
+{
+    BigNumLength zl = BzNumDigits(z);
+    BigNumLength i;
+    janet_marshal_int(ctx, (int32_t)BzGetSign(z));
+    janet_marshal_size(ctx, (size_t)zl * BIGZ_WORDS_PER_DIGIT);
+    for (i = 0; i < zl; ++i) {
+        BigNumDigit d = BzGetDigit(z, i);
+        size_t w;
+        for (w = 0; w < BIGZ_WORDS_PER_DIGIT; ++w) {
+            janet_marshal_int(ctx, (int32_t)(uint32_t)(d & 0xffffffffU));
+            d = (d >> 16) >> 16;
+        }
+    }
+}
+
+/* Reads a bigz into *slot, which owns it from the moment it is created
+ * so that nothing leaks if the data turns out to be truncated. Data
+ * written with a different digit size can hold a word count that is not
+ * a multiple of BIGZ_WORDS_PER_DIGIT, the top digit is then zero-filled. */
+static void bigz_unmarshal_value(JanetMarshalContext *ctx, BigZ *slot)
+{
+    int32_t sign = janet_unmarshal_int(ctx);
+    size_t words = janet_unmarshal_size(ctx);
+    size_t digits;
+    BigZ z;
+    size_t i;
+    if (sign < BZ_MINUS || sign > BZ_PLUS || words == 0) {
+        janet_panic("invalid bigz in marshalled data");
+    }
+    janet_unmarshal_ensure(ctx, words);
+    digits = words / BIGZ_WORDS_PER_DIGIT + (words % BIGZ_WORDS_PER_DIGIT != 0);
+    if (digits > BZ_MAX_DIGITS || (z = BzCreate((BigNumLength)digits)) == BZNULL) {
+        janet_panic("out of memory");
+    }
+    *slot = z;
+    for (i = 0; i < words; ++i) {
+        BigNumDigit w = (BigNumDigit)(uint32_t)janet_unmarshal_int(ctx);
+        size_t shift = (i % BIGZ_WORDS_PER_DIGIT) * BIGZ_WORD_BITS;
+        BzSetDigit(z, i / BIGZ_WORDS_PER_DIGIT,
+                   BzGetDigit(z, i / BIGZ_WORDS_PER_DIGIT) | (w << shift));
+    }
+    if (BnnIsZero(BzToBn(z), (BigNumLength)digits)) {
+        BzSetSign(z, BZ_ZERO);
+    } else if (sign == BZ_ZERO) {
+        janet_panic("invalid bigz in marshalled data");
+    } else {
+        BzSetSign(z, (BzSign)sign);
+    }
+}
+
 static void bigz_marshal(void *p, JanetMarshalContext *ctx)
 {
+    janet_marshal_abstract(ctx, p);
+    bigz_marshal_value(*(BigZ *)p, ctx);
 }
 
 static void *bigz_unmarshal(JanetMarshalContext *ctx)
 {
-    return NULL;
+    BigZ *bz_n = janet_unmarshal_abstract(ctx, sizeof(BigZ *));
+    *bz_n = BZNULL;
+    bigz_unmarshal_value(ctx, bz_n);
+    return bz_n;
 }
 
 static void bigz_tostring(BigZ *bz_n, JanetBuffer *buffer)
@@ -30,19 +112,805 @@ static int bigz_compare(BigZ *a, BigZ *b)
     return BzCompare(*a, *b);
 }
 
+static int32_t bigz_hash(void *p, size_t len)
+{
+    return (int32_t)BzHash(*(BigZ *)p);
+}
+
 const JanetAbstractType janet_bigz_type = {
     .name = "bigz/BigZ",
     .gc = bigz_gc,
-    // .marshal = bigz_marshal,
-    // .unmarshal = bigz_unmarshal,
-    .marshal = NULL,
-    .unmarshal = NULL,
+    .marshal = bigz_marshal,
+    .unmarshal = bigz_unmarshal,
     .tostring = bigz_tostring,
     .compare = bigz_compare,
-    JANET_ATEND_COMPARE
+    .hash = bigz_hash,
+    JANET_ATEND_HASH
+};
+
+/* Reads a bigz that is part of another number into a bigz/BigZ, so the
+ * collector frees it if reading the rest of the number panics. */
+static BigZ *bigz_unmarshal_part(JanetMarshalContext *ctx)
+{
+    BigZ *part = janet_abstract(&janet_bigz_type, sizeof(BigZ));
+    *part = BZNULL;
+    bigz_unmarshal_value(ctx, part);
+    return part;
+}
+
+static void bigz_unmarshal_part_free(BigZ *part)
+{
+    BzFree(*part);
+    *part = BZNULL;
+}
+
+static int bigz_mutable_gc(void *p, size_t s)
+{
+    BzFree(*(BigZ *)p);
+    return 0;
+}
+
+static void bigz_mutable_tostring(void *p, JanetBuffer *buffer)
+{
+    bigz_tostring((BigZ *)p, buffer);
+}
+
+/* A bigz that the ! bit functions change in place. It is kept apart
+ * from bigz/BigZ, which is immutable and can be used as a key. */
+const JanetAbstractType janet_bigz_mutable_type = {
+    .name = "bigz/MutableBigZ",
+    .gc = bigz_mutable_gc,
+    .tostring = bigz_mutable_tostring,
+    JANET_ATEND_TOSTRING
+};
+
+static int bigq_gc(void *p, size_t s)
+{
+    BqDelete(*(BigQ *)p);
+    return 0;
+}
+
+static void bigq_marshal(void *p, JanetMarshalContext *ctx)
+{
+    BigQ q = *(BigQ *)p;
+    janet_marshal_abstract(ctx, p);
+    bigz_marshal_value(BqGetNumerator(q), ctx);
+    bigz_marshal_value(BqGetDenominator(q), ctx);
+}
+
+static void *bigq_unmarshal(JanetMarshalContext *ctx)
+{
+    BigQ *bq_q = janet_unmarshal_abstract(ctx, sizeof(BigQ));
+    BigZ *n;
+    BigZ *d;
+    *bq_q = BQNULL;
+    n = bigz_unmarshal_part(ctx);
+    d = bigz_unmarshal_part(ctx);
+    *bq_q = BqCreate(*n, *d);
+    bigz_unmarshal_part_free(n);
+    bigz_unmarshal_part_free(d);
+    if (*bq_q == BQNULL) {
+        janet_panic("invalid bigq in marshalled data");
+    }
+    return bq_q;
+}
+
+static void bigq_tostring(void *p, JanetBuffer *buffer)
+{
+    BzChar *q_str = BqToString(*(BigQ *)p, BQ_DEFAULT_SIGN);
+    if (q_str == NULL) {
+        janet_panic("out of memory");
+    }
+    janet_buffer_push_cstring(buffer, q_str);
+    BzFreeString(q_str);
+}
+
+static int bigq_compare(void *a, void *b)
+{
+    BqCmp cmp = BqCompare(*(BigQ *)a, *(BigQ *)b);
+    if (cmp == BQ_ERR) {
+        janet_panic("out of memory");
+    }
+    return cmp;
+}
+
+static int32_t bigq_hash(void *p, size_t len)
+{
+    BigQ q = *(BigQ *)p;
+    BzUInt h = BzHash(BqGetNumerator(q));
+    return (int32_t)(h * 31 + BzHash(BqGetDenominator(q)));
+}
+
+const JanetAbstractType janet_bigq_type = {
+    .name = "bigz/BigQ",
+    .gc = bigq_gc,
+    .marshal = bigq_marshal,
+    .unmarshal = bigq_unmarshal,
+    .tostring = bigq_tostring,
+    .compare = bigq_compare,
+    .hash = bigq_hash,
+    JANET_ATEND_HASH
+};
+
+static int bigq_acc_gc(void *p, size_t s)
+{
+    BqAccDelete(*(BigQAcc *)p);
+    return 0;
+}
+
+static void bigq_acc_tostring(void *p, JanetBuffer *buffer)
+{
+    BigQ q = BqAccValue(*(BigQAcc *)p);
+    BzChar *q_str;
+    if (q == BQNULL) {
+        janet_panic("out of memory");
+    }
+    q_str = BqToString(q, BQ_DEFAULT_SIGN);
+    BqDelete(q);
+    if (q_str == NULL) {
+        janet_panic("out of memory");
+    }
+    janet_buffer_push_cstring(buffer, q_str);
+    BzFreeString(q_str);
+}
+
+const JanetAbstractType janet_bigq_acc_type = {
+    .name = "bigz/BigQAcc",
+    .gc = bigq_acc_gc,
+    .tostring = bigq_acc_tostring,
+    JANET_ATEND_TOSTRING
+};
+
+static int bigq_cf_gc(void *p, size_t s)
+{
+    BqCFDelete(*(BigQCF *)p);
+    return 0;
+}
+
+const JanetAbstractType janet_bigq_cf_type = {
+    .name = "bigz/BigQCF",
+    .gc = bigq_cf_gc,
+    JANET_ATEND_GC
+};
+
+/* Precision, in bits, of bigf numbers created without an explicit one. */
+#define BIGF_DEFAULT_PRECISION 128
+
+static int bigf_gc(void *p, size_t s)
+{
+    BfDelete(*(BigF *)p);
+    return 0;
+}
+
+static void bigf_marshal(void *p, JanetMarshalContext *ctx)
+{
+    BigF f = *(BigF *)p;
+    janet_marshal_abstract(ctx, p);
+    bigz_marshal_value(BfGetMantissa(f), ctx);
+    janet_marshal_int64(ctx, (int64_t)BfGetExponent(f));
+    janet_marshal_int(ctx, (int32_t)BfGetPrecision(f));
+}
+
+static void *bigf_unmarshal(JanetMarshalContext *ctx)
+{
+    BigF *bf_f = janet_unmarshal_abstract(ctx, sizeof(BigF));
+    BigZ *m;
+    int64_t e;
+    int32_t prec;
+    *bf_f = BFNULL;
+    m = bigz_unmarshal_part(ctx);
+    e = janet_unmarshal_int64(ctx);
+    prec = janet_unmarshal_int(ctx);
+    if (prec >= (int32_t)BF_MIN_PRECISION && e >= LONG_MIN && e <= LONG_MAX) {
+        *bf_f = BfFromMantissa(*m, (long)e, (BigNumLength)prec);
+    }
+    bigz_unmarshal_part_free(m);
+    if (*bf_f == BFNULL) {
+        janet_panic("invalid bigf in marshalled data");
+    }
+    return bf_f;
+}
+
+static void bigf_tostring(void *p, JanetBuffer *buffer)
+{
+    BzChar *f_str = BfToString(*(BigF *)p, 0);
+    if (f_str == NULL) {
+        janet_panic("out of memory");
+    }
+    janet_buffer_push_cstring(buffer, f_str);
+    BzFreeString(f_str);
+}
+
+static int bigf_compare(void *a, void *b)
+{
+    BfCmp cmp = BfCompare(*(BigF *)a, *(BigF *)b);
+    if (cmp == BF_ERR) {
+        janet_panic("out of memory");
+    }
+    return cmp;
+}
+
+static int32_t bigf_hash(void *p, size_t len)
+{
+    BigF f = *(BigF *)p;
+    BzUInt h = BzHash(BfGetMantissa(f));
+    return (int32_t)(h * 31 + (BzUInt)BfGetExponent(f));
+}
+
+const JanetAbstractType janet_bigf_type = {
+    .name = "bigz/BigF",
+    .gc = bigf_gc,
+    .marshal = bigf_marshal,
+    .unmarshal = bigf_unmarshal,
+    .tostring = bigf_tostring,
+    .compare = bigf_compare,
+    .hash = bigf_hash,
+    JANET_ATEND_HASH
+};
+
+static int bigd_gc(void *p, size_t s)
+{
+    BdDelete(*(BigD *)p);
+    return 0;
+}
+
+static void bigd_marshal(void *p, JanetMarshalContext *ctx)
+{
+    BigD d = *(BigD *)p;
+    janet_marshal_abstract(ctx, p);
+    bigz_marshal_value(BdGetCoefficient(d), ctx);
+    janet_marshal_size(ctx, (size_t)BdGetScale(d));
+}
+
+static void *bigd_unmarshal(JanetMarshalContext *ctx)
+{
+    BigD *bd_d = janet_unmarshal_abstract(ctx, sizeof(BigD));
+    BigZ *c;
+    size_t scale;
+    *bd_d = BDNULL;
+    c = bigz_unmarshal_part(ctx);
+    scale = janet_unmarshal_size(ctx);
+    *bd_d = BdCreate(*c, (BigNumLength)scale);
+    bigz_unmarshal_part_free(c);
+    if (*bd_d == BDNULL) {
+        janet_panic("invalid bigd in marshalled data");
+    }
+    return bd_d;
+}
+
+static void bigd_tostring(void *p, JanetBuffer *buffer)
+{
+    BzChar *d_str = BdToString(*(BigD *)p);
+    if (d_str == NULL) {
+        janet_panic("out of memory");
+    }
+    janet_buffer_push_cstring(buffer, d_str);
+    BzFreeString(d_str);
+}
+
+static int bigd_compare(void *a, void *b)
+{
+    BdCmp cmp = BdCompare(*(BigD *)a, *(BigD *)b);
+    if (cmp == BD_ERR) {
+        janet_panic("out of memory");
+    }
+    return cmp;
+}
+
+/* Equal numbers may have different scales, so hash the normalized form. */
+static int32_t bigd_hash(void *p, size_t len)
+{
+    BigD d = BdNormalize(*(BigD *)p);
+    BzUInt h;
+    if (d == BDNULL) {
+        janet_panic("out of memory");
+    }
+    h = BzHash(BdGetCoefficient(d)) * 31 + (BzUInt)BdGetScale(d);
+    BdDelete(d);
+    return (int32_t)h;
+}
+
+const JanetAbstractType janet_bigd_type = {
+    .name = "bigz/BigD",
+    .gc = bigd_gc,
+    .marshal = bigd_marshal,
+    .unmarshal = bigd_unmarshal,
+    .tostring = bigd_tostring,
+    .compare = bigd_compare,
+    .hash = bigd_hash,
+    JANET_ATEND_HASH
+};
+
+static void rng_marshal(void *p, JanetMarshalContext *ctx)
+{
+    BzRandomState *state = (BzRandomState *)p;
+    int i;
+    janet_marshal_abstract(ctx, p);
+    for (i = 0; i < 4; ++i) {
+        janet_marshal_int64(ctx, (int64_t)state->S[i]);
+    }
+}
+
+static void *rng_unmarshal(JanetMarshalContext *ctx)
+{
+    BzRandomState *state = janet_unmarshal_abstract(ctx, sizeof(BzRandomState));
+    int i;
+    for (i = 0; i < 4; ++i) {
+        state->S[i] = (BzUInt64)janet_unmarshal_int64(ctx);
+    }
+    /* xoshiro256** stays at zero forever from an all-zero state. */
+    if ((state->S[0] | state->S[1] | state->S[2] | state->S[3]) == 0) {
+        janet_panic("invalid bigz/RNG in marshalled data");
+    }
+    return state;
+}
+
+const JanetAbstractType janet_rng_type = {
+    .name = "bigz/RNG",
+    .marshal = rng_marshal,
+    .unmarshal = rng_unmarshal,
+    JANET_ATEND_UNMARSHAL
+};
+
+static int modctx_gc(void *p, size_t s)
+{
+    BmCtxDelete(*(BigMCtx *)p);
+    return 0;
+}
+
+static void modctx_tostring(void *p, JanetBuffer *buffer)
+{
+    BzChar *n_str = BzToString(BmCtxGetModulus(*(BigMCtx *)p), 10, 0);
+    if (n_str == NULL) {
+        janet_panic("out of memory");
+    }
+    janet_buffer_push_cstring(buffer, "mod ");
+    janet_buffer_push_cstring(buffer, n_str);
+    BzFreeString(n_str);
+}
+
+const JanetAbstractType janet_modctx_type = {
+    .name = "bigz/ModCtx",
+    .gc = modctx_gc,
+    .tostring = modctx_tostring,
+    JANET_ATEND_TOSTRING
+};
+
+/* A modint keeps the abstract holding its context so that the context
+ * outlives every element created in it. */
+typedef struct {
+    BigM m;
+    BigMCtx *ctx;
+} ModInt;
+
+static int modint_gc(void *p, size_t s)
+{
+    BmDelete(((ModInt *)p)->m);
+    return 0;
+}
+
+static int modint_gcmark(void *p, size_t s)
+{
+    janet_mark(janet_wrap_abstract(((ModInt *)p)->ctx));
+    return 0;
+}
+
+static void modint_tostring(void *p, JanetBuffer *buffer)
+{
+    BigZ z = BmToBigZ(((ModInt *)p)->m);
+    BzChar *m_str;
+    if (z == BZNULL) {
+        janet_panic("out of memory");
+    }
+    m_str = BzToString(z, 10, 0);
+    BzFree(z);
+    if (m_str == NULL) {
+        janet_panic("out of memory");
+    }
+    janet_buffer_push_cstring(buffer, m_str);
+    BzFreeString(m_str);
+}
+
+static int modint_compare(void *a, void *b)
+{
+    return BmCompare(((ModInt *)a)->m, ((ModInt *)b)->m);
+}
+
+static int32_t modint_hash(void *p, size_t len)
+{
+    return (int32_t)BmHash(((ModInt *)p)->m);
+}
+
+const JanetAbstractType janet_modint_type = {
+    .name = "bigz/ModInt",
+    .gc = modint_gc,
+    .gcmark = modint_gcmark,
+    .tostring = modint_tostring,
+    .compare = modint_compare,
+    .hash = modint_hash,
+    JANET_ATEND_HASH
 };
 
-JANET_FN(cfun_BzVersion,
+static Janet bigz_wrap_copy(BigZ z)
+{
+    BigZ *bz_result;
+    BigZ copy = BzCopy(z);
+    if (copy == BZNULL) {
+        janet_panic("out of memory");
+    }
+    bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = copy;
+    return janet_wrap_abstract(bz_result);
+}
+
+static Janet bigz_wrap(BigZ z)
+{
+    BigZ *bz_result;
+    if (z == BZNULL) {
+        janet_panic("out of memory");
+    }
+    bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = z;
+    return janet_wrap_abstract(bz_result);
+}
+
+/* Accepts a bigz or a mutable bigz. */
+static BigZ bigz_getbits(const Janet *argv, int32_t n)
+{
+    BigZ *bz_n = janet_checkabstract(argv[n], &janet_bigz_mutable_type);
+    if (bz_n == NULL) {
+        bz_n = janet_getabstract(argv, n, &janet_bigz_type);
+    }
+    return *bz_n;
+}
+
+/* A bit index or a count of bits or digits, as large as BigNumLength allows. */
+static BigNumLength bigz_getlength(const Janet *argv, int32_t n)
+{
+    size_t len = janet_getsize(argv, n);
+    if ((size_t)(BigNumLength)len != len) {
+        janet_panicf("bad slot #%d, expected length fitting a BigNumLength, got %v",
+                     n, argv[n]);
+    }
+    return (BigNumLength)len;
+}
+
+static BigNumLength bigz_optlength(const Janet *argv, int32_t argc, int32_t n,
+                                   BigNumLength dflt)
+{
+    if (n >= argc || janet_checktype(argv[n], JANET_NIL)) {
+        return dflt;
+    }
+    return bigz_getlength(argv, n);
+}
+
+static Janet bigq_wrap(BigQ q)
+{
+    BigQ *bq_result;
+    if (q == BQNULL) {
+        janet_panic("out of memory");
+    }
+    bq_result = janet_abstract(&janet_bigq_type, sizeof(BigQ));
+    *bq_result = q;
+    return janet_wrap_abstract(bq_result);
+}
+
+static Janet bigf_wrap(BigF f)
+{
+    BigF *bf_result;
+    if (f == BFNULL) {
+        janet_panic("out of memory");
+    }
+    bf_result = janet_abstract(&janet_bigf_type, sizeof(BigF));
+    *bf_result = f;
+    return janet_wrap_abstract(bf_result);
+}
+
+static Janet bigd_wrap(BigD d)
+{
+    BigD *bd_result;
+    if (d == BDNULL) {
+        janet_panic("out of memory");
+    }
+    bd_result = janet_abstract(&janet_bigd_type, sizeof(BigD));
+    *bd_result = d;
+    return janet_wrap_abstract(bd_result);
+}
+
+static Janet modint_wrap(BigM m, BigMCtx *ctx)
+{
+    ModInt *mi_result;
+    if (m == BMNULL) {
+        janet_panic("out of memory");
+    }
+    mi_result = janet_abstract(&janet_modint_type, sizeof(ModInt));
+    mi_result->m = m;
+    mi_result->ctx = ctx;
+    return janet_wrap_abstract(mi_result);
+}
+
+static ModInt *modint_get2(const Janet *argv, ModInt **b)
+{
+    ModInt *a = janet_getabstract(argv, 0, &janet_modint_type);
+    *b = janet_getabstract(argv, 1, &janet_modint_type);
+    if (BmGetCtx(a->m) != BmGetCtx((*b)->m)) {
+        janet_panic("modint contexts differ");
+    }
+    return a;
+}
+
+static BdRoundMode bigd_optmode(const Janet *argv, int32_t argc, int32_t n)
+{
+    if (argc <= n || janet_checktype(argv[n], JANET_NIL)) {
+        return BD_ROUND_HALF_EVEN;
+    }
+    janet_getkeyword(argv, n);
+    if (janet_keyeq(argv[n], "half-even")) {
+        return BD_ROUND_HALF_EVEN;
+    } else if (janet_keyeq(argv[n], "half-up")) {
+        return BD_ROUND_HALF_UP;
+    } else if (janet_keyeq(argv[n], "down")) {
+        return BD_ROUND_DOWN;
+    } else if (janet_keyeq(argv[n], "floor")) {
+        return BD_ROUND_FLOOR;
+    } else if (janet_keyeq(argv[n], "ceiling")) {
+        return BD_ROUND_CEILING;
+    }
+    janet_panicf("unknown rounding mode %v", argv[n]);
+}
+
+static BzBooleOp bigz_getboole(const Janet *argv, int32_t n)
+{
+    static const struct {
+        const char *name;
+        BzBooleOp op;
+    } ops[] = {
+        {"clr", BZ_BOOLE_CLR}, {"set", BZ_BOOLE_SET},
+        {"1", BZ_BOOLE_1}, {"2", BZ_BOOLE_2},
+        {"c1", BZ_BOOLE_C1}, {"c2", BZ_BOOLE_C2},
+        {"and", BZ_BOOLE_AND}, {"ior", BZ_BOOLE_IOR},
+        {"xor", BZ_BOOLE_XOR}, {"eqv", BZ_BOOLE_EQV},
+        {"nand", BZ_BOOLE_NAND}, {"nor", BZ_BOOLE_NOR},
+        {"andc1", BZ_BOOLE_ANDC1}, {"andc2", BZ_BOOLE_ANDC2},
+        {"orc1", BZ_BOOLE_ORC1}, {"orc2", BZ_BOOLE_ORC2}
+    };
+    size_t i;
+    if (janet_checkint(argv[n])) {
+        int32_t op = janet_unwrap_integer(argv[n]);
+        if (op < 0 || op > 15) {
+            janet_panicf("boole op must be in [0, 15], got %v", argv[n]);
+        }
+        return (BzBooleOp)op;
+    }
+    janet_getkeyword(argv, n);
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (janet_keyeq(argv[n], ops[i].name)) {
+            return ops[i].op;
+        }
+    }
+    janet_panicf("unknown boole op %v", argv[n]);
+}
+
+static BigNumLength bigf_optprecision(const Janet *argv, int32_t argc, int32_t n)
+{
+    int32_t prec = janet_optnat(argv, argc, n, BIGF_DEFAULT_PRECISION);
+    if (prec < (int32_t)BF_MIN_PRECISION) {
+        janet_panic("precision must be at least 2");
+    }
+    return (BigNumLength)prec;
+}
+
+/* Panics unless a + b, or a - b when subtract is set, fits a bigf exponent. */
+static void bigf_check_exponents(long a, long b, int subtract)
+{
+    int overflow = subtract
+        ? ((b < 0 && a > LONG_MAX + b) || (b > 0 && a < LONG_MIN + b))
+        : ((b > 0 && a > LONG_MAX - b) || (b < 0 && a < LONG_MIN - b));
+    if (overflow) {
+        janet_panic("bigf exponent out of range");
+    }
+}
+
+#ifdef BIGZ_STATS
+
+/* Counters kept per function when built with BIGZ_STATS and turned on
+ * with bigz/set-stats. Calls are counted by the digits of their largest
+ * operand and by the nanoseconds they take, in buckets of powers of two:
+ * bucket 0 counts zeros and bucket k > 0 values in [2^(k-1), 2^k), the
+ * last one everything above. Threads update them with relaxed atomic
+ * additions, so a snapshot taken while other threads run may be off by
+ * the calls in progress. */
+#define BIGZ_STATS_BUCKETS 48
+
+typedef struct BigzStat {
+    const char *usage;
+    struct BigzStat *next;
+    int listed;
+    uint64_t calls;
+    uint64_t nanoseconds;
+    uint64_t time[BIGZ_STATS_BUCKETS];
+    uint64_t digits[BIGZ_STATS_BUCKETS];
+} BigzStat;
+
+/* Functions called at least once with the counters on. */
+static BigzStat *bigz_stats_list;
+static int bigz_stats_enabled;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BIGZ_STATS_ADD(p, v)    __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define BIGZ_STATS_LOAD(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define BIGZ_STATS_STORE(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define BIGZ_STATS_ENABLED()    __atomic_load_n(&bigz_stats_enabled, __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+#define BIGZ_STATS_ADD(p, v)                                            \
+    _InterlockedExchangeAdd64((__int64 volatile *)(p), (__int64)(v))
+#define BIGZ_STATS_LOAD(p)                                              \
+    ((uint64_t)_InterlockedCompareExchange64((__int64 volatile *)(p), 0, 0))
+#define BIGZ_STATS_STORE(p, v)                                          \
+    _InterlockedExchange64((__int64 volatile *)(p), (__int64)(v))
+#define BIGZ_STATS_ENABLED()    (*(volatile int *)&bigz_stats_enabled)
+#else
+#define BIGZ_STATS_ADD(p, v)    (*(p) += (v))
+#define BIGZ_STATS_LOAD(p)      (*(p))
+#define BIGZ_STATS_STORE(p, v)  (*(p) = (v))
+#define BIGZ_STATS_ENABLED()    bigz_stats_enabled
+#endif
+
+/* Adds stat to bigz_stats_list the first time it is called. */
+static void bigz_stats_add_to_list(BigzStat *stat)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    int expected = 0;
+    BigzStat *head;
+    if (__atomic_load_n(&stat->listed, __ATOMIC_ACQUIRE)
+        || !__atomic_compare_exchange_n(&stat->listed, &expected, 1, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    head = __atomic_load_n(&bigz_stats_list, __ATOMIC_ACQUIRE);
+    do {
+        stat->next = head;
+    } while (!__atomic_compare_exchange_n(&bigz_stats_list, &head, stat, 0,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+#elif defined(_MSC_VER)
+    BigzStat *head;
+    if (*(volatile int *)&stat->listed
+        || _InterlockedCompareExchange((long volatile *)&stat->listed, 1, 0) != 0) {
+        return;
+    }
+    do {
+        head = *(BigzStat * volatile *)&bigz_stats_list;
+        stat->next = head;
+    } while (_InterlockedCompareExchangePointer(
+                 (void * volatile *)&bigz_stats_list, stat, head) != head);
+#else
+    if (!stat->listed) {
+        stat->listed = 1;
+        stat->next = bigz_stats_list;
+        bigz_stats_list = stat;
+    }
+#endif
+}
+
+static BigzStat *bigz_stats_first(void)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(&bigz_stats_list, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+    return *(BigzStat * volatile *)&bigz_stats_list;
+#else
+    return bigz_stats_list;
+#endif
+}
+
+#ifdef _WIN32
+/* Ticks per second of QueryPerformanceCounter, fixed at boot and read on
+ * first use. */
+static uint64_t bigz_stats_frequency;
+#endif
+
+static uint64_t bigz_stats_clock(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER count;
+    uint64_t freq = BIGZ_STATS_LOAD(&bigz_stats_frequency);
+    if (freq == 0) {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        freq = (uint64_t)f.QuadPart;
+        BIGZ_STATS_STORE(&bigz_stats_frequency, freq);
+    }
+    QueryPerformanceCounter(&count);
+    return (uint64_t)count.QuadPart / freq * 1000000000U
+        + (uint64_t)count.QuadPart % freq * 1000000000U / freq;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static int bigz_stats_bucket(uint64_t v)
+{
+    int k = 0;
+    while (v != 0 && k < BIGZ_STATS_BUCKETS - 1) {
+        v >>= 1;
+        k++;
+    }
+    return k;
+}
+
+/* The number of digits of the largest bigz, mutable bigz, bigq, bigf or
+ * bigd argument, 0 if there is none. */
+static BigNumLength bigz_stats_digits(int32_t argc, const Janet *argv)
+{
+    BigNumLength n = 0;
+    int32_t i;
+    for (i = 0; i < argc; i++) {
+        BigNumLength d;
+        void *p;
+        if ((p = janet_checkabstract(argv[i], &janet_bigz_type)) != NULL
+            || (p = janet_checkabstract(argv[i], &janet_bigz_mutable_type)) != NULL) {
+            d = BzNumDigits(*(BigZ *)p);
+        } else if ((p = janet_checkabstract(argv[i], &janet_bigq_type)) != NULL) {
+            BigNumLength dl = BzNumDigits(BqGetDenominator(*(BigQ *)p));
+            d = BzNumDigits(BqGetNumerator(*(BigQ *)p));
+            if (dl > d) {
+                d = dl;
+            }
+        } else if ((p = janet_checkabstract(argv[i], &janet_bigf_type)) != NULL) {
+            d = BzNumDigits(BfGetMantissa(*(BigF *)p));
+        } else if ((p = janet_checkabstract(argv[i], &janet_bigd_type)) != NULL) {
+            d = BzNumDigits(BdGetCoefficient(*(BigD *)p));
+        } else {
+            continue;
+        }
+        if (d > n) {
+            n = d;
+        }
+    }
+    return n;
+}
+
+/* Runs body, counting the call in stat when the counters are on. A call
+ * that panics or suspends its fiber is counted but not timed. */
+static Janet bigz_stats_call(BigzStat *stat, JanetCFunction body,
+                             int32_t argc, Janet *argv)
+{
+    uint64_t start, elapsed;
+    Janet result;
+    if (!BIGZ_STATS_ENABLED()) {
+        return body(argc, argv);
+    }
+    bigz_stats_add_to_list(stat);
+    BIGZ_STATS_ADD(&stat->calls, 1);
+    BIGZ_STATS_ADD(&stat->digits[bigz_stats_bucket(bigz_stats_digits(argc, argv))], 1);
+    start = bigz_stats_clock();
+    result = body(argc, argv);
+    elapsed = bigz_stats_clock() - start;
+    BIGZ_STATS_ADD(&stat->nanoseconds, elapsed);
+    BIGZ_STATS_ADD(&stat->time[bigz_stats_bucket(elapsed)], 1);
+    return result;
+}
+
+/* Defines the function like JANET_FN, with the body that follows run
+ * through bigz_stats_call. */
+#define BIGZ_FN(CNAME, USAGE, DOCSTRING)                                \
+    static Janet CNAME##_body(int32_t argc, Janet *argv);               \
+    static BigzStat CNAME##_stat = {.usage = USAGE};                    \
+    JANET_FN(CNAME, USAGE, DOCSTRING)                                   \
+    {                                                                   \
+        return bigz_stats_call(&CNAME##_stat, CNAME##_body, argc, argv); \
+    }                                                                   \
+    static Janet CNAME##_body(int32_t argc, Janet *argv)
+
+#else
+
+#define BIGZ_FN JANET_FN
+
+#endif
+
+BIGZ_FN(cfun_BzVersion,
     "(bigz/version)",
     "Returns a string containing the version of bigz being used.")
 {
@@ -51,38 +919,35 @@ JANET_FN(cfun_BzVersion,
     return janet_stringv(version, strlen(version));
 }
 
-JANET_FN(cfun_BzCreate,
+BIGZ_FN(cfun_BzCreate,
     "(bigz/create)",
     "Creates a new bigz instance. Not very useful since it can't be modified. "
     "The value of the instance will be zero.")
 {
     janet_fixarity(argc, 1);
-    BigNumLength size = janet_getuinteger(argv, 0);
-    BigZ *bz_n = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
-    *bz_n = BzCreate(size);
-
-    return janet_wrap_abstract(bz_n);
+    BigNumLength size = bigz_getlength(argv, 0);
+    return bigz_wrap(BzCreate(size));
 }
 
-JANET_FN(cfun_BzNumDigits,
+BIGZ_FN(cfun_BzNumDigits,
     "(bigz/num-digits)",
     "Returns the number of 'digits' used by a bigz number.")
 {
     janet_fixarity(argc, 1);
     BigNumLength digits = BzNumDigits(*(BigZ*)janet_getabstract(argv, 0, &janet_bigz_type));
-    return janet_wrap_integer(digits);
+    return janet_wrap_number((double)digits);
 }
 
-JANET_FN(cfun_BzLength,
+BIGZ_FN(cfun_BzLength,
     "(bigz/length)",
     "Returns the number of bits used by a bigz number.")
 {
     janet_fixarity(argc, 1);
     BigNumLength digits = BzLength(*(BigZ*)janet_getabstract(argv, 0, &janet_bigz_type));
-    return janet_wrap_integer(digits);
+    return janet_wrap_number((double)digits);
 }
 
-JANET_FN(cfun_BzNegate,
+BIGZ_FN(cfun_BzNegate,
     "(bigz/negate n)",
     "Negates a bigz number.")
 {
@@ -93,7 +958,7 @@ JANET_FN(cfun_BzNegate,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzAbs,
+BIGZ_FN(cfun_BzAbs,
     "(bigz/abs n)",
     "Returns the absolute value of a bigz number.")
 {
@@ -104,7 +969,7 @@ JANET_FN(cfun_BzAbs,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzCompare,
+BIGZ_FN(cfun_BzCompare,
     "(bigz/compare a b)",
     "Compares two bigz numbers. Returns -1 if a is less than b, "
     "0 if a and b are equal, and 1 if a is greater than b.")
@@ -115,7 +980,7 @@ JANET_FN(cfun_BzCompare,
     return janet_wrap_integer(BzCompare(*bz_a, *bz_b));
 }
 
-JANET_FN(cfun_BzAdd,
+BIGZ_FN(cfun_BzAdd,
     "(bigz/add a b)",
     "Returns the sum of two bigz numbers.")
 {
@@ -127,7 +992,7 @@ JANET_FN(cfun_BzAdd,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzSubtract,
+BIGZ_FN(cfun_BzSubtract,
     "(bigz/subtract a b)",
     "Returns the difference between two bigz numbers.")
 {
@@ -139,7 +1004,7 @@ JANET_FN(cfun_BzSubtract,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzMultiply,
+BIGZ_FN(cfun_BzMultiply,
     "(bigz/multiply a b)",
     "Returns the product of two bigz numbers.")
 {
@@ -151,7 +1016,7 @@ JANET_FN(cfun_BzMultiply,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzDivide,
+BIGZ_FN(cfun_BzDivide,
     "(bigz/divide a b)",
     "Returns a tuple containing the quotient and the remainder "
     "when dividing a bigz number by another bigz number.")
@@ -168,7 +1033,7 @@ JANET_FN(cfun_BzDivide,
     return janet_wrap_tuple(janet_tuple_end(tuple));
 }
 
-JANET_FN(cfun_BzDiv,
+BIGZ_FN(cfun_BzDiv,
     "(bigz/div a b)",
     "Returns the quotient when dividing a bigz number by another bigz number.")
 {
@@ -180,7 +1045,7 @@ JANET_FN(cfun_BzDiv,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzTruncate,
+BIGZ_FN(cfun_BzTruncate,
     "(bigz/truncate a b)",
     "Performs a division, exact semantics is currently a bit unclear. "
     "Negative values yields slightly different results from `div`.")
@@ -193,7 +1058,7 @@ JANET_FN(cfun_BzTruncate,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzFloor,
+BIGZ_FN(cfun_BzFloor,
     "(bigz/floor a b)",
     "Performs a division of two bigz numbers, rounding down.")
 {
@@ -205,7 +1070,7 @@ JANET_FN(cfun_BzFloor,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzCeiling,
+BIGZ_FN(cfun_BzCeiling,
     "(bigz/ceiling a b)",
     "Performs a division of two bigz numbers, rounding up.")
 {
@@ -217,7 +1082,7 @@ JANET_FN(cfun_BzCeiling,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzRound,
+BIGZ_FN(cfun_BzRound,
     "(bigz/round a b)",
     "Performs a divison of two bigz numbers, rounding towards an even result.")
 {
@@ -229,7 +1094,7 @@ JANET_FN(cfun_BzRound,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzMod,
+BIGZ_FN(cfun_BzMod,
     "(bigz/mod a b)",
     "Returns the modulus of two bigz numbers.")
 {
@@ -241,7 +1106,7 @@ JANET_FN(cfun_BzMod,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzRem,
+BIGZ_FN(cfun_BzRem,
     "(bigz/rem a b)",
     "Returns the remainder of a divison of two bigz numbers.")
 {
@@ -253,7 +1118,7 @@ JANET_FN(cfun_BzRem,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzPow,
+BIGZ_FN(cfun_BzPow,
     "(bigz/pow a b)",
     "Returns the exponentiation of a bigz number by an integer.")
 {
@@ -265,7 +1130,7 @@ JANET_FN(cfun_BzPow,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzIsEven,
+BIGZ_FN(cfun_BzIsEven,
     "(bigz/is-even n)",
     "Returns true if the bigz number is even, otherwise false.")
 {
@@ -275,7 +1140,7 @@ JANET_FN(cfun_BzIsEven,
     return janet_wrap_boolean(result);
 }
 
-JANET_FN(cfun_BzIsOdd,
+BIGZ_FN(cfun_BzIsOdd,
     "(bigz/is-odd n)",
     "Returns true if the bigz number is odd, otherwise false.")
 {
@@ -285,7 +1150,7 @@ JANET_FN(cfun_BzIsOdd,
     return janet_wrap_boolean(result);
 }
 
-JANET_FN(cfun_BzToString,
+BIGZ_FN(cfun_BzToString,
     "(bigz/to-string n base sign)",
     "Converts a bigz number to a string. The specified base will be used, "
     "and if sign is true, an explicit plus will be included at the start "
@@ -301,7 +1166,7 @@ JANET_FN(cfun_BzToString,
     return result;
 }
 
-JANET_FN(cfun_BzFromString,
+BIGZ_FN(cfun_BzFromString,
     "(bigz/from-string s base)",
     "Converts a string in a given base to a bigz number.")
 {
@@ -311,7 +1176,7 @@ JANET_FN(cfun_BzFromString,
     return janet_wrap_abstract(bz_n);
 }
 
-JANET_FN(cfun_BzFromInteger,
+BIGZ_FN(cfun_BzFromInteger,
     "(bigz/from-integer n)",
     "Converts an integer into a bigz number.")
 {
@@ -321,7 +1186,7 @@ JANET_FN(cfun_BzFromInteger,
     return janet_wrap_abstract(bz_n);
 }
 
-JANET_FN(cfun_BzToInteger,
+BIGZ_FN(cfun_BzToInteger,
     "(bigz/to-integer n)",
     "Converts a bigz number into an integer.")
 {
@@ -330,83 +1195,277 @@ JANET_FN(cfun_BzToInteger,
     return janet_wrap_integer(BzToInteger(*bz_n));
 }
 
-JANET_FN(cfun_BzToDouble,
+BIGZ_FN(cfun_BzToDouble,
     "(bigz/to-double n)",
     "Converts a bigz number into a double.")
 {
     janet_fixarity(argc, 1);
     BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
-    return janet_wrap_number(BzToInteger(*bz_n));
+    return janet_wrap_number(BzToDouble(*bz_n));
 }
 
-JANET_FN(cfun_BzTestBit,
+BIGZ_FN(cfun_BzTestBit,
     "(bigz/test-bit bit n)",
     "Returns true if the specified bit is set in the bigz number.")
 {
     janet_fixarity(argc, 2);
-    BigNumLength bit = janet_getuinteger(argv, 0);
-    BigZ *bz_n = janet_getabstract(argv, 1, &janet_bigz_type);
-    return janet_wrap_integer(BzTestBit(bit, *bz_n));
+    BigNumLength bit = bigz_getlength(argv, 0);
+    BigZ n = bigz_getbits(argv, 1);
+    return janet_wrap_integer(BzTestBit(bit, n));
 }
 
-JANET_FN(cfun_BzBitCount,
+BIGZ_FN(cfun_BzBitCount,
     "(bigz/bit-count n)",
     "Returns the number of bits that are set to 1 in the bigz number.")
 {
     janet_fixarity(argc, 1);
     BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
     BigNumLength count = BzBitCount(*bz_n);
-    return janet_wrap_integer(count);
+    return janet_wrap_number((double)count);
 }
 
-JANET_FN(cfun_BzNot,
-    "(bigz/not n)",
-    "Returns the bitwise not value of a bigz number.")
+static Janet bigz_wrap_bit(BigNumLength bit)
+{
+    return (bit == BZ_NO_BIT) ? janet_wrap_nil() : janet_wrap_number((double)bit);
+}
+
+BIGZ_FN(cfun_BzScan0,
+    "(bigz/scan0 n &opt start)",
+    "Returns the index of the first bit that is 0 at or above start "
+    "(default 0) in the two's complement representation of the bigz "
+    "number, or nil if there is none (n negative).")
+{
+    janet_arity(argc, 1, 2);
+    BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigNumLength start = bigz_optlength(argv, argc, 1, 0);
+    return bigz_wrap_bit(BzScan0(*bz_n, start));
+}
+
+BIGZ_FN(cfun_BzScan1,
+    "(bigz/scan1 n &opt start)",
+    "Returns the index of the first bit that is 1 at or above start "
+    "(default 0) in the two's complement representation of the bigz "
+    "number, or nil if there is none (n non-negative).")
+{
+    janet_arity(argc, 1, 2);
+    BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigNumLength start = bigz_optlength(argv, argc, 1, 0);
+    return bigz_wrap_bit(BzScan1(*bz_n, start));
+}
+
+BIGZ_FN(cfun_BzLowestSetBit,
+    "(bigz/lowest-set-bit n)",
+    "Returns the index of the lowest bit set in the bigz number, the "
+    "exponent of the largest power of two dividing it, or nil for zero.")
 {
     janet_fixarity(argc, 1);
     BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
-    BigZ *result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
-    *result = BzNot(*bz_n);
-    return janet_wrap_abstract(result);
+    return bigz_wrap_bit(BzLowestSetBit(*bz_n));
 }
 
-JANET_FN(cfun_BzAnd,
-    "(bigz/and a b)",
-    "Returns the bitwise and result of two bigz numbers.")
+BIGZ_FN(cfun_BzSetBit,
+    "(bigz/set-bit n bit)",
+    "Returns n with the specified bit set to 1, in two's complement "
+    "representation.")
 {
     janet_fixarity(argc, 2);
-    BigZ *bz_a = janet_getabstract(argv, 0, &janet_bigz_type);
-    BigZ *bz_b = janet_getabstract(argv, 1, &janet_bigz_type);
-    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
-    *bz_result = BzAnd(*bz_a, *bz_b);
-    return janet_wrap_abstract(bz_result);
+    BigZ n = bigz_getbits(argv, 0);
+    BigNumLength bit = bigz_getlength(argv, 1);
+    return bigz_wrap(BzSetBit(n, bit));
 }
 
-JANET_FN(cfun_BzOr,
-    "(bigz/or a b)",
-    "Returns the bitwise or result of two bigz numbers.")
+BIGZ_FN(cfun_BzClearBit,
+    "(bigz/clear-bit n bit)",
+    "Returns n with the specified bit set to 0, in two's complement "
+    "representation.")
 {
     janet_fixarity(argc, 2);
-    BigZ *bz_a = janet_getabstract(argv, 0, &janet_bigz_type);
-    BigZ *bz_b = janet_getabstract(argv, 1, &janet_bigz_type);
-    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
-    *bz_result = BzOr(*bz_a, *bz_b);
-    return janet_wrap_abstract(bz_result);
+    BigZ n = bigz_getbits(argv, 0);
+    BigNumLength bit = bigz_getlength(argv, 1);
+    return bigz_wrap(BzClearBit(n, bit));
 }
 
-JANET_FN(cfun_BzXor,
-    "(bigz/xor a b)",
-    "Returns the bitwize xor result of two bigz numbers.")
+BIGZ_FN(cfun_BzFlipBit,
+    "(bigz/flip-bit n bit)",
+    "Returns n with the specified bit complemented, in two's complement "
+    "representation.")
 {
     janet_fixarity(argc, 2);
-    BigZ *bz_a = janet_getabstract(argv, 0, &janet_bigz_type);
-    BigZ *bz_b = janet_getabstract(argv, 1, &janet_bigz_type);
-    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
-    *bz_result = BzXor(*bz_a, *bz_b);
+    BigZ n = bigz_getbits(argv, 0);
+    BigNumLength bit = bigz_getlength(argv, 1);
+    return bigz_wrap(BzFlipBit(n, bit));
+}
+
+BIGZ_FN(cfun_BzExtractBits,
+    "(bigz/extract-bits n start len)",
+    "Returns the non-negative bigz made of the len bits of n starting at "
+    "bit start, in two's complement representation. Only the digits of n "
+    "holding those bits are read.")
+{
+    janet_fixarity(argc, 3);
+    BigZ n = bigz_getbits(argv, 0);
+    BigNumLength start = bigz_getlength(argv, 1);
+    BigNumLength len = bigz_getlength(argv, 2);
+    return bigz_wrap(BzExtractBits(n, start, len));
+}
+
+BIGZ_FN(cfun_BzDepositBits,
+    "(bigz/deposit-bits n start len value)",
+    "Returns n with the len bits starting at bit start replaced by the "
+    "low len bits of value, in two's complement representation.")
+{
+    janet_fixarity(argc, 4);
+    BigZ n = bigz_getbits(argv, 0);
+    BigNumLength start = bigz_getlength(argv, 1);
+    BigNumLength len = bigz_getlength(argv, 2);
+    BigZ value = bigz_getbits(argv, 3);
+    return bigz_wrap(BzDepositBits(n, start, len, value));
+}
+
+BIGZ_FN(cfun_BzMutable,
+    "(bigz/mutable &opt n)",
+    "Creates a mutable bigz, initialized to the bigz n or zero, for the "
+    "set-bit!, clear-bit!, flip-bit!, deposit-bits! and ash! functions "
+    "which change it in place without copying it. It "
+    "can be read by test-bit, extract-bits and mutable-value.")
+{
+    janet_arity(argc, 0, 1);
+    BigZ z;
+    if (argc > 0 && !janet_checktype(argv[0], JANET_NIL)) {
+        z = BzCopy(bigz_getbits(argv, 0));
+    } else {
+        z = BzCreate(1);
+    }
+    if (z == BZNULL) {
+        janet_panic("out of memory");
+    }
+    BigZ *bz_m = janet_abstract(&janet_bigz_mutable_type, sizeof(BigZ *));
+    *bz_m = z;
+    return janet_wrap_abstract(bz_m);
+}
+
+BIGZ_FN(cfun_BzMutableValue,
+    "(bigz/mutable-value m)",
+    "Returns the current value of the mutable bigz m as a bigz.")
+{
+    janet_fixarity(argc, 1);
+    BigZ *bz_m = janet_getabstract(argv, 0, &janet_bigz_mutable_type);
+    return bigz_wrap_copy(*bz_m);
+}
+
+static Janet bigz_mutable_update(const Janet *argv, BigZ *bz_m, BigZ z)
+{
+    if (z == BZNULL) {
+        janet_panic("out of memory");
+    }
+    *bz_m = z;
+    return argv[0];
+}
+
+BIGZ_FN(cfun_BzSetBitInPlace,
+    "(bigz/set-bit! m bit)",
+    "Sets the specified bit of the mutable bigz m to 1, and returns m.")
+{
+    janet_fixarity(argc, 2);
+    BigZ *bz_m = janet_getabstract(argv, 0, &janet_bigz_mutable_type);
+    BigNumLength bit = bigz_getlength(argv, 1);
+    return bigz_mutable_update(argv, bz_m, BzSetBitInPlace(*bz_m, bit));
+}
+
+BIGZ_FN(cfun_BzClearBitInPlace,
+    "(bigz/clear-bit! m bit)",
+    "Sets the specified bit of the mutable bigz m to 0, and returns m.")
+{
+    janet_fixarity(argc, 2);
+    BigZ *bz_m = janet_getabstract(argv, 0, &janet_bigz_mutable_type);
+    BigNumLength bit = bigz_getlength(argv, 1);
+    return bigz_mutable_update(argv, bz_m, BzClearBitInPlace(*bz_m, bit));
+}
+
+BIGZ_FN(cfun_BzFlipBitInPlace,
+    "(bigz/flip-bit! m bit)",
+    "Complements the specified bit of the mutable bigz m, and returns m.")
+{
+    janet_fixarity(argc, 2);
+    BigZ *bz_m = janet_getabstract(argv, 0, &janet_bigz_mutable_type);
+    BigNumLength bit = bigz_getlength(argv, 1);
+    return bigz_mutable_update(argv, bz_m, BzFlipBitInPlace(*bz_m, bit));
+}
+
+BIGZ_FN(cfun_BzDepositBitsInPlace,
+    "(bigz/deposit-bits! m start len value)",
+    "Replaces the len bits of the mutable bigz m starting at bit start by "
+    "the low len bits of value, and returns m.")
+{
+    janet_fixarity(argc, 4);
+    BigZ *bz_m = janet_getabstract(argv, 0, &janet_bigz_mutable_type);
+    BigNumLength start = bigz_getlength(argv, 1);
+    BigNumLength len = bigz_getlength(argv, 2);
+    BigZ value = bigz_getbits(argv, 3);
+    return bigz_mutable_update(argv, bz_m,
+                               BzDepositBitsInPlace(*bz_m, start, len, value));
+}
+
+BIGZ_FN(cfun_BzAshInPlace,
+    "(bigz/ash! m n)",
+    "Shifts the mutable bigz m arithmetically by n bits, left when n is "
+    "positive and right, rounding towards negative infinity, when n is "
+    "negative, and returns m. It only allocates when m grows.")
+{
+    janet_fixarity(argc, 2);
+    BigZ *bz_m = janet_getabstract(argv, 0, &janet_bigz_mutable_type);
+    int n = janet_getinteger(argv, 1);
+    return bigz_mutable_update(argv, bz_m, BzAshInPlace(*bz_m, n));
+}
+
+BIGZ_FN(cfun_BzNot,
+    "(bigz/not n)",
+    "Returns the bitwise not value of a bigz number.")
+{
+    janet_fixarity(argc, 1);
+    BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigZ *result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *result = BzNot(*bz_n);
+    return janet_wrap_abstract(result);
+}
+
+BIGZ_FN(cfun_BzAnd,
+    "(bigz/and a b)",
+    "Returns the bitwise and result of two bigz numbers.")
+{
+    janet_fixarity(argc, 2);
+    BigZ *bz_a = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigZ *bz_b = janet_getabstract(argv, 1, &janet_bigz_type);
+    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = BzAnd(*bz_a, *bz_b);
+    return janet_wrap_abstract(bz_result);
+}
+
+BIGZ_FN(cfun_BzOr,
+    "(bigz/or a b)",
+    "Returns the bitwise or result of two bigz numbers.")
+{
+    janet_fixarity(argc, 2);
+    BigZ *bz_a = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigZ *bz_b = janet_getabstract(argv, 1, &janet_bigz_type);
+    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = BzOr(*bz_a, *bz_b);
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzNand,
+BIGZ_FN(cfun_BzXor,
+    "(bigz/xor a b)",
+    "Returns the bitwize xor result of two bigz numbers.")
+{
+    janet_fixarity(argc, 2);
+    BigZ *bz_a = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigZ *bz_b = janet_getabstract(argv, 1, &janet_bigz_type);
+    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = BzXor(*bz_a, *bz_b);
+    return janet_wrap_abstract(bz_result);
+}
+
+BIGZ_FN(cfun_BzNand,
     "(bigz/nand a b)",
     "Returns the bitwise nand result of two bigz numbers.")
 {
@@ -418,7 +1477,7 @@ JANET_FN(cfun_BzNand,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzNor,
+BIGZ_FN(cfun_BzNor,
     "(bigz/nor a b)",
     "Returns the bitwise nor result of two bigz numbers.")
 {
@@ -430,7 +1489,7 @@ JANET_FN(cfun_BzNor,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzEqv,
+BIGZ_FN(cfun_BzEqv,
     "(bigz/eqv a b)",
     "Returns the bitwise not of the xor result of two bigz numbers (~(a^b)).")
 {
@@ -442,7 +1501,7 @@ JANET_FN(cfun_BzEqv,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzAndC1,
+BIGZ_FN(cfun_BzAndC1,
     "(bigz/and-c1 a b)",
     "Returns the bitwise and result of a bitwise not of the first argument, "
     "and the second argument (~a ^ b)")
@@ -455,7 +1514,7 @@ JANET_FN(cfun_BzAndC1,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzAndC2,
+BIGZ_FN(cfun_BzAndC2,
     "(bigz/and-c2 a b)",
     "Returns the bitwise and result of the first argument with the bitwise "
     "not of the second argument.")
@@ -468,7 +1527,7 @@ JANET_FN(cfun_BzAndC2,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzOrC1,
+BIGZ_FN(cfun_BzOrC1,
     "(bigz/or-c1 a b)",
     "Returns the bitwise or result of a bitwise not of the first argument, "
     "and the second argument (~a ^ b)")
@@ -481,7 +1540,7 @@ JANET_FN(cfun_BzOrC1,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzOrC2,
+BIGZ_FN(cfun_BzOrC2,
     "(bigz/or-c2 a b)",
     "Returns the bitwise or result of the first argument with the bitwise "
     "not of the second argument.")
@@ -494,7 +1553,23 @@ JANET_FN(cfun_BzOrC2,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzAsh,
+BIGZ_FN(cfun_BzBoole,
+    "(bigz/boole op a b)",
+    "Returns one of the 16 bitwise operations of a and b, as in Common "
+    "Lisp boole. op is one of :clr, :set, :1, :2, :c1, :c2, :and, :ior, "
+    ":xor, :eqv, :nand, :nor, :andc1, :andc2, :orc1 and :orc2, or the "
+    "integer whose bit 2i+j is the result for bits i of a and j of b.")
+{
+    janet_fixarity(argc, 3);
+    BzBooleOp op = bigz_getboole(argv, 0);
+    BigZ *bz_a = janet_getabstract(argv, 1, &janet_bigz_type);
+    BigZ *bz_b = janet_getabstract(argv, 2, &janet_bigz_type);
+    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = BzBoole(op, *bz_a, *bz_b);
+    return janet_wrap_abstract(bz_result);
+}
+
+BIGZ_FN(cfun_BzAsh,
     "(bigz/ash a b)",
     "Returns the value of performing an arithmetic shift of a bigz number "
     "with an integer. A positive shift will multiply by powers of two, "
@@ -508,7 +1583,7 @@ JANET_FN(cfun_BzAsh,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzSqrt,
+BIGZ_FN(cfun_BzSqrt,
     "(bigz/sqrt n)",
     "Returns a bigz number that is the integral value of the square root "
     "of the argument.")
@@ -520,7 +1595,7 @@ JANET_FN(cfun_BzSqrt,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzLcm,
+BIGZ_FN(cfun_BzLcm,
     "(bigz/lcm a b)",
     "Returns the least common multiple of two bigz numbers.")
 {
@@ -532,7 +1607,7 @@ JANET_FN(cfun_BzLcm,
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzGcd,
+BIGZ_FN(cfun_BzGcd,
     "(bigz/gcd a b)",
     "Returns the greatest common divisor of two bigz numbers.")
 {
@@ -544,38 +1619,180 @@ JANET_FN(cfun_BzGcd,
     return janet_wrap_abstract(bz_result);
 }
 
-static unsigned int random_seed = 0;
+/* Each thread has its own default generator. Unless set-random-seed is
+ * called first, the nth thread to use one is seeded with n, so that
+ * threads don't draw the same numbers; the first one, usually the main
+ * thread, gets 0 as before generators were per thread. */
+static unsigned int random_threads = 0;
+static JANET_THREAD_LOCAL unsigned int random_seed = 0;
+static JANET_THREAD_LOCAL int random_seeded = 0;
+static JANET_THREAD_LOCAL BzRandomState random_state;
+
+static unsigned int bigz_random_next_thread(void)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_fetch_add(&random_threads, 1, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+    return (unsigned int)_InterlockedIncrement((long volatile *)&random_threads) - 1;
+#else
+    return random_threads++;
+#endif
+}
+
+/* The state behind set-random-seed for the calling thread. */
+static BzRandomState *bigz_random_state(void)
+{
+    if (!random_seeded) {
+        random_seed = bigz_random_next_thread();
+        BzRandomSeed(&random_state, (BzUInt64)random_seed);
+        random_seeded = 1;
+    }
+    return &random_state;
+}
+
+/* The rng argument at index n, or the state behind set-random-seed. */
+static BzRandomState *rng_optstate(const Janet *argv, int32_t argc, int32_t n)
+{
+    if (argc <= n || janet_checktype(argv[n], JANET_NIL)) {
+        return bigz_random_state();
+    }
+    return janet_getabstract(argv, n, &janet_rng_type);
+}
 
-JANET_FN(cfun_set_random_seed,
+BIGZ_FN(cfun_set_random_seed,
     "(bigz/set-random-seed n)",
-    "Set the random seed.")
+    "Set the random seed of the current thread, restarting its sequence "
+    "of random numbers. Other threads keep their own sequences. A thread "
+    "that doesn't set a seed gets one of its own, 0 for the first thread "
+    "to draw a number.")
 {
     janet_fixarity(argc, 1);
     random_seed = janet_getuinteger(argv, 0);
+    BzRandomSeed(&random_state, (BzUInt64)random_seed);
+    random_seeded = 1;
     return janet_wrap_nil();
 }
 
-JANET_FN(cfun_get_random_seed,
+BIGZ_FN(cfun_get_random_seed,
     "(bigz/get-random-seed)",
-    "Get the random seed.")
+    "Get the random seed of the current thread, the one last set with "
+    "bigz/set-random-seed or else the one it was given.")
 {
     janet_fixarity(argc, 0);
+    bigz_random_state();
     return janet_wrap_number(random_seed);
 }
 
-JANET_FN(cfun_BzRandom,
-    "(bigz/random n)",
+BIGZ_FN(cfun_BzRandom,
+    "(bigz/random n &opt rng)",
     "Generate a random number between zero and up, to but not including, "
-    "the bigz number n.")
+    "the bigz number n, which must be positive. Every such number is "
+    "equally likely. Numbers are drawn from rng if given, otherwise from "
+    "the generator seeded by bigz/set-random-seed.")
+{
+    janet_arity(argc, 1, 2);
+    BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
+    BzRandomState *state = rng_optstate(argv, argc, 1);
+    if (BzGetSign(*bz_n) != BZ_PLUS) {
+        janet_panic("n must be positive");
+    }
+    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = BzRandomBelow(*bz_n, state);
+    return janet_wrap_abstract(bz_result);
+}
+
+BIGZ_FN(cfun_BzRandomBits,
+    "(bigz/random-bits n &opt rng)",
+    "Generate a random non-negative bigz number of at most n bits, every "
+    "number below 2^n being equally likely. See bigz/random for rng.")
+{
+    janet_arity(argc, 1, 2);
+    BigNumLength bits = bigz_getlength(argv, 0);
+    BzRandomState *state = rng_optstate(argv, argc, 1);
+    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = BzRandomBits(bits, state);
+    return janet_wrap_abstract(bz_result);
+}
+
+/* Per thread, so that two threads never share, and possibly hand out,
+ * the same generated bytes. */
+static JANET_THREAD_LOCAL BzSecureRandomState secure_state;
+
+BIGZ_FN(cfun_BzRandomSecure,
+    "(bigz/random-secure n)",
+    "Generate a cryptographically secure random number between zero and "
+    "up, to but not including, the bigz number n, which must be positive. "
+    "Numbers come from ChaCha20 keyed with operating system entropy, which "
+    "is read in batches rather than once per number.")
 {
     janet_fixarity(argc, 1);
     BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigZ r;
+    if (BzGetSign(*bz_n) != BZ_PLUS) {
+        janet_panic("n must be positive");
+    }
+    r = BzSecureRandomBelow(*bz_n, &secure_state);
+    if (r == BZNULL) {
+        janet_panic(secure_state.Error ? "cannot read system entropy" : "out of memory");
+    }
     BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
-    *bz_result = BzRandom(*bz_n, &random_seed);
+    *bz_result = r;
     return janet_wrap_abstract(bz_result);
 }
 
-JANET_FN(cfun_BzModExp,
+BIGZ_FN(cfun_BzRng,
+    "(bigz/rng &opt seed)",
+    "Creates a random number generator, for use with bigz/random and "
+    "bigz/random-bits, with its own 256-bit xoshiro256** state. The state "
+    "is initialized from the 64-bit integer seed if given, otherwise from "
+    "the generator seeded by bigz/set-random-seed. Each fiber or thread "
+    "should use its own generator.")
+{
+    janet_arity(argc, 0, 1);
+    BzRandomState *state = janet_abstract(&janet_rng_type, sizeof(BzRandomState));
+    if (argc > 0 && !janet_checktype(argv[0], JANET_NIL)) {
+        BzRandomSeed(state, (BzUInt64)janet_getuinteger64(argv, 0));
+    } else {
+        BzRandomSeed(state, BzRandomNext(bigz_random_state()));
+    }
+    return janet_wrap_abstract(state);
+}
+
+BIGZ_FN(cfun_BzRngSeed,
+    "(bigz/rng/seed rng seed)",
+    "Reinitializes a random number generator from the 64-bit integer seed. "
+    "Returns rng.")
+{
+    janet_fixarity(argc, 2);
+    BzRandomState *state = janet_getabstract(argv, 0, &janet_rng_type);
+    BzRandomSeed(state, (BzUInt64)janet_getuinteger64(argv, 1));
+    return argv[0];
+}
+
+BIGZ_FN(cfun_BzRngJump,
+    "(bigz/rng/jump rng)",
+    "Advances a random number generator by 2^128 draws. Returns rng.")
+{
+    janet_fixarity(argc, 1);
+    BzRandomState *state = janet_getabstract(argv, 0, &janet_rng_type);
+    BzRandomJump(state);
+    return argv[0];
+}
+
+BIGZ_FN(cfun_BzRngSplit,
+    "(bigz/rng/split rng)",
+    "Returns a new random number generator continuing the sequence of rng, "
+    "and jumps rng ahead by 2^128 draws so that the two sequences do not "
+    "overlap. Splitting once per worker gives independent streams.")
+{
+    janet_fixarity(argc, 1);
+    BzRandomState *parent = janet_getabstract(argv, 0, &janet_rng_type);
+    BzRandomState *child = janet_abstract(&janet_rng_type, sizeof(BzRandomState));
+    BzRandomSplit(parent, child);
+    return janet_wrap_abstract(child);
+}
+
+BIGZ_FN(cfun_BzModExp,
     "(bigz/mod-exp base exponent modulus)",
     "Returns the modular exponentiation of a bigz number by another bigz number "
     "(the modulus is also a bigz number).")
@@ -589,6 +1806,1228 @@ JANET_FN(cfun_BzModExp,
     return janet_wrap_abstract(bz_result);
 }
 
+BIGZ_FN(cfun_BzSetThreads,
+    "(bigz/set-threads n)",
+    "Sets the number of threads multiplications of large numbers, and "
+    "conversions of large numbers to strings and of long strings to "
+    "numbers, are spread over, the calling thread included. 1, the "
+    "default, keeps them on the calling thread, 0 uses one thread per "
+    "processor. Returns the number of threads, which may be lower than "
+    "asked if threads can't be created. Results don't depend on the number "
+    "of threads.")
+{
+    janet_fixarity(argc, 1);
+    unsigned int n = (unsigned int)janet_getnat(argv, 0);
+    return janet_wrap_number(BnnSetThreads(n));
+}
+
+BIGZ_FN(cfun_BzGetThreads,
+    "(bigz/get-threads)",
+    "Returns the number of threads set by bigz/set-threads.")
+{
+    janet_fixarity(argc, 0);
+    return janet_wrap_number(BnnGetThreads());
+}
+
+JANET_FN(cfun_set_stats,
+    "(bigz/set-stats on)",
+    "Turns the counters of bigz/stats on or off. Returns whether they are "
+    "on, always false when the module was built without BIGZ_STATS.")
+{
+    janet_fixarity(argc, 1);
+    int on = janet_truthy(argv[0]);
+#ifdef BIGZ_STATS
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&bigz_stats_enabled, on, __ATOMIC_RELAXED);
+#else
+    *(volatile int *)&bigz_stats_enabled = on;
+#endif
+    return janet_wrap_boolean(on);
+#else
+    (void)on;
+    return janet_wrap_false();
+#endif
+}
+
+#ifdef BIGZ_STATS
+static Janet bigz_stats_buckets(const uint64_t *buckets)
+{
+    int n = BIGZ_STATS_BUCKETS;
+    int k;
+    JanetArray *array;
+    while (n > 0 && BIGZ_STATS_LOAD(&buckets[n - 1]) == 0) {
+        n--;
+    }
+    array = janet_array(n);
+    for (k = 0; k < n; k++) {
+        janet_array_push(array, janet_wrap_number((double)BIGZ_STATS_LOAD(&buckets[k])));
+    }
+    return janet_wrap_array(array);
+}
+#endif
+
+JANET_FN(cfun_stats,
+    "(bigz/stats)",
+    "Returns a table of the functions called since the counters were "
+    "turned on with bigz/set-stats or reset with bigz/stats-reset. Keys "
+    "are function names such as \"bigz/multiply\", values are structs "
+    "with :calls, the number of calls, :nanoseconds, the time spent in "
+    "them, and the arrays :time and :digits. Element k > 0 of :time counts "
+    "the calls that took from 2^(k-1) to 2^k - 1 nanoseconds, and element "
+    "k of :digits the calls whose largest number had that many digits; "
+    "element 0 counts zeros. Calls that raise an error or suspend the fiber are "
+    "counted but not timed. Returns nil when the module was built without "
+    "BIGZ_STATS.")
+{
+    janet_fixarity(argc, 0);
+#ifdef BIGZ_STATS
+    JanetTable *table = janet_table(0);
+    BigzStat *stat;
+    for (stat = bigz_stats_first(); stat != NULL; stat = stat->next) {
+        uint64_t calls = BIGZ_STATS_LOAD(&stat->calls);
+        const char *name = stat->usage + 1;
+        int32_t len = 0;
+        JanetKV *st;
+        if (calls == 0) {
+            continue;
+        }
+        while (name[len] != ' ' && name[len] != ')' && name[len] != '\0') {
+            len++;
+        }
+        st = janet_struct_begin(4);
+        janet_struct_put(st, janet_ckeywordv("calls"), janet_wrap_number((double)calls));
+        janet_struct_put(st, janet_ckeywordv("nanoseconds"),
+                         janet_wrap_number((double)BIGZ_STATS_LOAD(&stat->nanoseconds)));
+        janet_struct_put(st, janet_ckeywordv("time"), bigz_stats_buckets(stat->time));
+        janet_struct_put(st, janet_ckeywordv("digits"), bigz_stats_buckets(stat->digits));
+        janet_table_put(table, janet_stringv((const uint8_t *)name, len),
+                        janet_wrap_struct(janet_struct_end(st)));
+    }
+    return janet_wrap_table(table);
+#else
+    return janet_wrap_nil();
+#endif
+}
+
+JANET_FN(cfun_stats_reset,
+    "(bigz/stats-reset)",
+    "Sets the counters of bigz/stats to zero.")
+{
+    janet_fixarity(argc, 0);
+#ifdef BIGZ_STATS
+    BigzStat *stat;
+    int k;
+    for (stat = bigz_stats_first(); stat != NULL; stat = stat->next) {
+        BIGZ_STATS_STORE(&stat->calls, 0);
+        BIGZ_STATS_STORE(&stat->nanoseconds, 0);
+        for (k = 0; k < BIGZ_STATS_BUCKETS; k++) {
+            BIGZ_STATS_STORE(&stat->time[k], 0);
+            BIGZ_STATS_STORE(&stat->digits[k], 0);
+        }
+    }
+#endif
+    return janet_wrap_nil();
+}
+
+#ifdef JANET_EV
+
+/* The operations of bigz/async. */
+typedef enum {
+    BIGZ_ASYNC_MULTIPLY,
+    BIGZ_ASYNC_TRUNCATE,
+    BIGZ_ASYNC_FLOOR,
+    BIGZ_ASYNC_ROUND,
+    BIGZ_ASYNC_MOD,
+    BIGZ_ASYNC_GCD,
+    BIGZ_ASYNC_POW,
+    BIGZ_ASYNC_MOD_EXP,
+    BIGZ_ASYNC_SQRT,
+    BIGZ_ASYNC_TO_STRING,
+    BIGZ_ASYNC_FROM_STRING
+} BigzAsyncOp;
+
+/*
+ * An operation handed to a worker thread. The Janet values holding the
+ * operands are rooted until the result is delivered, so the collector
+ * can't free the numbers the worker reads.
+ */
+typedef struct {
+    BigzAsyncOp op;
+    int32_t nargs;
+    Janet args[3];
+    BigZ z[3];
+    BzUInt exponent;
+    BigNumDigit base;
+    int sign;
+    const uint8_t *string;
+    BigZ result;
+    BzChar *result_string;
+    const char *error;
+} BigzAsyncTask;
+
+/* Runs on the worker thread, must not touch the Janet VM. */
+static JanetEVGenericMessage bigz_async_run(JanetEVGenericMessage msg)
+{
+    BigzAsyncTask *task = (BigzAsyncTask *)msg.argp;
+    switch (task->op) {
+    case BIGZ_ASYNC_MULTIPLY:
+        task->result = BzMultiply(task->z[0], task->z[1]);
+        break;
+    case BIGZ_ASYNC_TRUNCATE:
+        task->result = BzTruncate(task->z[0], task->z[1]);
+        break;
+    case BIGZ_ASYNC_FLOOR:
+        task->result = BzFloor(task->z[0], task->z[1]);
+        break;
+    case BIGZ_ASYNC_ROUND:
+        task->result = BzRound(task->z[0], task->z[1]);
+        break;
+    case BIGZ_ASYNC_MOD:
+        task->result = BzMod(task->z[0], task->z[1]);
+        break;
+    case BIGZ_ASYNC_GCD:
+        task->result = BzGcd(task->z[0], task->z[1]);
+        break;
+    case BIGZ_ASYNC_POW:
+        task->result = BzPow(task->z[0], task->exponent);
+        break;
+    case BIGZ_ASYNC_MOD_EXP:
+        task->result = BzModExp(task->z[0], task->z[1], task->z[2]);
+        break;
+    case BIGZ_ASYNC_SQRT:
+        task->result = BzSqrt(task->z[0]);
+        break;
+    case BIGZ_ASYNC_TO_STRING:
+        task->result_string = BzToString(task->z[0], task->base, task->sign);
+        if (task->result_string == NULL) {
+            task->error = "out of memory";
+        }
+        return msg;
+    case BIGZ_ASYNC_FROM_STRING:
+        task->result = BzFromString((const BzChar *)task->string, task->base,
+                                    BZ_UNTIL_END);
+        if (task->result == BZNULL) {
+            task->error = "invalid number";
+        }
+        return msg;
+    }
+    if (task->result == BZNULL) {
+        task->error = "out of memory";
+    }
+    return msg;
+}
+
+/* Runs on the event loop thread once the worker is done. */
+static void bigz_async_done(JanetEVGenericMessage msg)
+{
+    BigzAsyncTask *task = (BigzAsyncTask *)msg.argp;
+    int32_t i;
+    for (i = 0; i < task->nargs; i++) {
+        janet_gcunroot(task->args[i]);
+    }
+    janet_gcunroot(janet_wrap_fiber(msg.fiber));
+    if (!janet_fiber_can_resume(msg.fiber)) {
+        if (task->result != BZNULL) {
+            BzFree(task->result);
+        }
+    } else if (task->error != NULL) {
+        if (task->result != BZNULL) {
+            BzFree(task->result);
+        }
+        janet_cancel(msg.fiber, janet_cstringv(task->error));
+    } else if (task->op == BIGZ_ASYNC_TO_STRING) {
+        janet_schedule(msg.fiber, janet_cstringv(task->result_string));
+    } else {
+        BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+        *bz_result = task->result;
+        janet_schedule(msg.fiber, janet_wrap_abstract(bz_result));
+    }
+    if (task->result_string != NULL) {
+        BzFreeString(task->result_string);
+    }
+    free(task);
+}
+
+static BigNumDigit bigz_getbase(const Janet *argv, int32_t n)
+{
+    int32_t base = janet_getinteger(argv, n);
+    if (base < 2 || base > 36) {
+        janet_panicf("base must be in [2, 36], got %v", argv[n]);
+    }
+    return (BigNumDigit)base;
+}
+
+BIGZ_FN(cfun_BzAsync,
+    "(bigz/async op & args)",
+    "Runs a bigz operation on another thread and suspends the current "
+    "fiber until its result is ready, so that long computations on large "
+    "numbers don't stall the event loop. op is :multiply, :truncate, "
+    ":floor, :round, :mod or :gcd with two bigz numbers, :pow with a bigz number "
+    "and an integer, :mod-exp with three bigz numbers, :sqrt with a bigz "
+    "number, :to-string with a bigz number, a base and a sign flag, or "
+    ":from-string with a string and a base. Returns what the function of "
+    "the same name returns. Operands can't be mutable numbers.")
+{
+    static const struct {
+        const char *name;
+        BigzAsyncOp op;
+        int32_t arity;
+    } ops[] = {
+        {"multiply", BIGZ_ASYNC_MULTIPLY, 2}, {"truncate", BIGZ_ASYNC_TRUNCATE, 2},
+        {"floor", BIGZ_ASYNC_FLOOR, 2}, {"round", BIGZ_ASYNC_ROUND, 2},
+        {"mod", BIGZ_ASYNC_MOD, 2},
+        {"gcd", BIGZ_ASYNC_GCD, 2}, {"pow", BIGZ_ASYNC_POW, 2},
+        {"mod-exp", BIGZ_ASYNC_MOD_EXP, 3}, {"sqrt", BIGZ_ASYNC_SQRT, 1},
+        {"to-string", BIGZ_ASYNC_TO_STRING, 3},
+        {"from-string", BIGZ_ASYNC_FROM_STRING, 2}
+    };
+    BigzAsyncTask task;
+    BigzAsyncTask *copy;
+    JanetEVGenericMessage msg;
+    size_t k;
+    int32_t i;
+    janet_arity(argc, 1, -1);
+    janet_getkeyword(argv, 0);
+    for (k = 0; k < sizeof(ops) / sizeof(ops[0]); k++) {
+        if (janet_keyeq(argv[0], ops[k].name)) {
+            break;
+        }
+    }
+    if (k == sizeof(ops) / sizeof(ops[0])) {
+        janet_panicf("unknown async op %v", argv[0]);
+    }
+    janet_fixarity(argc, 1 + ops[k].arity);
+    memset(&task, 0, sizeof(task));
+    task.op = ops[k].op;
+    task.nargs = ops[k].arity;
+    switch (task.op) {
+    case BIGZ_ASYNC_POW:
+        task.z[0] = *(BigZ *)janet_getabstract(argv, 1, &janet_bigz_type);
+        task.exponent = (BzUInt)janet_getnat(argv, 2);
+        break;
+    case BIGZ_ASYNC_TO_STRING:
+        task.z[0] = *(BigZ *)janet_getabstract(argv, 1, &janet_bigz_type);
+        task.base = bigz_getbase(argv, 2);
+        task.sign = janet_getboolean(argv, 3);
+        break;
+    case BIGZ_ASYNC_FROM_STRING:
+        task.string = janet_getstring(argv, 1);
+        task.base = bigz_getbase(argv, 2);
+        break;
+    default:
+        for (i = 0; i < task.nargs; i++) {
+            task.z[i] = *(BigZ *)janet_getabstract(argv, 1 + i, &janet_bigz_type);
+        }
+        break;
+    }
+    switch (task.op) {
+    case BIGZ_ASYNC_TRUNCATE:
+    case BIGZ_ASYNC_FLOOR:
+    case BIGZ_ASYNC_ROUND:
+    case BIGZ_ASYNC_MOD:
+        if (BzGetSign(task.z[1]) == BZ_ZERO) {
+            janet_panic("division by zero");
+        }
+        break;
+    case BIGZ_ASYNC_MOD_EXP:
+        if (BzGetSign(task.z[2]) == BZ_ZERO) {
+            janet_panic("modulus must not be zero");
+        }
+        if (BzGetSign(task.z[1]) == BZ_MINUS) {
+            janet_panic("exponent must not be negative");
+        }
+        break;
+    case BIGZ_ASYNC_SQRT:
+        if (BzGetSign(task.z[0]) == BZ_MINUS) {
+            janet_panic("n must not be negative");
+        }
+        break;
+    default:
+        break;
+    }
+    if ((copy = malloc(sizeof(task))) == NULL) {
+        janet_panic("out of memory");
+    }
+    *copy = task;
+    for (i = 0; i < copy->nargs; i++) {
+        copy->args[i] = argv[1 + i];
+        janet_gcroot(copy->args[i]);
+    }
+    memset(&msg, 0, sizeof(msg));
+    msg.argp = copy;
+    msg.fiber = janet_root_fiber();
+    janet_gcroot(janet_wrap_fiber(msg.fiber));
+    janet_ev_threaded_call(bigz_async_run, msg, bigz_async_done);
+    janet_await();
+}
+
+#endif
+
+BIGZ_FN(cfun_BqCreate,
+    "(bigz/bigq/create n d)",
+    "Creates a bigq rational number from a bigz numerator and a bigz "
+    "denominator. The result is always in lowest terms with a positive "
+    "denominator.")
+{
+    janet_fixarity(argc, 2);
+    BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigZ *bz_d = janet_getabstract(argv, 1, &janet_bigz_type);
+    BigQ q;
+    if (BzGetSign(*bz_d) == BZ_ZERO) {
+        janet_panic("division by zero");
+    }
+    if (BzGetSign(*bz_d) == BZ_MINUS) {
+        BigZ n = BzNegate(*bz_n);
+        BigZ d = BzNegate(*bz_d);
+        q = BqCreate(n, d);
+        BzFree(n);
+        BzFree(d);
+    } else {
+        q = BqCreate(*bz_n, *bz_d);
+    }
+    return bigq_wrap(q);
+}
+
+BIGZ_FN(cfun_BqFromBigZ,
+    "(bigz/bigq/from-bigz n)",
+    "Converts a bigz number into a bigq rational number.")
+{
+    janet_fixarity(argc, 1);
+    BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigZ one = BzFromInteger(1);
+    BigQ q = BqCreate(*bz_n, one);
+    BzFree(one);
+    return bigq_wrap(q);
+}
+
+BIGZ_FN(cfun_BqFromString,
+    "(bigz/bigq/from-string s base)",
+    "Converts a string of the form \"n\" or \"n/d\" in a given base to "
+    "a bigq rational number.")
+{
+    janet_fixarity(argc, 2);
+    BigQ q = BqFromString((const BzChar *)janet_getcstring(argv, 0), janet_getinteger(argv, 1));
+    if (q == BQNULL) {
+        janet_panic("invalid rational number");
+    }
+    return bigq_wrap(q);
+}
+
+BIGZ_FN(cfun_BqFromDouble,
+    "(bigz/bigq/from-double x &opt maxd)",
+    "Converts a double into a bigq rational number whose denominator does "
+    "not exceed maxd (default 1000000).")
+{
+    janet_arity(argc, 1, 2);
+    double x = janet_getnumber(argv, 0);
+    BzInt maxd = janet_optinteger(argv, argc, 1, 1000000);
+    if (maxd < 1) {
+        janet_panic("maxd must be positive");
+    }
+    BigQ q = BqFromDouble(x, maxd);
+    if (q == BQNULL) {
+        janet_panic("cannot convert number to bigq");
+    }
+    return bigq_wrap(q);
+}
+
+BIGZ_FN(cfun_BqToString,
+    "(bigz/bigq/to-string q &opt base sign)",
+    "Converts a bigq rational number to a string of the form \"n/d\", or "
+    "\"n\" when the denominator is one. The base defaults to 10, and if sign "
+    "is true, an explicit plus will be included for positive numbers.")
+{
+    janet_arity(argc, 1, 3);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigNumDigit base = (argc > 1 && !janet_checktype(argv[1], JANET_NIL))
+        ? bigz_getbase(argv, 1) : 10;
+    int sign = janet_optboolean(argv, argc, 2, 0);
+    BzChar *q_str = BqToStringBufferExt(*bq_q, base, sign, NULL, NULL, NULL);
+    if (q_str == NULL) {
+        janet_panic("out of memory");
+    }
+    Janet result = janet_cstringv(q_str);
+    BzFreeString(q_str);
+    return result;
+}
+
+BIGZ_FN(cfun_BqToDouble,
+    "(bigz/bigq/to-double q)",
+    "Converts a bigq rational number into a double.")
+{
+    janet_fixarity(argc, 1);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    return janet_wrap_number(BqToDouble(*bq_q));
+}
+
+BIGZ_FN(cfun_BqNumerator,
+    "(bigz/bigq/numerator q)",
+    "Returns the numerator of a bigq rational number as a bigz number.")
+{
+    janet_fixarity(argc, 1);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigZ n = BzCopy(BqGetNumerator(*bq_q));
+    if (n == BZNULL) {
+        janet_panic("out of memory");
+    }
+    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = n;
+    return janet_wrap_abstract(bz_result);
+}
+
+BIGZ_FN(cfun_BqDenominator,
+    "(bigz/bigq/denominator q)",
+    "Returns the denominator of a bigq rational number as a bigz number. "
+    "The denominator is always positive.")
+{
+    janet_fixarity(argc, 1);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigZ d = BzCopy(BqGetDenominator(*bq_q));
+    if (d == BZNULL) {
+        janet_panic("out of memory");
+    }
+    BigZ *bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = d;
+    return janet_wrap_abstract(bz_result);
+}
+
+BIGZ_FN(cfun_BqAdd,
+    "(bigz/bigq/add a b)",
+    "Returns the sum of two bigq rational numbers.")
+{
+    janet_fixarity(argc, 2);
+    BigQ *bq_a = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigQ *bq_b = janet_getabstract(argv, 1, &janet_bigq_type);
+    return bigq_wrap(BqAdd(*bq_a, *bq_b));
+}
+
+BIGZ_FN(cfun_BqSubtract,
+    "(bigz/bigq/subtract a b)",
+    "Returns the difference between two bigq rational numbers.")
+{
+    janet_fixarity(argc, 2);
+    BigQ *bq_a = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigQ *bq_b = janet_getabstract(argv, 1, &janet_bigq_type);
+    return bigq_wrap(BqSubtract(*bq_a, *bq_b));
+}
+
+BIGZ_FN(cfun_BqMultiply,
+    "(bigz/bigq/multiply a b)",
+    "Returns the product of two bigq rational numbers.")
+{
+    janet_fixarity(argc, 2);
+    BigQ *bq_a = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigQ *bq_b = janet_getabstract(argv, 1, &janet_bigq_type);
+    return bigq_wrap(BqMultiply(*bq_a, *bq_b));
+}
+
+BIGZ_FN(cfun_BqDiv,
+    "(bigz/bigq/div a b)",
+    "Returns the quotient of two bigq rational numbers.")
+{
+    janet_fixarity(argc, 2);
+    BigQ *bq_a = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigQ *bq_b = janet_getabstract(argv, 1, &janet_bigq_type);
+    if (BzGetSign(BqGetNumerator(*bq_b)) == BZ_ZERO) {
+        janet_panic("division by zero");
+    }
+    return bigq_wrap(BqDiv(*bq_a, *bq_b));
+}
+
+BIGZ_FN(cfun_BqNegate,
+    "(bigz/bigq/negate q)",
+    "Negates a bigq rational number.")
+{
+    janet_fixarity(argc, 1);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    return bigq_wrap(BqNegate(*bq_q));
+}
+
+BIGZ_FN(cfun_BqAbs,
+    "(bigz/bigq/abs q)",
+    "Returns the absolute value of a bigq rational number.")
+{
+    janet_fixarity(argc, 1);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    return bigq_wrap(BqAbs(*bq_q));
+}
+
+BIGZ_FN(cfun_BqInverse,
+    "(bigz/bigq/inverse q)",
+    "Returns the multiplicative inverse of a bigq rational number.")
+{
+    janet_fixarity(argc, 1);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    if (BzGetSign(BqGetNumerator(*bq_q)) == BZ_ZERO) {
+        janet_panic("division by zero");
+    }
+    return bigq_wrap(BqInverse(*bq_q));
+}
+
+BIGZ_FN(cfun_BqCompare,
+    "(bigz/bigq/compare a b)",
+    "Compares two bigq rational numbers. Returns -1 if a is less than b, "
+    "0 if a and b are equal, and 1 if a is greater than b.")
+{
+    janet_fixarity(argc, 2);
+    BigQ *bq_a = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigQ *bq_b = janet_getabstract(argv, 1, &janet_bigq_type);
+    return janet_wrap_integer(bigq_compare(bq_a, bq_b));
+}
+
+BIGZ_FN(cfun_BqAccCreate,
+    "(bigz/bigq/acc-create &opt init threshold)",
+    "Creates a rational accumulator, initialized to the bigq number init "
+    "or zero. The accumulator is updated in place by acc-add, acc-subtract "
+    "and acc-multiply, and only reduced to lowest terms when read with "
+    "acc-value, or when its denominator grows past threshold digits, which "
+    "makes long chains of operations much cheaper than with bigq/add.")
+{
+    janet_arity(argc, 0, 2);
+    BigQ init = BQNULL;
+    if (argc > 0 && !janet_checktype(argv[0], JANET_NIL)) {
+        init = *(BigQ *)janet_getabstract(argv, 0, &janet_bigq_type);
+    }
+    BigNumLength threshold = janet_optnat(argv, argc, 1, 0);
+    BigQAcc acc = BqAccCreate(init, threshold);
+    if (acc == BQACCNULL) {
+        janet_panic("out of memory");
+    }
+    BigQAcc *bq_acc = janet_abstract(&janet_bigq_acc_type, sizeof(BigQAcc));
+    *bq_acc = acc;
+    return janet_wrap_abstract(bq_acc);
+}
+
+BIGZ_FN(cfun_BqAccAdd,
+    "(bigz/bigq/acc-add acc q)",
+    "Adds the bigq number q to the accumulator. Returns the accumulator.")
+{
+    janet_fixarity(argc, 2);
+    BigQAcc *bq_acc = janet_getabstract(argv, 0, &janet_bigq_acc_type);
+    BigQ *bq_q = janet_getabstract(argv, 1, &janet_bigq_type);
+    if (BqAccAdd(*bq_acc, *bq_q) == BN_FALSE) {
+        janet_panic("out of memory");
+    }
+    return argv[0];
+}
+
+BIGZ_FN(cfun_BqAccSubtract,
+    "(bigz/bigq/acc-subtract acc q)",
+    "Subtracts the bigq number q from the accumulator. Returns the accumulator.")
+{
+    janet_fixarity(argc, 2);
+    BigQAcc *bq_acc = janet_getabstract(argv, 0, &janet_bigq_acc_type);
+    BigQ *bq_q = janet_getabstract(argv, 1, &janet_bigq_type);
+    if (BqAccSubtract(*bq_acc, *bq_q) == BN_FALSE) {
+        janet_panic("out of memory");
+    }
+    return argv[0];
+}
+
+BIGZ_FN(cfun_BqAccMultiply,
+    "(bigz/bigq/acc-multiply acc q)",
+    "Multiplies the accumulator by the bigq number q. Returns the accumulator.")
+{
+    janet_fixarity(argc, 2);
+    BigQAcc *bq_acc = janet_getabstract(argv, 0, &janet_bigq_acc_type);
+    BigQ *bq_q = janet_getabstract(argv, 1, &janet_bigq_type);
+    if (BqAccMultiply(*bq_acc, *bq_q) == BN_FALSE) {
+        janet_panic("out of memory");
+    }
+    return argv[0];
+}
+
+BIGZ_FN(cfun_BqAccValue,
+    "(bigz/bigq/acc-value acc)",
+    "Returns the value of the accumulator as a bigq number.")
+{
+    janet_fixarity(argc, 1);
+    BigQAcc *bq_acc = janet_getabstract(argv, 0, &janet_bigq_acc_type);
+    return bigq_wrap(BqAccValue(*bq_acc));
+}
+
+BIGZ_FN(cfun_BqBestApproximation,
+    "(bigz/bigq/best-approx q maxd)",
+    "Returns the bigq number closest to q whose denominator does not exceed "
+    "maxd, which can be an integer or a bigz number.")
+{
+    janet_fixarity(argc, 2);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigZ maxd;
+    BigQ q;
+    if (janet_checktype(argv[1], JANET_NUMBER)) {
+        maxd = BzFromInteger(janet_getinteger(argv, 1));
+    } else {
+        maxd = BzCopy(*(BigZ *)janet_getabstract(argv, 1, &janet_bigz_type));
+    }
+    if (maxd == BZNULL) {
+        janet_panic("out of memory");
+    }
+    if (BzGetSign(maxd) != BZ_PLUS) {
+        BzFree(maxd);
+        janet_panic("maxd must be positive");
+    }
+    q = BqBestApproximation(*bq_q, maxd);
+    BzFree(maxd);
+    return bigq_wrap(q);
+}
+
+BIGZ_FN(cfun_BqContinuedFraction,
+    "(bigz/bigq/continued-fraction q)",
+    "Returns a lazy continued fraction expansion of the bigq number q. "
+    "Terms are computed one at a time by bigq/cf-next.")
+{
+    janet_fixarity(argc, 1);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigQCF cf = BqCFCreate(*bq_q);
+    if (cf == BQCFNULL) {
+        janet_panic("out of memory");
+    }
+    BigQCF *bq_cf = janet_abstract(&janet_bigq_cf_type, sizeof(BigQCF));
+    *bq_cf = cf;
+    return janet_wrap_abstract(bq_cf);
+}
+
+BIGZ_FN(cfun_BqCFNext,
+    "(bigz/bigq/cf-next cf)",
+    "Computes the next term of a continued fraction expansion. Returns a "
+    "tuple [a p q] of bigz numbers, where a is the partial quotient and p/q "
+    "the corresponding convergent, or nil when the expansion is complete.")
+{
+    janet_fixarity(argc, 1);
+    BigQCF *bq_cf = janet_getabstract(argv, 0, &janet_bigq_cf_type);
+    switch (BqCFNext(*bq_cf)) {
+    case 0:
+        return janet_wrap_nil();
+    case 1:
+        break;
+    default:
+        janet_panic("out of memory");
+    }
+    Janet *tuple = janet_tuple_begin(3);
+    tuple[0] = bigz_wrap_copy(BqCFGetTerm(*bq_cf));
+    tuple[1] = bigz_wrap_copy(BqCFGetNumerator(*bq_cf));
+    tuple[2] = bigz_wrap_copy(BqCFGetDenominator(*bq_cf));
+    return janet_wrap_tuple(janet_tuple_end(tuple));
+}
+
+BIGZ_FN(cfun_BfFromBigZ,
+    "(bigz/bigf/from-bigz z &opt prec)",
+    "Converts a bigz number into a bigf floating-point number with prec "
+    "bits of precision (default 128), rounding to nearest, ties to even.")
+{
+    janet_arity(argc, 1, 2);
+    BigZ *bz_z = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigNumLength prec = bigf_optprecision(argv, argc, 1);
+    return bigf_wrap(BfFromBigZ(*bz_z, prec));
+}
+
+BIGZ_FN(cfun_BfFromBigQ,
+    "(bigz/bigf/from-bigq q &opt prec)",
+    "Converts a bigq rational number into the nearest bigf floating-point "
+    "number with prec bits of precision (default 128).")
+{
+    janet_arity(argc, 1, 2);
+    BigQ *bq_q = janet_getabstract(argv, 0, &janet_bigq_type);
+    BigNumLength prec = bigf_optprecision(argv, argc, 1);
+    return bigf_wrap(BfFromBigQ(*bq_q, prec));
+}
+
+BIGZ_FN(cfun_BfFromDouble,
+    "(bigz/bigf/from-double x &opt prec)",
+    "Converts a double into a bigf floating-point number with prec bits of "
+    "precision (default 128). The conversion is exact when prec is at "
+    "least 53.")
+{
+    janet_arity(argc, 1, 2);
+    double x = janet_getnumber(argv, 0);
+    BigNumLength prec = bigf_optprecision(argv, argc, 1);
+    BigF f = BfFromDouble(x, prec);
+    if (f == BFNULL) {
+        janet_panic("cannot convert number to bigf");
+    }
+    return bigf_wrap(f);
+}
+
+BIGZ_FN(cfun_BfFromString,
+    "(bigz/bigf/from-string s &opt prec)",
+    "Converts a decimal string such as \"-1.25e-3\" into the nearest bigf "
+    "floating-point number with prec bits of precision (default 128).")
+{
+    janet_arity(argc, 1, 2);
+    const BzChar *s = (const BzChar *)janet_getcstring(argv, 0);
+    BigNumLength prec = bigf_optprecision(argv, argc, 1);
+    BigF f = BfFromString(s, prec);
+    if (f == BFNULL) {
+        janet_panic("invalid floating-point number");
+    }
+    return bigf_wrap(f);
+}
+
+BIGZ_FN(cfun_BfToString,
+    "(bigz/bigf/to-string f &opt digits)",
+    "Converts a bigf floating-point number to a decimal string with at most "
+    "digits significant digits, rounded to nearest. By default, enough "
+    "digits are used to tell f apart from its neighbours at its precision.")
+{
+    janet_arity(argc, 1, 2);
+    BigF *bf_f = janet_getabstract(argv, 0, &janet_bigf_type);
+    BigNumLength digits = janet_optnat(argv, argc, 1, 0);
+    BzChar *f_str = BfToString(*bf_f, digits);
+    if (f_str == NULL) {
+        janet_panic("out of memory");
+    }
+    Janet result = janet_cstringv(f_str);
+    BzFreeString(f_str);
+    return result;
+}
+
+BIGZ_FN(cfun_BfToDouble,
+    "(bigz/bigf/to-double f)",
+    "Converts a bigf floating-point number into the nearest double.")
+{
+    janet_fixarity(argc, 1);
+    BigF *bf_f = janet_getabstract(argv, 0, &janet_bigf_type);
+    return janet_wrap_number(BfToDouble(*bf_f));
+}
+
+BIGZ_FN(cfun_BfToBigQ,
+    "(bigz/bigf/to-bigq f)",
+    "Returns the exact value of a bigf floating-point number as a bigq "
+    "rational number.")
+{
+    janet_fixarity(argc, 1);
+    BigF *bf_f = janet_getabstract(argv, 0, &janet_bigf_type);
+    return bigq_wrap(BfToBigQ(*bf_f));
+}
+
+BIGZ_FN(cfun_BfAdd,
+    "(bigz/bigf/add a b)",
+    "Returns the sum of two bigf floating-point numbers, rounded to the "
+    "larger of their precisions.")
+{
+    janet_fixarity(argc, 2);
+    BigF *bf_a = janet_getabstract(argv, 0, &janet_bigf_type);
+    BigF *bf_b = janet_getabstract(argv, 1, &janet_bigf_type);
+    return bigf_wrap(BfAdd(*bf_a, *bf_b));
+}
+
+BIGZ_FN(cfun_BfSubtract,
+    "(bigz/bigf/subtract a b)",
+    "Returns the difference between two bigf floating-point numbers, "
+    "rounded to the larger of their precisions.")
+{
+    janet_fixarity(argc, 2);
+    BigF *bf_a = janet_getabstract(argv, 0, &janet_bigf_type);
+    BigF *bf_b = janet_getabstract(argv, 1, &janet_bigf_type);
+    return bigf_wrap(BfSubtract(*bf_a, *bf_b));
+}
+
+BIGZ_FN(cfun_BfMultiply,
+    "(bigz/bigf/multiply a b)",
+    "Returns the product of two bigf floating-point numbers, rounded to the "
+    "larger of their precisions.")
+{
+    janet_fixarity(argc, 2);
+    BigF *bf_a = janet_getabstract(argv, 0, &janet_bigf_type);
+    BigF *bf_b = janet_getabstract(argv, 1, &janet_bigf_type);
+    bigf_check_exponents(BfGetExponent(*bf_a), BfGetExponent(*bf_b), 0);
+    return bigf_wrap(BfMultiply(*bf_a, *bf_b));
+}
+
+BIGZ_FN(cfun_BfDiv,
+    "(bigz/bigf/div a b)",
+    "Returns the quotient of two bigf floating-point numbers, rounded to "
+    "the larger of their precisions.")
+{
+    janet_fixarity(argc, 2);
+    BigF *bf_a = janet_getabstract(argv, 0, &janet_bigf_type);
+    BigF *bf_b = janet_getabstract(argv, 1, &janet_bigf_type);
+    if (BfGetSign(*bf_b) == BZ_ZERO) {
+        janet_panic("division by zero");
+    }
+    bigf_check_exponents(BfGetExponent(*bf_a), BfGetExponent(*bf_b), 1);
+    return bigf_wrap(BfDiv(*bf_a, *bf_b));
+}
+
+BIGZ_FN(cfun_BfSqrt,
+    "(bigz/bigf/sqrt f)",
+    "Returns the square root of a bigf floating-point number, rounded to "
+    "its precision.")
+{
+    janet_fixarity(argc, 1);
+    BigF *bf_f = janet_getabstract(argv, 0, &janet_bigf_type);
+    if (BfGetSign(*bf_f) == BZ_MINUS) {
+        janet_panic("square root of negative number");
+    }
+    return bigf_wrap(BfSqrt(*bf_f));
+}
+
+BIGZ_FN(cfun_BfNegate,
+    "(bigz/bigf/negate f)",
+    "Negates a bigf floating-point number.")
+{
+    janet_fixarity(argc, 1);
+    BigF *bf_f = janet_getabstract(argv, 0, &janet_bigf_type);
+    return bigf_wrap(BfNegate(*bf_f));
+}
+
+BIGZ_FN(cfun_BfAbs,
+    "(bigz/bigf/abs f)",
+    "Returns the absolute value of a bigf floating-point number.")
+{
+    janet_fixarity(argc, 1);
+    BigF *bf_f = janet_getabstract(argv, 0, &janet_bigf_type);
+    return bigf_wrap(BfAbs(*bf_f));
+}
+
+BIGZ_FN(cfun_BfCompare,
+    "(bigz/bigf/compare a b)",
+    "Compares two bigf floating-point numbers. Returns -1 if a is less than "
+    "b, 0 if a and b are equal, and 1 if a is greater than b.")
+{
+    janet_fixarity(argc, 2);
+    BigF *bf_a = janet_getabstract(argv, 0, &janet_bigf_type);
+    BigF *bf_b = janet_getabstract(argv, 1, &janet_bigf_type);
+    return janet_wrap_integer(bigf_compare(bf_a, bf_b));
+}
+
+BIGZ_FN(cfun_BfPrecision,
+    "(bigz/bigf/precision f)",
+    "Returns the precision, in bits, of a bigf floating-point number.")
+{
+    janet_fixarity(argc, 1);
+    BigF *bf_f = janet_getabstract(argv, 0, &janet_bigf_type);
+    return janet_wrap_number((double)BfGetPrecision(*bf_f));
+}
+
+BIGZ_FN(cfun_BfRound,
+    "(bigz/bigf/round f prec)",
+    "Rounds a bigf floating-point number to prec bits, to nearest with ties "
+    "to even. The result has precision prec, so it can also be used to "
+    "raise the precision of later operations.")
+{
+    janet_fixarity(argc, 2);
+    BigF *bf_f = janet_getabstract(argv, 0, &janet_bigf_type);
+    BigNumLength prec = bigf_optprecision(argv, argc, 1);
+    return bigf_wrap(BfRound(*bf_f, prec));
+}
+
+BIGZ_FN(cfun_BdCreate,
+    "(bigz/bigd/create c &opt scale)",
+    "Creates a bigd decimal number c * 10^-scale from a bigz coefficient c "
+    "and a scale (default 0), the number of digits after the decimal point.")
+{
+    janet_arity(argc, 1, 2);
+    BigZ *bz_c = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigNumLength scale = janet_optnat(argv, argc, 1, 0);
+    return bigd_wrap(BdCreate(*bz_c, scale));
+}
+
+BIGZ_FN(cfun_BdFromString,
+    "(bigz/bigd/from-string s)",
+    "Converts a string such as \"-12.50\" into a bigd decimal number. The "
+    "scale is the number of digits after the point, trailing zeros "
+    "included.")
+{
+    janet_fixarity(argc, 1);
+    BigD d = BdFromString((const BzChar *)janet_getcstring(argv, 0));
+    if (d == BDNULL) {
+        janet_panic("invalid decimal number");
+    }
+    return bigd_wrap(d);
+}
+
+BIGZ_FN(cfun_BdToString,
+    "(bigz/bigd/to-string d)",
+    "Converts a bigd decimal number to a string with exactly scale digits "
+    "after the decimal point.")
+{
+    janet_fixarity(argc, 1);
+    BigD *bd_d = janet_getabstract(argv, 0, &janet_bigd_type);
+    BzChar *d_str = BdToString(*bd_d);
+    if (d_str == NULL) {
+        janet_panic("out of memory");
+    }
+    Janet result = janet_cstringv(d_str);
+    BzFreeString(d_str);
+    return result;
+}
+
+BIGZ_FN(cfun_BdToDouble,
+    "(bigz/bigd/to-double d)",
+    "Converts a bigd decimal number into the nearest double.")
+{
+    janet_fixarity(argc, 1);
+    BigD *bd_d = janet_getabstract(argv, 0, &janet_bigd_type);
+    return janet_wrap_number(BdToDouble(*bd_d));
+}
+
+BIGZ_FN(cfun_BdToBigQ,
+    "(bigz/bigd/to-bigq d)",
+    "Returns the value of a bigd decimal number as a bigq rational number.")
+{
+    janet_fixarity(argc, 1);
+    BigD *bd_d = janet_getabstract(argv, 0, &janet_bigd_type);
+    return bigq_wrap(BdToBigQ(*bd_d));
+}
+
+BIGZ_FN(cfun_BdCoefficient,
+    "(bigz/bigd/coefficient d)",
+    "Returns the coefficient of a bigd decimal number as a bigz number.")
+{
+    janet_fixarity(argc, 1);
+    BigD *bd_d = janet_getabstract(argv, 0, &janet_bigd_type);
+    return bigz_wrap_copy(BdGetCoefficient(*bd_d));
+}
+
+BIGZ_FN(cfun_BdScale,
+    "(bigz/bigd/scale d)",
+    "Returns the scale of a bigd decimal number, the number of digits after "
+    "its decimal point.")
+{
+    janet_fixarity(argc, 1);
+    BigD *bd_d = janet_getabstract(argv, 0, &janet_bigd_type);
+    return janet_wrap_number((double)BdGetScale(*bd_d));
+}
+
+BIGZ_FN(cfun_BdAdd,
+    "(bigz/bigd/add a b)",
+    "Returns the exact sum of two bigd decimal numbers, at the larger of "
+    "their scales.")
+{
+    janet_fixarity(argc, 2);
+    BigD *bd_a = janet_getabstract(argv, 0, &janet_bigd_type);
+    BigD *bd_b = janet_getabstract(argv, 1, &janet_bigd_type);
+    return bigd_wrap(BdAdd(*bd_a, *bd_b));
+}
+
+BIGZ_FN(cfun_BdSubtract,
+    "(bigz/bigd/subtract a b)",
+    "Returns the exact difference between two bigd decimal numbers, at the "
+    "larger of their scales.")
+{
+    janet_fixarity(argc, 2);
+    BigD *bd_a = janet_getabstract(argv, 0, &janet_bigd_type);
+    BigD *bd_b = janet_getabstract(argv, 1, &janet_bigd_type);
+    return bigd_wrap(BdSubtract(*bd_a, *bd_b));
+}
+
+BIGZ_FN(cfun_BdMultiply,
+    "(bigz/bigd/multiply a b)",
+    "Returns the exact product of two bigd decimal numbers, whose scale is "
+    "the sum of their scales.")
+{
+    janet_fixarity(argc, 2);
+    BigD *bd_a = janet_getabstract(argv, 0, &janet_bigd_type);
+    BigD *bd_b = janet_getabstract(argv, 1, &janet_bigd_type);
+    return bigd_wrap(BdMultiply(*bd_a, *bd_b));
+}
+
+BIGZ_FN(cfun_BdDiv,
+    "(bigz/bigd/div a b scale &opt mode)",
+    "Returns the quotient of two bigd decimal numbers rounded to scale "
+    "digits after the point. See bigd/quantize for the rounding modes.")
+{
+    janet_arity(argc, 3, 4);
+    BigD *bd_a = janet_getabstract(argv, 0, &janet_bigd_type);
+    BigD *bd_b = janet_getabstract(argv, 1, &janet_bigd_type);
+    BigNumLength scale = janet_getnat(argv, 2);
+    BdRoundMode mode = bigd_optmode(argv, argc, 3);
+    if (BdGetSign(*bd_b) == BZ_ZERO) {
+        janet_panic("division by zero");
+    }
+    return bigd_wrap(BdDiv(*bd_a, *bd_b, scale, mode));
+}
+
+BIGZ_FN(cfun_BdQuantize,
+    "(bigz/bigd/quantize d scale &opt mode)",
+    "Rounds a bigd decimal number to scale digits after the point. mode is "
+    "one of :half-even (the default), :half-up, :down, :floor or :ceiling.")
+{
+    janet_arity(argc, 2, 3);
+    BigD *bd_d = janet_getabstract(argv, 0, &janet_bigd_type);
+    BigNumLength scale = janet_getnat(argv, 1);
+    BdRoundMode mode = bigd_optmode(argv, argc, 2);
+    return bigd_wrap(BdQuantize(*bd_d, scale, mode));
+}
+
+BIGZ_FN(cfun_BdNormalize,
+    "(bigz/bigd/normalize d)",
+    "Removes the trailing zeros after the decimal point of a bigd decimal "
+    "number.")
+{
+    janet_fixarity(argc, 1);
+    BigD *bd_d = janet_getabstract(argv, 0, &janet_bigd_type);
+    return bigd_wrap(BdNormalize(*bd_d));
+}
+
+BIGZ_FN(cfun_BdNegate,
+    "(bigz/bigd/negate d)",
+    "Negates a bigd decimal number.")
+{
+    janet_fixarity(argc, 1);
+    BigD *bd_d = janet_getabstract(argv, 0, &janet_bigd_type);
+    return bigd_wrap(BdNegate(*bd_d));
+}
+
+BIGZ_FN(cfun_BdAbs,
+    "(bigz/bigd/abs d)",
+    "Returns the absolute value of a bigd decimal number.")
+{
+    janet_fixarity(argc, 1);
+    BigD *bd_d = janet_getabstract(argv, 0, &janet_bigd_type);
+    return bigd_wrap(BdAbs(*bd_d));
+}
+
+BIGZ_FN(cfun_BdCompare,
+    "(bigz/bigd/compare a b)",
+    "Compares two bigd decimal numbers by value. Returns -1 if a is less "
+    "than b, 0 if a and b are equal, and 1 if a is greater than b.")
+{
+    janet_fixarity(argc, 2);
+    BigD *bd_a = janet_getabstract(argv, 0, &janet_bigd_type);
+    BigD *bd_b = janet_getabstract(argv, 1, &janet_bigd_type);
+    return janet_wrap_integer(bigd_compare(bd_a, bd_b));
+}
+
+BIGZ_FN(cfun_BmCtxCreate,
+    "(bigz/modctx n)",
+    "Creates a modular context for the bigz modulus n, which must be greater "
+    "than 1. The context holds the reduction constants and scratch space "
+    "shared by all the modint elements created in it, and must not be used "
+    "by two threads at the same time.")
+{
+    janet_fixarity(argc, 1);
+    BigZ *bz_n = janet_getabstract(argv, 0, &janet_bigz_type);
+    BigMCtx *mc_result;
+    BigMCtx ctx;
+    if (BzGetSign(*bz_n) != BZ_PLUS || BzLength(*bz_n) < 2) {
+        janet_panic("modulus must be greater than 1");
+    }
+    ctx = BmCtxCreate(*bz_n);
+    if (ctx == BMCTXNULL) {
+        janet_panic("out of memory");
+    }
+    mc_result = janet_abstract(&janet_modctx_type, sizeof(BigMCtx));
+    *mc_result = ctx;
+    return janet_wrap_abstract(mc_result);
+}
+
+BIGZ_FN(cfun_BmCtxModulus,
+    "(bigz/modctx/modulus ctx)",
+    "Returns the modulus of a modular context.")
+{
+    janet_fixarity(argc, 1);
+    BigMCtx *mc_ctx = janet_getabstract(argv, 0, &janet_modctx_type);
+    return bigz_wrap_copy(BmCtxGetModulus(*mc_ctx));
+}
+
+BIGZ_FN(cfun_BmCreate,
+    "(bigz/modint ctx z)",
+    "Returns the bigz z reduced modulo the modulus of ctx, as a modint "
+    "element of that context.")
+{
+    janet_fixarity(argc, 2);
+    BigMCtx *mc_ctx = janet_getabstract(argv, 0, &janet_modctx_type);
+    BigZ *bz_z = janet_getabstract(argv, 1, &janet_bigz_type);
+    return modint_wrap(BmCreate(*mc_ctx, *bz_z), mc_ctx);
+}
+
+BIGZ_FN(cfun_BmToBigZ,
+    "(bigz/modint/to-bigz m)",
+    "Returns the residue of a modint as a bigz between 0 and the modulus.")
+{
+    janet_fixarity(argc, 1);
+    ModInt *mi_m = janet_getabstract(argv, 0, &janet_modint_type);
+    BigZ *bz_result;
+    BigZ z = BmToBigZ(mi_m->m);
+    if (z == BZNULL) {
+        janet_panic("out of memory");
+    }
+    bz_result = janet_abstract(&janet_bigz_type, sizeof(BigZ *));
+    *bz_result = z;
+    return janet_wrap_abstract(bz_result);
+}
+
+BIGZ_FN(cfun_BmContext,
+    "(bigz/modint/context m)",
+    "Returns the modular context of a modint.")
+{
+    janet_fixarity(argc, 1);
+    ModInt *mi_m = janet_getabstract(argv, 0, &janet_modint_type);
+    return janet_wrap_abstract(mi_m->ctx);
+}
+
+BIGZ_FN(cfun_BmAdd,
+    "(bigz/modint/add a b)",
+    "Returns a + b for two modints of the same context.")
+{
+    janet_fixarity(argc, 2);
+    ModInt *mi_b;
+    ModInt *mi_a = modint_get2(argv, &mi_b);
+    return modint_wrap(BmAdd(mi_a->m, mi_b->m), mi_a->ctx);
+}
+
+BIGZ_FN(cfun_BmSubtract,
+    "(bigz/modint/subtract a b)",
+    "Returns a - b for two modints of the same context.")
+{
+    janet_fixarity(argc, 2);
+    ModInt *mi_b;
+    ModInt *mi_a = modint_get2(argv, &mi_b);
+    return modint_wrap(BmSubtract(mi_a->m, mi_b->m), mi_a->ctx);
+}
+
+BIGZ_FN(cfun_BmMultiply,
+    "(bigz/modint/multiply a b)",
+    "Returns a * b for two modints of the same context. Odd moduli use "
+    "Montgomery multiplication, even moduli Barrett reduction.")
+{
+    janet_fixarity(argc, 2);
+    ModInt *mi_b;
+    ModInt *mi_a = modint_get2(argv, &mi_b);
+    return modint_wrap(BmMultiply(mi_a->m, mi_b->m), mi_a->ctx);
+}
+
+BIGZ_FN(cfun_BmNegate,
+    "(bigz/modint/negate m)",
+    "Returns -m.")
+{
+    janet_fixarity(argc, 1);
+    ModInt *mi_m = janet_getabstract(argv, 0, &janet_modint_type);
+    return modint_wrap(BmNegate(mi_m->m), mi_m->ctx);
+}
+
+BIGZ_FN(cfun_BmInverse,
+    "(bigz/modint/inverse m)",
+    "Returns the multiplicative inverse of m. Raises an error if m and the "
+    "modulus are not coprime.")
+{
+    janet_fixarity(argc, 1);
+    ModInt *mi_m = janet_getabstract(argv, 0, &janet_modint_type);
+    BigM r = BmInverse(mi_m->m);
+    if (r == BMNULL) {
+        janet_panic("not invertible");
+    }
+    return modint_wrap(r, mi_m->ctx);
+}
+
+BIGZ_FN(cfun_BmPow,
+    "(bigz/modint/pow m e)",
+    "Returns m raised to the power of the bigz e. A negative e raises the "
+    "inverse of m, and is an error if m is not invertible.")
+{
+    janet_fixarity(argc, 2);
+    ModInt *mi_m = janet_getabstract(argv, 0, &janet_modint_type);
+    BigZ *bz_e = janet_getabstract(argv, 1, &janet_bigz_type);
+    BigM r = BmPow(mi_m->m, *bz_e);
+    if (r == BMNULL) {
+        janet_panic(BzGetSign(*bz_e) == BZ_MINUS ? "not invertible" : "out of memory");
+    }
+    return modint_wrap(r, mi_m->ctx);
+}
+
 JANET_MODULE_ENTRY(JanetTable *env) {
     // janet_cfuns(env, "bigz", cfuns);
     JanetRegExt cfuns[] = {
@@ -620,9 +3059,25 @@ JANET_MODULE_ENTRY(JanetTable *env) {
         JANET_REG("to-double", cfun_BzToDouble),
         JANET_REG("test-bit", cfun_BzTestBit),
         JANET_REG("bit-count", cfun_BzBitCount),
+        JANET_REG("scan0", cfun_BzScan0),
+        JANET_REG("scan1", cfun_BzScan1),
+        JANET_REG("lowest-set-bit", cfun_BzLowestSetBit),
+        JANET_REG("set-bit", cfun_BzSetBit),
+        JANET_REG("clear-bit", cfun_BzClearBit),
+        JANET_REG("flip-bit", cfun_BzFlipBit),
+        JANET_REG("extract-bits", cfun_BzExtractBits),
+        JANET_REG("deposit-bits", cfun_BzDepositBits),
+        JANET_REG("mutable", cfun_BzMutable),
+        JANET_REG("mutable-value", cfun_BzMutableValue),
+        JANET_REG("set-bit!", cfun_BzSetBitInPlace),
+        JANET_REG("clear-bit!", cfun_BzClearBitInPlace),
+        JANET_REG("flip-bit!", cfun_BzFlipBitInPlace),
+        JANET_REG("deposit-bits!", cfun_BzDepositBitsInPlace),
+        JANET_REG("ash!", cfun_BzAshInPlace),
         JANET_REG("not", cfun_BzNot),
         JANET_REG("and", cfun_BzAnd),
         JANET_REG("or", cfun_BzOr),
+        JANET_REG("xor", cfun_BzXor),
         JANET_REG("nand", cfun_BzNand),
         JANET_REG("nor", cfun_BzNor),
         JANET_REG("eqv", cfun_BzEqv),
@@ -630,6 +3085,7 @@ JANET_MODULE_ENTRY(JanetTable *env) {
         JANET_REG("and-c2", cfun_BzAndC2),
         JANET_REG("or-c1", cfun_BzOrC1),
         JANET_REG("or-c2", cfun_BzOrC2),
+        JANET_REG("boole", cfun_BzBoole),
         JANET_REG("ash", cfun_BzAsh),
         JANET_REG("sqrt", cfun_BzSqrt),
         JANET_REG("lcm", cfun_BzLcm),
@@ -637,9 +3093,100 @@ JANET_MODULE_ENTRY(JanetTable *env) {
         JANET_REG("set-random-seed", cfun_set_random_seed),
         JANET_REG("get-random-seed", cfun_get_random_seed),
         JANET_REG("random", cfun_BzRandom),
+        JANET_REG("random-bits", cfun_BzRandomBits),
+        JANET_REG("random-secure", cfun_BzRandomSecure),
+        JANET_REG("rng", cfun_BzRng),
+        JANET_REG("rng/seed", cfun_BzRngSeed),
+        JANET_REG("rng/jump", cfun_BzRngJump),
+        JANET_REG("rng/split", cfun_BzRngSplit),
         JANET_REG("mod-exp", cfun_BzModExp),
+        JANET_REG("set-threads", cfun_BzSetThreads),
+        JANET_REG("get-threads", cfun_BzGetThreads),
+        JANET_REG("set-stats", cfun_set_stats),
+        JANET_REG("stats", cfun_stats),
+        JANET_REG("stats-reset", cfun_stats_reset),
+#ifdef JANET_EV
+        JANET_REG("async", cfun_BzAsync),
+#endif
+        JANET_REG("bigq/create", cfun_BqCreate),
+        JANET_REG("bigq/from-bigz", cfun_BqFromBigZ),
+        JANET_REG("bigq/from-string", cfun_BqFromString),
+        JANET_REG("bigq/from-double", cfun_BqFromDouble),
+        JANET_REG("bigq/to-string", cfun_BqToString),
+        JANET_REG("bigq/to-double", cfun_BqToDouble),
+        JANET_REG("bigq/numerator", cfun_BqNumerator),
+        JANET_REG("bigq/denominator", cfun_BqDenominator),
+        JANET_REG("bigq/add", cfun_BqAdd),
+        JANET_REG("bigq/subtract", cfun_BqSubtract),
+        JANET_REG("bigq/multiply", cfun_BqMultiply),
+        JANET_REG("bigq/div", cfun_BqDiv),
+        JANET_REG("bigq/negate", cfun_BqNegate),
+        JANET_REG("bigq/abs", cfun_BqAbs),
+        JANET_REG("bigq/inverse", cfun_BqInverse),
+        JANET_REG("bigq/compare", cfun_BqCompare),
+        JANET_REG("bigq/acc-create", cfun_BqAccCreate),
+        JANET_REG("bigq/acc-add", cfun_BqAccAdd),
+        JANET_REG("bigq/acc-subtract", cfun_BqAccSubtract),
+        JANET_REG("bigq/acc-multiply", cfun_BqAccMultiply),
+        JANET_REG("bigq/acc-value", cfun_BqAccValue),
+        JANET_REG("bigq/best-approx", cfun_BqBestApproximation),
+        JANET_REG("bigq/continued-fraction", cfun_BqContinuedFraction),
+        JANET_REG("bigq/cf-next", cfun_BqCFNext),
+        JANET_REG("bigf/from-bigz", cfun_BfFromBigZ),
+        JANET_REG("bigf/from-bigq", cfun_BfFromBigQ),
+        JANET_REG("bigf/from-double", cfun_BfFromDouble),
+        JANET_REG("bigf/from-string", cfun_BfFromString),
+        JANET_REG("bigf/to-string", cfun_BfToString),
+        JANET_REG("bigf/to-double", cfun_BfToDouble),
+        JANET_REG("bigf/to-bigq", cfun_BfToBigQ),
+        JANET_REG("bigf/add", cfun_BfAdd),
+        JANET_REG("bigf/subtract", cfun_BfSubtract),
+        JANET_REG("bigf/multiply", cfun_BfMultiply),
+        JANET_REG("bigf/div", cfun_BfDiv),
+        JANET_REG("bigf/sqrt", cfun_BfSqrt),
+        JANET_REG("bigf/negate", cfun_BfNegate),
+        JANET_REG("bigf/abs", cfun_BfAbs),
+        JANET_REG("bigf/compare", cfun_BfCompare),
+        JANET_REG("bigf/precision", cfun_BfPrecision),
+        JANET_REG("bigf/round", cfun_BfRound),
+        JANET_REG("bigd/create", cfun_BdCreate),
+        JANET_REG("bigd/from-string", cfun_BdFromString),
+        JANET_REG("bigd/to-string", cfun_BdToString),
+        JANET_REG("bigd/to-double", cfun_BdToDouble),
+        JANET_REG("bigd/to-bigq", cfun_BdToBigQ),
+        JANET_REG("bigd/coefficient", cfun_BdCoefficient),
+        JANET_REG("bigd/scale", cfun_BdScale),
+        JANET_REG("bigd/add", cfun_BdAdd),
+        JANET_REG("bigd/subtract", cfun_BdSubtract),
+        JANET_REG("bigd/multiply", cfun_BdMultiply),
+        JANET_REG("bigd/div", cfun_BdDiv),
+        JANET_REG("bigd/quantize", cfun_BdQuantize),
+        JANET_REG("bigd/normalize", cfun_BdNormalize),
+        JANET_REG("bigd/negate", cfun_BdNegate),
+        JANET_REG("bigd/abs", cfun_BdAbs),
+        JANET_REG("bigd/compare", cfun_BdCompare),
+        JANET_REG("modctx", cfun_BmCtxCreate),
+        JANET_REG("modctx/modulus", cfun_BmCtxModulus),
+        JANET_REG("modint", cfun_BmCreate),
+        JANET_REG("modint/to-bigz", cfun_BmToBigZ),
+        JANET_REG("modint/context", cfun_BmContext),
+        JANET_REG("modint/add", cfun_BmAdd),
+        JANET_REG("modint/subtract", cfun_BmSubtract),
+        JANET_REG("modint/multiply", cfun_BmMultiply),
+        JANET_REG("modint/negate", cfun_BmNegate),
+        JANET_REG("modint/inverse", cfun_BmInverse),
+        JANET_REG("modint/pow", cfun_BmPow),
         JANET_REG_END
     };
     janet_cfuns_ext(env, "bigz", cfuns);
     janet_register_abstract_type(&janet_bigz_type);
+    janet_register_abstract_type(&janet_bigz_mutable_type);
+    janet_register_abstract_type(&janet_bigq_type);
+    janet_register_abstract_type(&janet_bigq_acc_type);
+    janet_register_abstract_type(&janet_bigq_cf_type);
+    janet_register_abstract_type(&janet_bigf_type);
+    janet_register_abstract_type(&janet_bigd_type);
+    janet_register_abstract_type(&janet_modctx_type);
+    janet_register_abstract_type(&janet_modint_type);
+    janet_register_abstract_type(&janet_rng_type);
 }